@@ -154,7 +154,7 @@ endfunction()
 #! mo2_find_esptk : find and create a mo2::esptk target
 #
 function(mo2_find_esptk)
-    mo2_find_corelib(esptk)
+    mo2_find_corelib(esptk DEPENDS zlib)
 endfunction()
 
 #! mo2_find_archive : find and create a mo2::archive target
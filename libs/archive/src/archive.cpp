@@ -28,10 +28,13 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "propertyvariant.h"
 
 #include <algorithm>
+#include <chrono>
 #include <map>
+#include <mutex>
 #include <sstream>
 #include <stddef.h>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -93,6 +96,11 @@ public:
     m_LogCallback = logCallback ? logCallback : DefaultLogCallback;
   }
 
+  virtual void setDecodeThreadCount(unsigned int threadCount) override
+  {
+    m_DecodeThreadCount = threadCount;
+  }
+
   virtual bool open(std::wstring const& archiveName,
                     PasswordCallback passwordCallback) override;
   virtual void close() override;
@@ -102,6 +110,11 @@ public:
                        FileChangeCallback fileChangeCallback,
                        ErrorCallback errorCallback) override;
 
+  virtual ExtractionStats getExtractionStats() const override
+  {
+    return m_ExtractionStats;
+  }
+
   virtual void cancel() override;
 
 private:
@@ -110,6 +123,8 @@ private:
 
   HRESULT loadFormats();
 
+  void setDecodeThreads();
+
 private:
   typedef UINT32(WINAPI* CreateObjectFunc)(const GUID* clsID, const GUID* interfaceID,
                                            void** outObject);
@@ -133,15 +148,21 @@ private:
   ALibrary m_Library;
   std::wstring m_ArchiveName;  // TBH I don't think this is required
   CComPtr<IInArchive> m_ArchivePtr;
+
+  // only set during extract(), the mutex allows cancel() from any thread
   CArchiveExtractCallback* m_ExtractCallback;
+  std::mutex m_ExtractCallbackMutex;
 
   LogCallback m_LogCallback;
   PasswordCallback m_PasswordCallback;
+  unsigned int m_DecodeThreadCount;
 
   std::vector<FileData*> m_FileList;
 
   std::wstring m_Password;
 
+  ExtractionStats m_ExtractionStats;
+
   struct ArchiveFormatInfo
   {
     CLSID m_ClassID;
@@ -270,7 +291,7 @@ HRESULT ArchiveImpl::loadFormats()
 
 ArchiveImpl::ArchiveImpl()
     : m_Valid(false), m_LastError(Error::ERROR_NONE), m_Library("dlls/7z"),
-      m_PasswordCallback{}
+      m_ExtractCallback(nullptr), m_PasswordCallback{}, m_DecodeThreadCount(1)
 {
   // Reset the log callback:
   setLogCallback({});
@@ -519,10 +540,41 @@ bool ArchiveImpl::open(std::wstring const& archiveName,
 
   m_LastError = Error::ERROR_NONE;
 
+  setDecodeThreads();
+
   resetFileList();
   return true;
 }
 
+void ArchiveImpl::setDecodeThreads()
+{
+  // handlers that take properties (7z for example) decode with several threads when
+  // the codec allows it, like LZMA2 streams that were compressed in blocks; the
+  // thread count is always set since some handlers use all the cores by default
+  CComPtr<ISetProperties> setProperties;
+  if (m_ArchivePtr->QueryInterface(IID_ISetProperties, (void**)&setProperties) !=
+      S_OK) {
+    return;
+  }
+
+  const uint32_t threadCount =
+      m_DecodeThreadCount != 0
+          ? m_DecodeThreadCount
+          : std::max(std::thread::hardware_concurrency(), 1u);
+
+  const wchar_t* names[] = {L"mt"};
+  PropertyVariant values[1];
+  values[0] = threadCount;
+
+  if (setProperties->SetProperties(names, values, 1) != S_OK) {
+    m_LogCallback(LogLevel::Debug,
+                  L"This archive format does not support multi-threaded decoding.");
+  } else {
+    m_LogCallback(LogLevel::Debug,
+                  std::format(L"Decoding with up to {} threads.", threadCount));
+  }
+}
+
 void ArchiveImpl::close()
 {
   if (m_ArchivePtr != nullptr) {
@@ -562,6 +614,9 @@ bool ArchiveImpl::extract(std::wstring const& outputDirectory,
                           ErrorCallback errorCallback)
 
 {
+  const auto start  = std::chrono::steady_clock::now();
+  m_ExtractionStats = {};
+
   // Retrieve the list of indices we want to extract:
   std::vector<UInt32> indices;
   UInt64 totalSize = 0;
@@ -573,13 +628,31 @@ bool ArchiveImpl::extract(std::wstring const& outputDirectory,
     }
   }
 
-  m_ExtractCallback = new CArchiveExtractCallback(
+  // Extract() would delete the callback when it's done, the counters are needed after
+  CComPtr<CArchiveExtractCallback> extractCallback(new CArchiveExtractCallback(
       progressCallback, fileChangeCallback, errorCallback, m_PasswordCallback,
       m_LogCallback, m_ArchivePtr, outputDirectory, &m_FileList[0], m_FileList.size(),
-      totalSize, &m_Password);
-  HRESULT result = m_ArchivePtr->Extract(
-      indices.data(), static_cast<UInt32>(indices.size()), false, m_ExtractCallback);
-  // Note: m_ExtractCallBack is deleted by Extract
+      totalSize, &m_Password));
+
+  {
+    std::scoped_lock lock(m_ExtractCallbackMutex);
+    m_ExtractCallback = extractCallback;
+  }
+
+  const auto extractStart = std::chrono::steady_clock::now();
+  HRESULT result          = m_ArchivePtr->Extract(
+      indices.data(), static_cast<UInt32>(indices.size()), false, extractCallback);
+  const auto extracted = std::chrono::steady_clock::now();
+
+  m_ExtractionStats = extractCallback->GetStats(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(extracted - start),
+      std::chrono::duration_cast<std::chrono::nanoseconds>(extracted - extractStart));
+
+  {
+    std::scoped_lock lock(m_ExtractCallbackMutex);
+    m_ExtractCallback = nullptr;
+  }
+
   switch (result) {
   case S_OK: {
     // nop
@@ -600,7 +673,10 @@ bool ArchiveImpl::extract(std::wstring const& outputDirectory,
 
 void ArchiveImpl::cancel()
 {
-  m_ExtractCallback->SetCanceled(true);
+  std::scoped_lock lock(m_ExtractCallbackMutex);
+  if (m_ExtractCallback != nullptr) {
+    m_ExtractCallback->SetCanceled(true);
+  }
 }
 
 std::unique_ptr<Archive> CreateArchive()
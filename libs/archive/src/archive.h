@@ -21,10 +21,12 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef ARCHIVE_H
 #define ARCHIVE_H
 
+#include <chrono>
 #include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #ifndef DLLEXPORT
 #ifdef MODORGANIZER_ARCHIVE_BUILDING
@@ -124,6 +126,56 @@ public:  // Declarations
 
   static constexpr int MAX_PASSWORD_LENGTH = 256;
 
+  /**
+   * Counters collected during an extraction, to find out where the time goes.
+   *
+   * All the times are measured on the thread that decodes the archive, create,
+   * write, close, callbacks and decode do not overlap with each other.
+   */
+  struct ExtractionStats
+  {
+    // Number of entries extracted and of files created for them.
+    uint64_t entries = 0;
+    uint64_t files   = 0;
+
+    // Uncompressed bytes produced by the decoder, including entries that were not
+    // extracted but had to be decoded anyway (solid archives), and bytes of the
+    // extracted entries, counted once even if an entry is written to several files.
+    uint64_t bytesDecoded = 0;
+    uint64_t bytesWritten = 0;
+
+    // Time spent in extract().
+    std::chrono::nanoseconds total{0};
+
+    // Time spent decoding, i.e. not handling the decoded data.
+    std::chrono::nanoseconds decode{0};
+
+    // Time spent creating the output files and writing to them.
+    std::chrono::nanoseconds create{0};
+    std::chrono::nanoseconds write{0};
+
+    // Time spent closing the output files.
+    std::chrono::nanoseconds close{0};
+
+    // Time spent in the progress and file change callbacks.
+    std::chrono::nanoseconds callbacks{0};
+
+    ExtractionStats& operator+=(ExtractionStats const& other)
+    {
+      entries += other.entries;
+      files += other.files;
+      bytesDecoded += other.bytesDecoded;
+      bytesWritten += other.bytesWritten;
+      total += other.total;
+      decode += other.decode;
+      create += other.create;
+      write += other.write;
+      close += other.close;
+      callbacks += other.callbacks;
+      return *this;
+    }
+  };
+
   /**
    * List of callbacks:
    */
@@ -180,6 +232,17 @@ public:
    */
   virtual void setLogCallback(LogCallback logCallback) = 0;
 
+  /**
+   * @brief Set the number of threads used to decode the archives opened afterwards.
+   *
+   * Only some formats can be decoded with several threads. Archives are decoded with
+   * a single thread by default, since using all the cores is only worth it when the
+   * user is waiting for the extraction.
+   *
+   * @param threadCount The number of threads, or 0 for one thread per core.
+   */
+  virtual void setDecodeThreadCount(unsigned int threadCount) = 0;
+
   /**
    * @brief Open the given archive.
    *
@@ -224,8 +287,16 @@ public:
                        FileChangeCallback fileChangeCallback,
                        ErrorCallback errorCallback) = 0;
 
+  /**
+   * @return the counters of the last extraction, they are reset when an extraction
+   *     starts.
+   */
+  virtual ExtractionStats getExtractionStats() const = 0;
+
   /**
    * @brief Cancel the current extraction process.
+   *
+   * This can be called from any thread, and does nothing if no extraction is running.
    */
   virtual void cancel() = 0;
 
@@ -20,6 +20,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include <Unknwn.h>
 
+#include <algorithm>
 #include <filesystem>
 #include <format>
 #include <stdexcept>
@@ -83,25 +84,35 @@ CArchiveExtractCallback::CArchiveExtractCallback(
       m_LastCallbackFileSize(0), m_ProgressCallback(progressCallback),
       m_FileChangeCallback(fileChangeCallback), m_ErrorCallback(errorCallback),
       m_PasswordCallback(passwordCallback), m_LogCallback(logCallback),
-      m_Password(password)
+      m_Password(password), m_BytesDecoded(0), m_EntriesExtracted(0),
+      m_FilesCreated(0)
 {
   m_DirectoryPath = IO::make_path(directoryPath);
 }
 
-CArchiveExtractCallback::~CArchiveExtractCallback()
+CArchiveExtractCallback::~CArchiveExtractCallback() {}
+
+Archive::ExtractionStats
+CArchiveExtractCallback::GetStats(std::chrono::nanoseconds total,
+                                  std::chrono::nanoseconds extract) const
 {
-#ifdef INSTRUMENT_ARCHIVE
-  m_LogCallback(Archive::LogLevel::Debug, m_Timers.GetStream.toString(L"GetStream"));
-  m_LogCallback(Archive::LogLevel::Debug, m_Timers.SetOperationResult.SetMTime.toString(
-                                              L"SetOperationResult.SetMTime"));
-  m_LogCallback(Archive::LogLevel::Debug, m_Timers.SetOperationResult.Close.toString(
-                                              L"SetOperationResult.Close"));
-  m_LogCallback(Archive::LogLevel::Debug, m_Timers.SetOperationResult.Release.toString(
-                                              L"SetOperationResult.Release"));
-  m_LogCallback(Archive::LogLevel::Debug,
-                m_Timers.SetOperationResult.SetFileAttributesW.toString(
-                    L"SetOperationResult.SetFileAttributesW"));
-#endif
+  Archive::ExtractionStats stats;
+
+  stats.entries      = m_EntriesExtracted;
+  stats.files        = m_FilesCreated;
+  stats.bytesDecoded = m_BytesDecoded;
+  stats.bytesWritten = m_ExtractedFileSize;
+  stats.create       = m_Timers.Create.time();
+  stats.write        = m_Timers.Write.time();
+  stats.close        = m_Timers.Close.time();
+  stats.callbacks    = m_Timers.Callbacks.time();
+
+  // the decoding thread also spends time in the output streams
+  stats.total  = total;
+  stats.decode = std::max(extract - m_Timers.Handlers.time() - m_Timers.Write.time(),
+                          std::chrono::nanoseconds(0));
+
+  return stats;
 }
 
 STDMETHODIMP CArchiveExtractCallback::SetTotal(UInt64 size)
@@ -112,7 +123,16 @@ STDMETHODIMP CArchiveExtractCallback::SetTotal(UInt64 size)
 
 STDMETHODIMP CArchiveExtractCallback::SetCompleted(const UInt64* completed)
 {
+  auto guard = m_Timers.Handlers.instrument();
+
+  if (completed == nullptr) {
+    return m_Canceled ? E_ABORT : S_OK;
+  }
+
+  m_BytesDecoded = *completed;
+
   if (m_ProgressCallback) {
+    auto callbackGuard = m_Timers.Callbacks.instrument();
     m_ProgressCallback(Archive::ProgressType::ARCHIVE, *completed, m_Total);
   }
   return m_Canceled ? E_ABORT : S_OK;
@@ -153,7 +173,7 @@ STDMETHODIMP CArchiveExtractCallback::GetStream(UInt32 index,
                                                 ISequentialOutStream** outStream,
                                                 Int32 askExtractMode)
 {
-  auto guard   = m_Timers.GetStream.instrument();
+  auto guard   = m_Timers.Handlers.instrument();
   namespace fs = std::filesystem;
 
   *outStream = nullptr;
@@ -186,6 +206,8 @@ STDMETHODIMP CArchiveExtractCallback::GetStream(UInt32 index,
         getOptionalProperty(index, kpidMTime, &m_ProcessedFileInfo.MTime);
 
     if (m_ProcessedFileInfo.isDir) {
+      auto createGuard = m_Timers.Create.instrument();
+
       for (auto const& filename : filenames) {
         auto fullpath = m_DirectoryPath / fs::path(filename).make_preferred();
         std::error_code ec;
@@ -197,51 +219,68 @@ STDMETHODIMP CArchiveExtractCallback::GetStream(UInt32 index,
         m_FullProcessedPaths.push_back(fullpath);
       }
     } else {
-      for (auto const& filename : filenames) {
-        auto fullProcessedPath = m_DirectoryPath / fs::path(filename).make_preferred();
-        // If the filename contains a '/' we want to make the directory
-        auto directoryPath = fullProcessedPath.parent_path();
-        if (!fs::exists(directoryPath)) {
-          // Make the containing directory
-          std::error_code ec;
-          std::filesystem::create_directories(directoryPath, ec);
-          if (ec) {
-            reportError(L"cannot created directory '{}': {}", directoryPath, ec);
-            return E_ABORT;
+      m_OutputFileStream = new MultiOutputStream(
+          [this](UInt32 size, UInt64 totalSize) {
+            // called by Write() once the data is written, outside of the write
+            // timer
+            auto handlersGuard = m_Timers.Handlers.instrument();
+
+            m_ExtractedFileSize += size;
+            if (m_ProgressCallback) {
+              auto callbackGuard = m_Timers.Callbacks.instrument();
+              m_ProgressCallback(Archive::ProgressType::EXTRACTION, m_ExtractedFileSize,
+                                 m_TotalFileSize);
+            }
+          },
+          &m_Timers.Write);
+      CComPtr<MultiOutputStream> outStreamCom(m_OutputFileStream);
+
+      UInt64 fileSize;
+      auto fileSizeFound = getOptionalProperty(index, kpidSize, &fileSize);
+
+      {
+        // only the file system operations, the callbacks are timed on their own
+        auto createGuard = m_Timers.Create.instrument();
+
+        for (auto const& filename : filenames) {
+          auto fullProcessedPath =
+              m_DirectoryPath / fs::path(filename).make_preferred();
+
+          // If the filename contains a '/' we want to make the directory
+          auto directoryPath = fullProcessedPath.parent_path();
+          if (!fs::exists(directoryPath)) {
+            // Make the containing directory
+            std::error_code ec;
+            std::filesystem::create_directories(directoryPath, ec);
+            if (ec) {
+              reportError(L"cannot created directory '{}': {}", directoryPath, ec);
+              return E_ABORT;
+            }
+            // m_DirectoryPath.mkpath(filename.left(slashPos));
           }
-          // m_DirectoryPath.mkpath(filename.left(slashPos));
-        }
-        // If the file already exists, delete it
-        if (fs::exists(fullProcessedPath)) {
-          std::error_code ec;
-          if (!fs::remove(fullProcessedPath, ec)) {
-            reportError(L"cannot delete output file '{}': {}", fullProcessedPath, ec);
-            return E_ABORT;
+          // If the file already exists, delete it
+          if (fs::exists(fullProcessedPath)) {
+            std::error_code ec;
+            if (!fs::remove(fullProcessedPath, ec)) {
+              reportError(L"cannot delete output file '{}': {}", fullProcessedPath,
+                          ec);
+              return E_ABORT;
+            }
           }
+          m_FullProcessedPaths.push_back(fullProcessedPath);
         }
-        m_FullProcessedPaths.push_back(fullProcessedPath);
-      }
 
-      m_OutputFileStream = new MultiOutputStream([this](UInt32 size, UInt64 totalSize) {
-        m_ExtractedFileSize += size;
-        if (m_ProgressCallback) {
-          m_ProgressCallback(Archive::ProgressType::EXTRACTION, m_ExtractedFileSize,
-                             m_TotalFileSize);
+        if (!m_OutputFileStream->Open(m_FullProcessedPaths)) {
+          reportError(L"cannot open output file '{}': {}", m_FullProcessedPaths[0],
+                      ::GetLastError());
+          return E_ABORT;
         }
-      });
-      CComPtr<MultiOutputStream> outStreamCom(m_OutputFileStream);
-
-      if (!m_OutputFileStream->Open(m_FullProcessedPaths)) {
-        reportError(L"cannot open output file '{}': {}", m_FullProcessedPaths[0],
-                    ::GetLastError());
-        return E_ABORT;
-      }
 
-      UInt64 fileSize;
-      auto fileSizeFound = getOptionalProperty(index, kpidSize, &fileSize);
-      if (fileSizeFound && m_OutputFileStream->SetSize(fileSize) != S_OK) {
-        m_LogCallback(Archive::LogLevel::Error,
-                      std::format(L"SetSize() failed on {}.", m_FullProcessedPaths[0]));
+        if (fileSizeFound && m_OutputFileStream->SetSize(fileSize) != S_OK) {
+          m_LogCallback(
+              Archive::LogLevel::Error,
+              std::format(L"SetSize() failed on {}.", m_FullProcessedPaths[0]));
+        }
       }
 
       // This is messy but I can't find another way of doing it. A simple
@@ -249,9 +288,13 @@ STDMETHODIMP CArchiveExtractCallback::GetStream(UInt32 index,
       // reference count.
       m_OutFileStreamCom = outStreamCom;
       *outStream         = outStreamCom.Detach();
+
+      ++m_EntriesExtracted;
+      m_FilesCreated += m_FullProcessedPaths.size();
     }
 
     if (m_FileChangeCallback) {
+      auto callbackGuard = m_Timers.Callbacks.instrument();
       m_FileChangeCallback(Archive::FileChangeType::EXTRACTION_START, filenames[0]);
     }
 
@@ -274,26 +317,29 @@ STDMETHODIMP CArchiveExtractCallback::PrepareOperation(Int32 askExtractMode)
 
 STDMETHODIMP CArchiveExtractCallback::SetOperationResult(Int32 operationResult)
 {
+  auto guard = m_Timers.Handlers.instrument();
+
   if (operationResult != NArchive::NExtract::NOperationResult::kOK) {
     reportError(operationResultToString(operationResult));
   }
 
   if (m_OutFileStreamCom) {
+    auto closeGuard = m_Timers.Close.instrument();
+
     if (m_ProcessedFileInfo.MTimeDefined) {
-      auto guard = m_Timers.SetOperationResult.SetMTime.instrument();
       m_OutputFileStream->SetMTime(&m_ProcessedFileInfo.MTime);
     }
-    auto guard = m_Timers.SetOperationResult.Close.instrument();
-    RINOK(m_OutputFileStream->Close())
-  }
-
-  {
-    auto guard = m_Timers.SetOperationResult.Release.instrument();
+    if (m_OutputFileStream->Close() != S_OK) {
+      m_LogCallback(Archive::LogLevel::Error,
+                    std::format(L"Failed to close {}.", m_FullProcessedPaths[0]));
+      return E_FAIL;
+    }
     m_OutFileStreamCom.Release();
   }
 
-  auto guard = m_Timers.SetOperationResult.SetFileAttributesW.instrument();
   if (m_Extracting && m_ProcessedFileInfo.AttribDefined) {
+    auto closeGuard = m_Timers.Close.instrument();
+
     // this is moderately annoying. I can't do this on the file handle because if
     // the file in question is a directory there isn't a file handle.
     // Also I'd like to convert the attributes to QT attributes but I'm not sure
@@ -25,6 +25,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <chrono>
 #include <filesystem>
 #include <format>
+#include <vector>
 
 #include "7zip/Archive/IArchive.h"
 #include "7zip/IPassword.h"
@@ -61,6 +62,16 @@ public:
 
   void SetCanceled(bool aCanceled);
 
+  /**
+   * @brief Retrieve the counters of this extraction.
+   *
+   * @param total Time spent extracting.
+   * @param extract Time spent in IInArchive::Extract(), the decoding time is derived
+   *     from it.
+   */
+  Archive::ExtractionStats GetStats(std::chrono::nanoseconds total,
+                                    std::chrono::nanoseconds extract) const;
+
   Z7_IFACE_COM7_IMP(IProgress)
   Z7_IFACE_COM7_IMP(IArchiveExtractCallback)
 
@@ -76,6 +87,15 @@ private:
     reportError(std::format(format, std::forward<Args>(args)...));
   }
 
+  struct CProcessedFileInfo
+  {
+    FILETIME MTime;
+    UInt32 Attrib;
+    bool isDir;
+    bool AttribDefined;
+    bool MTimeDefined;
+  };
+
   template <typename T>
   bool getOptionalProperty(UInt32 index, int property, T* result) const;
   template <typename T>
@@ -90,26 +110,22 @@ private:
   bool m_Extracting;
   std::atomic<bool> m_Canceled;
 
+  // see Archive::ExtractionStats, Handlers is the time the decoding thread spent in
+  // this callback, which is not spent decoding
   struct
   {
-    ArchiveTimers::Timer GetStream;
-    struct
-    {
-      ArchiveTimers::Timer SetMTime;
-      ArchiveTimers::Timer Close;
-      ArchiveTimers::Timer Release;
-      ArchiveTimers::Timer SetFileAttributesW;
-    } SetOperationResult;
+    ArchiveTimers::Timer Handlers;
+    ArchiveTimers::Timer Create;
+    ArchiveTimers::Timer Write;
+    ArchiveTimers::Timer Close;
+    ArchiveTimers::Timer Callbacks;
   } m_Timers;
 
-  struct CProcessedFileInfo
-  {
-    FILETIME MTime;
-    UInt32 Attrib;
-    bool isDir;
-    bool AttribDefined;
-    bool MTimeDefined;
-  } m_ProcessedFileInfo;
+  UInt64 m_BytesDecoded;
+  UInt64 m_EntriesExtracted;
+  UInt64 m_FilesCreated;
+
+  CProcessedFileInfo m_ProcessedFileInfo;
 
   MultiOutputStream* m_OutputFileStream;
   CComPtr<MultiOutputStream> m_OutFileStreamCom;
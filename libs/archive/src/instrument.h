@@ -21,26 +21,23 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef ARCHIVE_INSTRUMENT_H
 #define ARCHIVE_INSTRUMENT_H
 
+#include <atomic>
 #include <chrono>
-#include <format>
+#include <cstdint>
 
 namespace ArchiveTimers
 {
 
-/**
- * If INSTRUMENT_ARCHIVE is not defined, we define a Timer() class that is empty and
- * does nothing, and thus should be optimized out by the compiler.
- */
-#ifdef INSTRUMENT_ARCHIVE
-
 /**
  * Small class that can be used to instrument portion of code using a guard.
  *
+ * Timers are always enabled, they only cost two reads of the clock and two atomic
+ * additions per call, and can be updated from several threads.
  */
 class Timer
 {
 public:
-  using clock_t = std::chrono::system_clock;
+  using clock_t = std::chrono::steady_clock;
 
   struct TimerGuard
   {
@@ -50,11 +47,7 @@ public:
     TimerGuard& operator=(TimerGuard const&) = delete;
     TimerGuard& operator=(TimerGuard&&)      = delete;
 
-    ~TimerGuard()
-    {
-      m_Timer.ncalls++;
-      m_Timer.time += clock_t::now() - m_Start;
-    }
+    ~TimerGuard() { m_Timer.add(clock_t::now() - m_Start); }
 
   private:
     TimerGuard(Timer& timer) : m_Timer{timer}, m_Start{clock_t::now()} {}
@@ -81,31 +74,34 @@ public:
    */
   TimerGuard instrument() { return {*this}; }
 
-  std::wstring toString(std::wstring const& name) const
+  /**
+   * @brief Add a duration measured elsewhere.
+   */
+  void add(clock_t::duration d)
   {
-    auto ms = [](auto&& t) {
-      return std::chrono::duration<double, std::milli>(t);
-    };
-    return std::format(
-        L"Instrument '{}': {} calls, total of {}ms, {:.3f}ms per call on average.",
-        name, ncalls, ms(time).count(), ms(time).count() / ncalls);
+    m_Calls.fetch_add(1, std::memory_order_relaxed);
+    m_Time.fetch_add(d.count(), std::memory_order_relaxed);
   }
 
-private:
-  std::size_t ncalls{0};
-  clock_t::duration time{0};
-};
+  /**
+   * @return the number of instrumented calls.
+   */
+  std::uint64_t calls() const { return m_Calls.load(std::memory_order_relaxed); }
 
-#else
+  /**
+   * @return the total time spent in the instrumented calls.
+   */
+  std::chrono::nanoseconds time() const
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        clock_t::duration(m_Time.load(std::memory_order_relaxed)));
+  }
 
-struct Timer
-{
-  // This is the only method needed:
-  Timer& instrument() { return *this; }
+private:
+  std::atomic<std::uint64_t> m_Calls{0};
+  std::atomic<clock_t::rep> m_Time{0};
 };
 
-#endif
-
 }  // namespace ArchiveTimers
 
 #endif
@@ -0,0 +1,283 @@
+/*
+Mod Organizer archive handling
+
+Copyright (C) 2020 MO2 Team. All rights reserved.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "memoryarchive.h"
+#include "instrument.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <system_error>
+
+namespace
+{
+
+uint32_t crc32(std::string const& data)
+{
+  static const auto table = [] {
+    std::array<uint32_t, 256> t{};
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; ++k) {
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      }
+      t[i] = c;
+    }
+    return t;
+  }();
+
+  uint32_t crc = 0xFFFFFFFFu;
+  for (unsigned char c : data) {
+    crc = table[(crc ^ c) & 0xFF] ^ (crc >> 8);
+  }
+
+  return crc ^ 0xFFFFFFFFu;
+}
+
+class MemoryFileData : public FileData
+{
+public:
+  MemoryFileData(MemoryArchiveEntry const& entry)
+      : m_Entry(entry), m_CRC(entry.isDirectory ? 0 : crc32(entry.content))
+  {}
+
+  std::wstring getArchiveFilePath() const override { return m_Entry.path; }
+
+  uint64_t getSize() const override
+  {
+    return m_Entry.isDirectory ? 0 : m_Entry.content.size();
+  }
+
+  void addOutputFilePath(std::wstring const& fileName) override
+  {
+    m_OutputFilePaths.push_back(fileName);
+  }
+
+  const std::vector<std::wstring>& getOutputFilePaths() const override
+  {
+    return m_OutputFilePaths;
+  }
+
+  void clearOutputFilePaths() override { m_OutputFilePaths.clear(); }
+
+  uint64_t getCRC() const override { return m_CRC; }
+  bool isDirectory() const override { return m_Entry.isDirectory; }
+
+  const std::string& content() const { return m_Entry.content; }
+
+private:
+  MemoryArchiveEntry const& m_Entry;
+  uint64_t m_CRC;
+  std::vector<std::wstring> m_OutputFilePaths;
+};
+
+class MemoryArchive : public Archive
+{
+public:
+  MemoryArchive(std::vector<MemoryArchiveEntry> entries)
+      : m_Entries(std::move(entries)), m_LastError(Error::ERROR_NONE),
+        m_Canceled(false)
+  {}
+
+  bool isValid() const override { return true; }
+  Error getLastError() const override { return m_LastError; }
+
+  void setLogCallback(LogCallback logCallback) override
+  {
+    m_LogCallback = logCallback;
+  }
+
+  // nothing to decode
+  void setDecodeThreadCount(unsigned int) override {}
+
+  bool open(std::wstring const& archivePath, PasswordCallback) override
+  {
+    close();
+
+    for (auto const& entry : m_Entries) {
+      m_Files.push_back(std::make_unique<MemoryFileData>(entry));
+      m_FileList.push_back(m_Files.back().get());
+    }
+
+    m_LastError = Error::ERROR_NONE;
+    log(LogLevel::Debug, L"Opened in-memory archive " + archivePath + L".");
+
+    return true;
+  }
+
+  void close() override
+  {
+    m_FileList.clear();
+    m_Files.clear();
+  }
+
+  const std::vector<FileData*>& getFileList() const override { return m_FileList; }
+
+  bool extract(std::wstring const& outputDirectory, ProgressCallback progressCallback,
+               FileChangeCallback fileChangeCallback,
+               ErrorCallback errorCallback) override
+  {
+    namespace fs = std::filesystem;
+
+    const auto start = std::chrono::steady_clock::now();
+    ArchiveTimers::Timer writeTimer, callbackTimer;
+
+    m_Canceled        = false;
+    m_ExtractionStats = {};
+
+    // nothing is decoded, the time spent outside of writing and callbacks is
+    // reported as decoding; creating files is part of writing
+    auto updateStats = [&] {
+      m_ExtractionStats.total = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start);
+      m_ExtractionStats.write     = writeTimer.time();
+      m_ExtractionStats.callbacks = callbackTimer.time();
+      m_ExtractionStats.decode =
+          std::max(m_ExtractionStats.total - writeTimer.time() - callbackTimer.time(),
+                   std::chrono::nanoseconds(0));
+    };
+
+    uint64_t total = 0;
+    for (auto* fileData : m_FileList) {
+      if (!fileData->getOutputFilePaths().empty()) {
+        total += fileData->getSize();
+      }
+    }
+
+    uint64_t extracted = 0;
+
+    for (auto& data : m_Files) {
+      if (data->getOutputFilePaths().empty()) {
+        continue;
+      }
+
+      if (m_Canceled) {
+        m_LastError = Error::ERROR_EXTRACT_CANCELLED;
+        updateStats();
+        return false;
+      }
+
+      if (fileChangeCallback) {
+        auto guard = callbackTimer.instrument();
+        fileChangeCallback(FileChangeType::EXTRACTION_START,
+                           data->getOutputFilePaths()[0]);
+      }
+
+      for (auto const& output : data->getOutputFilePaths()) {
+        const fs::path path = fs::path(outputDirectory) / fs::path(output);
+
+        bool written;
+        {
+          auto guard = writeTimer.instrument();
+          written    = write(path, *data);
+        }
+
+        if (!written) {
+          if (errorCallback) {
+            errorCallback(L"Failed to write " + path.wstring() + L".");
+          }
+          m_LastError = Error::ERROR_LIBRARY_ERROR;
+          updateStats();
+          return false;
+        }
+
+        ++m_ExtractionStats.files;
+      }
+
+      if (fileChangeCallback) {
+        auto guard = callbackTimer.instrument();
+        fileChangeCallback(FileChangeType::EXTRACTION_END,
+                           data->getOutputFilePaths()[0]);
+      }
+
+      ++m_ExtractionStats.entries;
+      m_ExtractionStats.bytesDecoded += data->getSize();
+      m_ExtractionStats.bytesWritten += data->getSize();
+
+      extracted += data->getSize();
+      if (progressCallback) {
+        auto guard = callbackTimer.instrument();
+        progressCallback(ProgressType::ARCHIVE, extracted, total);
+        progressCallback(ProgressType::EXTRACTION, extracted, total);
+      }
+
+      // same as the 7-Zip backend, the entries are cleared once extracted
+      data->clearOutputFilePaths();
+    }
+
+    updateStats();
+    return true;
+  }
+
+  ExtractionStats getExtractionStats() const override { return m_ExtractionStats; }
+
+  void cancel() override { m_Canceled = true; }
+
+private:
+  // the file data refer to the entries
+  const std::vector<MemoryArchiveEntry> m_Entries;
+  std::vector<std::unique_ptr<MemoryFileData>> m_Files;
+  std::vector<FileData*> m_FileList;
+
+  Error m_LastError;
+  ExtractionStats m_ExtractionStats;
+  LogCallback m_LogCallback;
+  std::atomic<bool> m_Canceled;
+
+  void log(LogLevel level, std::wstring const& message) const
+  {
+    if (m_LogCallback) {
+      m_LogCallback(level, message);
+    }
+  }
+
+  static bool write(std::filesystem::path const& path, MemoryFileData const& data)
+  {
+    namespace fs = std::filesystem;
+
+    std::error_code ec;
+
+    if (data.isDirectory()) {
+      fs::create_directories(path, ec);
+      return !ec;
+    }
+
+    fs::create_directories(path.parent_path(), ec);
+    if (ec) {
+      return false;
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(data.content().data(),
+              static_cast<std::streamsize>(data.content().size()));
+
+    return static_cast<bool>(out);
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<Archive> CreateMemoryArchive(std::vector<MemoryArchiveEntry> entries)
+{
+  return std::make_unique<MemoryArchive>(std::move(entries));
+}
@@ -0,0 +1,59 @@
+/*
+Mod Organizer archive handling
+
+Copyright (C) 2020 MO2 Team. All rights reserved.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef MEMORYARCHIVE_H
+#define MEMORYARCHIVE_H
+
+#include "archive.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief An entry of an in-memory archive.
+ */
+struct MemoryArchiveEntry
+{
+  // Path of the entry in the archive, with either kind of separators.
+  std::wstring path;
+
+  // Content of the entry, ignored for directories.
+  std::string content;
+
+  bool isDirectory = false;
+};
+
+/**
+ * @brief Factory function for archives that are held in memory instead of being read
+ * by 7-Zip.
+ *
+ * The returned archive does not need 7z.dll and works on any platform, which makes it
+ * suitable for tests and benchmarks of code that works with archives. open() succeeds
+ * for any path and lists the given entries, in order, and extract() writes the
+ * selected entries to the output directory.
+ *
+ * @param entries The entries of the archive.
+ *
+ * @return a pointer to a new Archive object serving the given entries.
+ */
+DLLEXPORT std::unique_ptr<Archive>
+CreateMemoryArchive(std::vector<MemoryArchiveEntry> entries);
+
+#endif  // MEMORYARCHIVE_H
@@ -39,7 +39,9 @@ static inline HRESULT ConvertBoolToHRESULT(bool result)
 //////////////////////////
 // MultiOutputStream
 
-MultiOutputStream::MultiOutputStream(WriteCallback callback) : m_WriteCallback(callback)
+MultiOutputStream::MultiOutputStream(WriteCallback callback,
+                                     ArchiveTimers::Timer* writeTimer)
+    : m_WriteCallback(callback), m_WriteTimer(writeTimer)
 {}
 
 MultiOutputStream::~MultiOutputStream() {}
@@ -68,6 +70,32 @@ bool MultiOutputStream::Open(std::vector<std::filesystem::path> const& filepaths
 
 STDMETHODIMP MultiOutputStream::Write(const void* data, UInt32 size,
                                       UInt32* processedSize)
+{
+  UInt32 written = 0;
+  HRESULT result;
+
+  if (m_WriteTimer == nullptr) {
+    result = DoWrite(data, size, processedSize, written);
+  } else {
+    auto guard = m_WriteTimer->instrument();
+    result     = DoWrite(data, size, processedSize, written);
+  }
+
+  if (result != S_OK) {
+    return result;
+  }
+
+  // the callback is not part of the write time
+  m_ProcessedSize += written;
+  if (m_WriteCallback) {
+    m_WriteCallback(written, m_ProcessedSize);
+  }
+
+  return S_OK;
+}
+
+HRESULT MultiOutputStream::DoWrite(const void* data, UInt32 size, UInt32* processedSize,
+                                   UInt32& written)
 {
   bool update_processed(true);
   for (auto& file : m_Files) {
@@ -76,10 +104,7 @@ STDMETHODIMP MultiOutputStream::Write(const void* data, UInt32 size,
       return ConvertBoolToHRESULT(false);
     }
     if (update_processed) {
-      m_ProcessedSize += realProcessedSize;
-      if (m_WriteCallback) {
-        m_WriteCallback(realProcessedSize, m_ProcessedSize);
-      }
+      written          = realProcessedSize;
       update_processed = false;
     }
     if (processedSize != nullptr) {
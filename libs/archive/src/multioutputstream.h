@@ -29,6 +29,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "7zip/IStream.h"
 
 #include "fileio.h"
+#include "instrument.h"
 #include "unknown_impl.h"
 
 /** This class allows you to open and output to multiple file handles at a time.
@@ -49,7 +50,13 @@ public:
   // in total.
   using WriteCallback = std::function<void(UInt32, UInt64)>;
 
-  MultiOutputStream(WriteCallback callback = {});
+  /**
+   * @param callback Called after every write.
+   * @param writeTimer If not null, instruments the calls to Write(), except for the
+   *   callback.
+   */
+  MultiOutputStream(WriteCallback callback = {},
+                    ArchiveTimers::Timer* writeTimer = nullptr);
 
   virtual ~MultiOutputStream();
 
@@ -89,6 +96,11 @@ public:
 
 private:
   WriteCallback m_WriteCallback;
+  ArchiveTimers::Timer* m_WriteTimer;
+
+  // writes to all the files, written is the number of bytes written to the first one
+  HRESULT DoWrite(const void* data, UInt32 size, UInt32* processedSize,
+                  UInt32& written);
 
   /** This is the amount of data written to *any one* file.
    *
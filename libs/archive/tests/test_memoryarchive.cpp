@@ -0,0 +1,170 @@
+#pragma warning(push)
+#pragma warning(disable : 4668)
+#include <gtest/gtest.h>
+#pragma warning(pop)
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "memoryarchive.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+std::vector<MemoryArchiveEntry> testEntries()
+{
+  return {{L"fomod/ModuleConfig.xml", "<config/>"},
+          {L"textures", "", true},
+          {L"textures\\a.dds", std::string(1000, 'a')},
+          {L"meshes/b.nif", "b"}};
+}
+
+fs::path testDirectory(std::string const& name)
+{
+  const auto path = fs::temp_directory_path() / "archive-tests" / name;
+  fs::remove_all(path);
+  fs::create_directories(path);
+  return path;
+}
+
+std::string readFile(fs::path const& path)
+{
+  std::ifstream in(path, std::ios::binary);
+  std::ostringstream ss;
+  ss << in.rdbuf();
+  return ss.str();
+}
+
+}  // namespace
+
+TEST(MemoryArchiveTest, ListsEntriesInOrder)
+{
+  auto archive = CreateMemoryArchive(testEntries());
+  ASSERT_TRUE(archive->isValid());
+  ASSERT_TRUE(archive->open(L"test.7z", {}));
+
+  const auto& files = archive->getFileList();
+  ASSERT_EQ(4u, files.size());
+
+  EXPECT_EQ(L"fomod/ModuleConfig.xml", files[0]->getArchiveFilePath());
+  EXPECT_EQ(9u, files[0]->getSize());
+  EXPECT_FALSE(files[0]->isDirectory());
+
+  EXPECT_EQ(L"textures", files[1]->getArchiveFilePath());
+  EXPECT_EQ(0u, files[1]->getSize());
+  EXPECT_TRUE(files[1]->isDirectory());
+
+  EXPECT_EQ(L"textures\\a.dds", files[2]->getArchiveFilePath());
+  EXPECT_EQ(1000u, files[2]->getSize());
+
+  // crc32 of "b"
+  EXPECT_EQ(0x71BEEFF9u, files[3]->getCRC());
+
+  archive->close();
+  EXPECT_TRUE(archive->getFileList().empty());
+}
+
+// only the selected entries are written, once for every output path, and the
+// output paths are cleared afterwards like with 7-Zip
+//
+TEST(MemoryArchiveTest, ExtractsSelectedEntries)
+{
+  const auto directory = testDirectory("extract");
+
+  auto archive = CreateMemoryArchive(testEntries());
+  ASSERT_TRUE(archive->open(L"test.7z", {}));
+
+  const auto& files = archive->getFileList();
+  files[0]->addOutputFilePath(L"fomod/ModuleConfig.xml");
+  files[2]->addOutputFilePath(L"a.dds");
+  files[2]->addOutputFilePath(L"copy/a.dds");
+
+  std::vector<std::wstring> started;
+  uint64_t lastProgress = 0, lastTotal = 0;
+
+  ASSERT_TRUE(archive->extract(
+      directory.wstring(),
+      [&](auto type, uint64_t progress, uint64_t total) {
+        if (type == Archive::ProgressType::EXTRACTION) {
+          lastProgress = progress;
+          lastTotal    = total;
+        }
+      },
+      [&](auto type, std::wstring const& path) {
+        if (type == Archive::FileChangeType::EXTRACTION_START) {
+          started.push_back(path);
+        }
+      },
+      {}));
+
+  EXPECT_EQ("<config/>", readFile(directory / "fomod" / "ModuleConfig.xml"));
+  EXPECT_EQ(std::string(1000, 'a'), readFile(directory / "a.dds"));
+  EXPECT_EQ(std::string(1000, 'a'), readFile(directory / "copy" / "a.dds"));
+  EXPECT_FALSE(fs::exists(directory / "meshes"));
+  EXPECT_FALSE(fs::exists(directory / "textures"));
+
+  EXPECT_EQ((std::vector<std::wstring>{L"fomod/ModuleConfig.xml", L"a.dds"}),
+            started);
+  EXPECT_EQ(1009u, lastProgress);
+  EXPECT_EQ(1009u, lastTotal);
+
+  for (auto* f : files) {
+    EXPECT_TRUE(f->getOutputFilePaths().empty());
+  }
+
+  const auto stats = archive->getExtractionStats();
+  EXPECT_EQ(2u, stats.entries);
+  EXPECT_EQ(3u, stats.files);
+  EXPECT_EQ(1009u, stats.bytesDecoded);
+  EXPECT_EQ(1009u, stats.bytesWritten);
+
+  fs::remove_all(directory);
+}
+
+TEST(MemoryArchiveTest, ExtractsDirectories)
+{
+  const auto directory = testDirectory("directories");
+
+  auto archive = CreateMemoryArchive(testEntries());
+  ASSERT_TRUE(archive->open(L"test.7z", {}));
+  archive->getFileList()[1]->addOutputFilePath(L"textures");
+
+  ASSERT_TRUE(archive->extract(directory.wstring(), nullptr, nullptr, nullptr));
+  EXPECT_TRUE(fs::is_directory(directory / "textures"));
+
+  fs::remove_all(directory);
+}
+
+TEST(MemoryArchiveTest, Cancel)
+{
+  const auto directory = testDirectory("cancel");
+
+  auto archive = CreateMemoryArchive(testEntries());
+  ASSERT_TRUE(archive->open(L"test.7z", {}));
+
+  for (auto* f : archive->getFileList()) {
+    if (!f->isDirectory()) {
+      f->addOutputFilePath(f->getArchiveFilePath());
+    }
+  }
+
+  // cancelled after the first entry
+  EXPECT_FALSE(archive->extract(
+      directory.wstring(),
+      [&](auto, uint64_t, uint64_t) {
+        archive->cancel();
+      },
+      nullptr, nullptr));
+
+  EXPECT_EQ(Archive::Error::ERROR_EXTRACT_CANCELLED, archive->getLastError());
+  EXPECT_EQ(1u, archive->getExtractionStats().entries);
+  EXPECT_TRUE(fs::exists(directory / "fomod" / "ModuleConfig.xml"));
+  EXPECT_FALSE(fs::exists(directory / "meshes" / "b.nif"));
+
+  fs::remove_all(directory);
+}
@@ -22,19 +22,24 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "bsaexception.h"
 #include "bsafile.h"
 #include "bsafolder.h"
+#include "bsamapping.h"
+#include "filehash.h"
 #include <algorithm>
-#include <boost/interprocess/sync/interprocess_semaphore.hpp>
-#include <boost/interprocess/sync/scoped_lock.hpp>
+#include <atomic>
 #include <boost/shared_array.hpp>
 #include <boost/thread.hpp>
+#include <chrono>
+#include <condition_variable>
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <lz4.h>
 #include <lz4frame.h>
 #include <memory>
-#include <queue>
+#include <mutex>
 #include <sys/stat.h>
+#include <thread>
 #include <zlib.h>
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
@@ -46,9 +51,45 @@ using namespace boost::posix_time;
 namespace BSA
 {
 
+struct Archive::DecompressionContext
+{
+  DecompressionContext() : zlibReady(false), lz4(nullptr)
+  {
+    memset(&zlib, 0, sizeof(zlib));
+    zlibReady = (inflateInit2(&zlib, 15 + 32) == Z_OK);
+    LZ4F_createDecompressionContext(&lz4, LZ4F_VERSION);
+  }
+
+  ~DecompressionContext()
+  {
+    if (zlibReady) {
+      inflateEnd(&zlib);
+    }
+    if (lz4 != nullptr) {
+      LZ4F_freeDecompressionContext(lz4);
+    }
+  }
+
+  DecompressionContext(const DecompressionContext&)            = delete;
+  DecompressionContext& operator=(const DecompressionContext&) = delete;
+
+  z_stream zlib;
+  bool zlibReady;
+  LZ4F_decompressionContext_t lz4;
+
+  // data read from the stream, unused if the archive is mapped
+  std::vector<unsigned char> input;
+
+  // decompressed data
+  std::vector<unsigned char> output;
+
+  // uncompressed content of a file being written, see packFile()
+  std::vector<unsigned char> content;
+};
+
 Archive::Archive()
     : m_RootFolder(new Folder), m_ArchiveFlags(FLAG_HASDIRNAMES | FLAG_HASFILENAMES),
-      m_Type(TYPE_SKYRIM)
+      m_Type(TYPE_SKYRIM), m_SourceType(TYPE_SKYRIM)
 {}
 
 Archive::~Archive()
@@ -155,13 +196,302 @@ Archive::Header Archive::readHeader(std::fstream& infile)
   return result;
 }
 
-EErrorCode Archive::read(const char* fileName, bool testHashes)
+Archive::Header Archive::readHeader(MappedReader& reader)
+{
+  Header result;
+
+  result.fileIdentifier = reader.read<uint32_t>();
+  if (result.fileIdentifier != 0x00415342 && result.fileIdentifier != 0x58445442 &&
+      result.fileIdentifier != 0x00000100) {
+    throw data_invalid_exception(makeString("not a bsa or ba2 file"));
+  }
+
+  if (result.fileIdentifier != 0x00000100) {
+    ArchiveType type = typeFromID(reader.read<BSAUInt>());
+    if (type == TYPE_FALLOUT4 || type == TYPE_STARFIELD ||
+        type == TYPE_STARFIELD_LZ4_TEXTURE || type == TYPE_FALLOUT4NG_7 ||
+        type == TYPE_FALLOUT4NG_8) {
+      result.type = type;
+      memcpy(result.archType, reader.take(4), 4);
+      result.archType[4]     = '\0';
+      result.fileCount       = reader.read<BSAUInt>();
+      result.nameTableOffset = reader.read<BSAHash>();
+      result.archiveFlags    = FLAG_HASDIRNAMES | FLAG_HASFILENAMES;
+    } else {
+      result.type             = type;
+      result.offset           = reader.read<BSAUInt>();
+      result.archiveFlags     = reader.read<BSAUInt>();
+      result.folderCount      = reader.read<BSAUInt>();
+      result.fileCount        = reader.read<BSAUInt>();
+      result.folderNameLength = reader.read<BSAUInt>();
+      result.fileNameLength   = reader.read<BSAUInt>();
+      result.fileFlags        = reader.read<BSAUInt>();
+    }
+  } else {
+    result.type         = TYPE_MORROWIND;
+    result.offset       = reader.read<BSAUInt>();
+    result.fileCount    = reader.read<BSAUInt>();
+    result.archiveFlags = FLAG_HASDIRNAMES | FLAG_HASFILENAMES;
+  }
+
+  return result;
+}
+
+EErrorCode Archive::read(const char* fileName, bool testHashes, bool mapFile)
 {
   m_File.open(fileName, fstream::in | fstream::binary);
   if (!m_File.is_open()) {
     return ERROR_FILENOTFOUND;
   }
   m_File.exceptions(std::ios_base::badbit);
+
+  // the folder and file records are parsed from a mapping of the file, the stream is
+  // still used to extract files
+  std::unique_ptr<MappedFile> mapping;
+  if (mapFile) {
+    try {
+      mapping.reset(new MappedFile(fileName));
+    } catch (const data_invalid_exception&) {
+      // mapping fails for empty files, for example, the stream parser reports those
+    }
+  }
+
+  EErrorCode result;
+  if (mapping) {
+    // kept for extraction, see fileData()
+    m_Mapping = std::move(mapping);
+    result    = readMapped(*m_Mapping, fileName, testHashes);
+  } else {
+    result = readStream(fileName, testHashes);
+  }
+
+  m_SourceType = m_Type;
+  return result;
+}
+
+EErrorCode Archive::readMapped(const MappedFile& file, const char* fileName,
+                               bool testHashes)
+{
+  MappedReader reader(file.data(), file.size());
+
+  Header header;
+  try {
+    header = readHeader(reader);
+  } catch (const data_invalid_exception& e) {
+    throw data_invalid_exception(makeString("%s (filename: %s)", e.what(), fileName));
+  }
+  m_ArchiveFlags = header.archiveFlags;
+  m_Type         = header.type;
+
+  if (isBA2()) {
+    return readMappedBA2(reader, header);
+  } else if (m_Type == TYPE_MORROWIND) {
+    return readMappedMorrowind(reader, header);
+  } else {
+    return readMappedTES4(reader, header, testHashes);
+  }
+}
+
+EErrorCode Archive::readMappedBA2(MappedReader& reader, const Header& header)
+{
+  // the name table is a list of length-prefixed strings after the file data
+  std::vector<std::string_view> fileNames(header.fileCount);
+  reader.seek(header.nameTableOffset);
+  for (std::string_view& name : fileNames) {
+    name = reader.readString(reader.read<BSAUShort>());
+  }
+
+  DirectoryCache directories;
+
+  switch (m_Type) {
+  case TYPE_STARFIELD:
+    reader.seek(32);
+    break;
+  case TYPE_STARFIELD_LZ4_TEXTURE:
+    reader.seek(36);
+    break;
+  default:
+    reader.seek(24);
+  }
+
+  if (strcmp(header.archType, "GNRL") == 0) {
+    // name hash, extension, directory hash, flags, offset, packed size, unpacked
+    // size, padding
+    const size_t recordSize      = 36;
+    const unsigned char* records = reader.take(header.fileCount * recordSize);
+    std::vector<FO4TextureChunk> dummy;
+
+    for (BSAUInt i = 0; i < header.fileCount; ++i) {
+      const unsigned char* record = records + i * recordSize;
+      addArchiveFile(directories, fileNames[i], MappedReader::get<BSAUInt>(record + 24),
+                     MappedReader::get<BSAHash>(record + 16),
+                     MappedReader::get<BSAUInt>(record + 28), {}, dummy);
+    }
+  } else if (strcmp(header.archType, "DX10") == 0) {
+    // texture records are followed by a variable number of chunk records
+    const size_t recordSize      = 24;
+    const size_t chunkRecordSize = 24;
+
+    for (BSAUInt i = 0; i < header.fileCount; ++i) {
+      const unsigned char* record = reader.take(recordSize);
+
+      FO4TextureHeader texHeader;
+      texHeader.nameHash = MappedReader::get<BSAUInt>(record);
+      memcpy(texHeader.extension, record + 4, 4);
+      texHeader.dirHash         = MappedReader::get<BSAUInt>(record + 8);
+      texHeader.unknown1        = record[12];
+      texHeader.chunkNumber     = record[13];
+      texHeader.chunkHeaderSize = MappedReader::get<BSAUShort>(record + 14);
+      texHeader.height          = MappedReader::get<BSAUShort>(record + 16);
+      texHeader.width           = MappedReader::get<BSAUShort>(record + 18);
+      texHeader.mipCount        = record[20];
+      texHeader.format          = static_cast<DXGI_FORMAT>(record[21]);
+      texHeader.isCubemap       = record[22] != 0;
+      texHeader.unknown2        = record[23];
+
+      if (texHeader.chunkNumber == 0) {
+        throw data_invalid_exception(makeString("texture without chunks: %s",
+                                                std::string(fileNames[i]).c_str()));
+      }
+
+      const unsigned char* chunkRecords =
+          reader.take(texHeader.chunkNumber * chunkRecordSize);
+      std::vector<FO4TextureChunk> chunks(texHeader.chunkNumber);
+      for (size_t j = 0; j < chunks.size(); ++j) {
+        const unsigned char* chunkRecord = chunkRecords + j * chunkRecordSize;
+
+        chunks[j].offset       = MappedReader::get<BSAHash>(chunkRecord);
+        chunks[j].packedSize   = MappedReader::get<BSAUInt>(chunkRecord + 8);
+        chunks[j].unpackedSize = MappedReader::get<BSAUInt>(chunkRecord + 12);
+        chunks[j].startMip     = MappedReader::get<BSAUShort>(chunkRecord + 16);
+        chunks[j].endMip       = MappedReader::get<BSAUShort>(chunkRecord + 18);
+        chunks[j].unknown      = MappedReader::get<BSAUInt>(chunkRecord + 20);
+      }
+
+      addArchiveFile(directories, fileNames[i], chunks[0].packedSize,
+                     chunks[0].offset, chunks[0].unpackedSize, texHeader, chunks);
+    }
+  }
+
+  return ERROR_NONE;
+}
+
+EErrorCode Archive::readMappedMorrowind(MappedReader& reader, const Header& header)
+{
+  // size and offset of every file, followed by the offsets of the names within the
+  // name block
+  const unsigned char* records     = reader.take(header.fileCount * size_t(8));
+  const unsigned char* nameOffsets = reader.take(header.fileCount * size_t(4));
+  const size_t namesBegin          = reader.tell();
+  const BSAUInt dataOffset         = 12 + header.offset + header.fileCount * 8;
+  DirectoryCache directories;
+  std::vector<FO4TextureChunk> dummy;
+
+  for (BSAUInt i = 0; i < header.fileCount; ++i) {
+    reader.seek(namesBegin + MappedReader::get<BSAUInt>(nameOffsets + i * 4));
+    const std::string_view name = reader.readZString();
+
+    const unsigned char* record = records + i * 8;
+    addArchiveFile(directories, name, MappedReader::get<BSAUInt>(record),
+                   dataOffset + MappedReader::get<BSAUInt>(record + 4), 0, {}, dummy);
+  }
+
+  return ERROR_NONE;
+}
+
+EErrorCode Archive::readMappedTES4(MappedReader& reader, const Header& header,
+                                   bool testHashes)
+{
+  // skyrim se uses 64-bit offsets in the folder records
+  const size_t folderRecordSize = (m_Type == TYPE_SKYRIMSE) ? 24 : 16;
+  const size_t fileRecordSize   = 16;
+  const unsigned char* folderRecords =
+      reader.take(header.folderCount * folderRecordSize);
+
+  // flat list of folders as they were stored in the archive
+  std::vector<Folder::Ptr> folders;
+  folders.reserve(header.folderCount);
+
+  // the file names follow the last block of file records
+  size_t namesBegin = reader.tell();
+
+  for (BSAUInt i = 0; i < header.folderCount; ++i) {
+    const unsigned char* record = folderRecords + i * folderRecordSize;
+
+    Folder::Ptr folder(new Folder());
+    folder->m_NameHash  = MappedReader::get<BSAHash>(record);
+    folder->m_FileCount = MappedReader::get<BSAUInt>(record + 8);
+    folder->m_Offset    = (m_Type == TYPE_SKYRIMSE)
+                              ? MappedReader::get<BSAHash>(record + 16)
+                              : MappedReader::get<BSAUInt>(record + 12);
+
+    // the offset includes the length of the file name block
+    reader.seek(folder->m_Offset - header.fileNameLength);
+    folder->m_Name = reader.readBString();
+
+    const unsigned char* fileRecords =
+        reader.take(folder->m_FileCount * fileRecordSize);
+    folder->m_Files.reserve(folder->m_FileCount);
+    for (BSAULong j = 0; j < folder->m_FileCount; ++j) {
+      const unsigned char* fileRecord = fileRecords + j * fileRecordSize;
+      folder->m_Files.push_back(File::Ptr(
+          new File(folder.get(), MappedReader::get<BSAHash>(fileRecord),
+                   MappedReader::get<BSAUInt>(fileRecord + 8),
+                   MappedReader::get<BSAUInt>(fileRecord + 12))));
+    }
+
+    namesBegin = (std::max)(namesBegin, reader.tell());
+
+    m_RootFolder->addFolderInt(folder);
+    folders.push_back(folder);
+  }
+
+  reader.seek(namesBegin);
+
+  bool hashesValid = true;
+  for (const Folder::Ptr& folder : folders) {
+    for (const File::Ptr& file : folder->m_Files) {
+      try {
+        file->m_Name = reader.readZString();
+      } catch (const data_invalid_exception&) {
+        hashesValid = false;
+        continue;
+      }
+      if (testHashes && calculateBSAHash(file->m_Name) != file->m_NameHash) {
+        hashesValid = false;
+      }
+    }
+  }
+
+  return hashesValid ? ERROR_NONE : ERROR_INVALIDHASHES;
+}
+
+void Archive::addArchiveFile(DirectoryCache& directories, std::string_view filePath,
+                             BSAUInt size, BSAHash offset, BSAUInt uncompressedSize,
+                             FO4TextureHeader header,
+                             std::vector<FO4TextureChunk>& texChunks)
+{
+  std::string_view directory;
+  std::string_view name = filePath;
+
+  std::string_view::size_type pos = filePath.find_last_of("\\/");
+  if (pos != std::string_view::npos) {
+    directory = filePath.substr(0, pos);
+    name      = filePath.substr(pos + 1);
+  }
+
+  // files of a directory are usually stored next to each other, but looking up the
+  // directory first saves walking the folder tree for every file
+  Folder::Ptr& folder = directories[directory];
+  if (!folder) {
+    folder = m_RootFolder->addFolderPath(directory);
+  }
+
+  folder->addArchiveFile(name, size, offset, uncompressedSize, header, texChunks);
+}
+
+EErrorCode Archive::readStream(const char* fileName, bool testHashes)
+{
   try {
     Header header;
     try {
@@ -174,8 +504,6 @@ EErrorCode Archive::read(const char* fileName, bool testHashes)
     if (m_Type == TYPE_FALLOUT4 || m_Type == TYPE_STARFIELD ||
         m_Type == TYPE_STARFIELD_LZ4_TEXTURE || m_Type == TYPE_FALLOUT4NG_7 ||
         m_Type == TYPE_FALLOUT4NG_8) {
-      std::vector<Folder::Ptr> folders;
-
       m_File.seekg(header.nameTableOffset);
 
       std::vector<std::string> fileNames;
@@ -189,6 +517,7 @@ EErrorCode Archive::read(const char* fileName, bool testHashes)
         fileNames.push_back(file);
         delete[] file;
       }
+      DirectoryCache directories;
       std::streamoff offset;
       switch (m_Type) {
       case TYPE_STARFIELD:
@@ -213,10 +542,8 @@ EErrorCode Archive::read(const char* fileName, bool testHashes)
           BSAUInt unpackedSize = readType<BSAUInt>(m_File);
           m_File.seekg(4, std::ios::cur);
           std::vector<FO4TextureChunk> dummy;
-          Folder::Ptr newDir = m_RootFolder->addFolderFromFile(
-              fileNames[i], packedSize, offset, unpackedSize, {}, dummy);
-          if (std::find(folders.begin(), folders.end(), newDir) == folders.end())
-            folders.push_back(newDir);
+          addArchiveFile(directories, fileNames[i], packedSize, offset, unpackedSize,
+                         {}, dummy);
           delete[] extension;
         }
       } else if (strcmp(header.archType, "DX10") == 0) {
@@ -246,17 +573,13 @@ EErrorCode Archive::read(const char* fileName, bool testHashes)
             chunk.unknown      = readType<BSAUInt>(m_File);
             chunks.push_back(chunk);
           }
-          Folder::Ptr newDir = m_RootFolder->addFolderFromFile(
-              fileNames[i], chunks[0].packedSize, chunks[0].offset,
-              chunks[0].unpackedSize, texHeader, chunks);
-          if (std::find(folders.begin(), folders.end(), newDir) == folders.end())
-            folders.push_back(newDir);
+          addArchiveFile(directories, fileNames[i], chunks[0].packedSize,
+                         chunks[0].offset, chunks[0].unpackedSize, texHeader, chunks);
         }
       }
 
       return ERROR_NONE;
     } else if (m_Type == TYPE_MORROWIND) {
-      std::vector<Folder::Ptr> folders;
       BSAUInt dataOffset = 12 + header.offset + header.fileCount * 8;
 
       std::vector<MorrowindFileOffset> fileSizeOffset(header.fileCount);
@@ -276,11 +599,9 @@ EErrorCode Archive::read(const char* fileName, bool testHashes)
         filePath[index] = '\0';
 
         std::vector<FO4TextureChunk> dummy;
-        Folder::Ptr newDir = m_RootFolder->addFolderFromFile(
-            filePath, fileSizeOffset[i].size, dataOffset + fileSizeOffset[i].offset, 0,
-            {}, dummy);
-        if (std::find(folders.begin(), folders.end(), newDir) == folders.end())
-          folders.push_back(newDir);
+        m_RootFolder->addFolderFromFile(filePath, fileSizeOffset[i].size,
+                                        dataOffset + fileSizeOffset[i].offset, 0, {},
+                                        dummy);
 
         delete[] filePath;
       }
@@ -312,6 +633,12 @@ EErrorCode Archive::read(const char* fileName, bool testHashes)
 
 void Archive::close()
 {
+  {
+    std::scoped_lock lock(m_ContextMutex);
+    m_Contexts.clear();
+  }
+
+  m_Mapping.reset();
   m_File.close();
 }
 
@@ -405,103 +732,6 @@ BSAULong Archive::determineFileFlags(const std::vector<std::string>& fileList) c
   return result;
 }
 
-void Archive::writeHeader(std::fstream& outfile, BSAULong fileFlags,
-                          BSAULong numFolders, BSAULong folderNamesLength,
-                          BSAULong fileNamesLength)
-{
-  outfile.write("BSA\0", 4);
-  writeType<BSAULong>(outfile, typeToID(m_Type));
-  writeType<BSAULong>(outfile, 0x24);  // header size is static
-  writeType<BSAULong>(outfile, m_ArchiveFlags);
-  writeType<BSAULong>(outfile, numFolders);
-  writeType<BSAULong>(outfile, countFiles());
-  writeType<BSAULong>(outfile, folderNamesLength);
-  writeType<BSAULong>(outfile, fileNamesLength);
-  writeType<BSAULong>(outfile, fileFlags);
-}
-
-EErrorCode Archive::write(const char* fileName)
-{
-  std::fstream outfile;
-  outfile.open(fileName, fstream::out | fstream::binary);
-  if (!outfile.is_open()) {
-    return ERROR_ACCESSFAILED;
-  }
-  outfile.exceptions(std::ios_base::badbit);
-
-  std::vector<Folder::Ptr> folders;
-  m_RootFolder->collectFolders(folders);
-
-  std::vector<std::string> folderNames;
-  std::vector<std::string> fileNames;
-  BSAULong folderNamesLength = 0;
-  BSAULong fileNamesLength   = 0;
-  for (std::vector<Folder::Ptr>::const_iterator folderIter = folders.begin();
-       folderIter != folders.end(); ++folderIter) {
-    std::string fullPath = (*folderIter)->getFullPath();
-    folderNames.push_back(fullPath);
-    folderNamesLength += static_cast<BSAULong>(fullPath.length());
-    for (std::vector<File::Ptr>::const_iterator fileIter =
-             (*folderIter)->m_Files.begin();
-         fileIter != (*folderIter)->m_Files.end(); ++fileIter) {
-      fileNames.push_back((*fileIter)->m_Name);
-      fileNamesLength += static_cast<BSAULong>((*fileIter)->m_Name.length());
-    }
-  }
-
-  try {
-    writeHeader(outfile, determineFileFlags(fileNames),
-                static_cast<BSAULong>(folderNames.size()), folderNamesLength,
-                fileNamesLength);
-#pragma message("folders (and files?) need to be sorted by hash!")
-    // dummy-pass: before we can store the actual folder data
-
-    // prepare folder and file headers
-#pragma message("it's unnecessary to write actual data, placeholders are sufficient")
-    for (std::vector<Folder::Ptr>::const_iterator folderIter = folders.begin();
-         folderIter != folders.end(); ++folderIter) {
-      (*folderIter)->writeHeader(outfile);
-    }
-
-    for (std::vector<Folder::Ptr>::const_iterator folderIter = folders.begin();
-         folderIter != folders.end(); ++folderIter) {
-      (*folderIter)->writeData(outfile, fileNamesLength);
-    }
-
-    // write file names
-    for (std::vector<std::string>::const_iterator folderIter = fileNames.begin();
-         folderIter != fileNames.end(); ++folderIter) {
-      writeZString(outfile, *folderIter);
-    }
-
-    // write file data
-    for (std::vector<Folder::Ptr>::iterator folderIter = folders.begin();
-         folderIter != folders.end(); ++folderIter) {
-      (*folderIter)->writeFileData(m_File, outfile);
-    }
-
-    outfile.seekp(0x24, fstream::beg);
-
-    // re-write folder and file structure, this time with the correct
-    // offsets
-    for (std::vector<Folder::Ptr>::const_iterator folderIter = folders.begin();
-         folderIter != folders.end(); ++folderIter) {
-      (*folderIter)->writeHeader(outfile);
-    }
-
-    for (std::vector<Folder::Ptr>::const_iterator folderIter = folders.begin();
-         folderIter != folders.end(); ++folderIter) {
-      (*folderIter)->writeData(outfile, fileNamesLength);
-    }
-
-    outfile.close();
-    return ERROR_NONE;
-  } catch (std::ios_base::failure&) {
-    outfile.close();
-    return ERROR_INVALIDDATA;
-  }
-}
-
 DirectX::DDS_HEADER Archive::getDDSHeader(File::Ptr file,
                                           DirectX::DDS_HEADER_DXT10& DX10Header,
                                           bool& isDX10) const
@@ -628,515 +858,406 @@ void Archive::getDX10Header(DirectX::DDS_HEADER_DXT10& DX10Header, File::Ptr fil
   DX10Header.miscFlags2        = 0;
 }
 
-static const unsigned long CHUNK_SIZE = 128 * 1024;
+// files are read and decompressed in blocks of this size so memory use doesn't grow
+// with the size of the file
+static const size_t StreamBlockSize = 256 * 1024;
 
-EErrorCode Archive::extractDirect(File::Ptr file, std::ofstream& outFile) const
+const unsigned char* Archive::fileData(BSAHash offset, size_t size,
+                                       std::vector<unsigned char>& buffer) const
 {
-  EErrorCode result = ERROR_NONE;
-  if (file->m_FileSize == 0) {
-    // don't try to read empty file
-    return result;
+  if (m_Mapping) {
+    if (offset > m_Mapping->size() || size > m_Mapping->size() - offset) {
+      throw data_invalid_exception("can't read from bsa");
+    }
+    return m_Mapping->data() + offset;
   }
 
-  m_File.clear();
-  m_File.seekg(static_cast<std::ifstream::pos_type>(file->m_DataOffset), std::ios::beg);
-
-  if (m_Type == TYPE_FALLOUT4 || m_Type == TYPE_STARFIELD ||
-      m_Type == TYPE_STARFIELD_LZ4_TEXTURE || m_Type == TYPE_FALLOUT4NG_7 ||
-      m_Type == TYPE_FALLOUT4NG_8) {
-    if (!file->m_TextureChunks.size()) {
-      BSAULong size = file->m_UncompressedFileSize;
-      std::unique_ptr<char[]> buffer(new char[size]);
-      m_File.read(buffer.get(), size);
-      outFile.write(buffer.get(), size);
-    } else {
-      bool isDX10                              = false;
-      DirectX::DDS_HEADER_DXT10 DX10HeaderData = {};
-      DirectX::DDS_HEADER DDSHeaderData = getDDSHeader(file, DX10HeaderData, isDX10);
-
-      outFile.write("DDS ", 4);
-      char* DDSHeader = new char[sizeof(DDSHeaderData)];
-      memcpy(DDSHeader, &DDSHeaderData, sizeof(DDSHeaderData));
-      outFile.write(DDSHeader, sizeof(DDSHeaderData));
-      delete[] DDSHeader;
-
-      if (isDX10) {
-        getDX10Header(DX10HeaderData, file, DDSHeaderData);
-        char* DX10Header = new char[sizeof(DX10HeaderData)];
-        memcpy(DX10Header, &DX10HeaderData, sizeof(DX10HeaderData));
-        outFile.write(DX10Header, sizeof(DX10HeaderData));
-        delete[] DX10Header;
-      }
+  buffer.resize(size);
 
-      for (BSAUInt i = 0; i < file->m_TextureChunks.size(); ++i) {
-        BSAULong length = file->m_TextureChunks[i].unpackedSize;
-        std::unique_ptr<char[]> chunk(new char[length]);
-        m_File.read(chunk.get(), length);
-        outFile.write(chunk.get(), length);
-      }
-    }
-  } else {
-    BSAULong size = file->m_FileSize;
-    if (namePrefixed()) {
-      std::string fullName = readBString(m_File);
-      if (size <= fullName.length()) {
-#pragma message("report error!")
-        return result;
-      }
-      size -= fullName.length() + 1;
-    }
-    std::unique_ptr<unsigned char[]> buffer(new unsigned char[size]);
-    m_File.read(reinterpret_cast<char*>(buffer.get()), size);
-    if (result == ERROR_NONE)
-      outFile.write(reinterpret_cast<char*>(buffer.get()), size);
+  std::scoped_lock lock(m_FileMutex);
+  m_File.clear();
+  m_File.seekg(static_cast<std::ifstream::pos_type>(offset), std::ios::beg);
+  if (!m_File.read(reinterpret_cast<char*>(buffer.data()), size)) {
+    throw data_invalid_exception("can't read from bsa");
   }
-  std::unique_ptr<char[]> inBuffer(new char[CHUNK_SIZE]);
+  return buffer.data();
+}
 
-  try {
-    unsigned long sizeLeft = file->m_FileSize;
+void Archive::readBlocks(BSAHash offset, size_t size,
+                         std::vector<unsigned char>& buffer,
+                         const BlockCallback& callback) const
+{
+  if (m_Mapping) {
+    callback(fileData(offset, size, buffer), size);
+    return;
+  }
 
-    while (sizeLeft > 0) {
-      int chunkSize = (std::min)(sizeLeft, CHUNK_SIZE);
-      m_File.read(inBuffer.get(), chunkSize);
-      outFile.write(inBuffer.get(), chunkSize);
-      sizeLeft -= chunkSize;
+  while (size > 0) {
+    const size_t blockSize = (std::min)(size, StreamBlockSize);
+    if (!callback(fileData(offset, blockSize, buffer), blockSize)) {
+      return;
     }
-  } catch (const std::exception&) {
-    result = ERROR_INVALIDDATA;
+    offset += blockSize;
+    size -= blockSize;
   }
-  return result;
 }
 
-boost::shared_array<unsigned char> Archive::decompress(unsigned char* inBuffer,
-                                                       BSAULong inSize,
-                                                       EErrorCode& result,
-                                                       BSAULong& outSize)
+bool Archive::inflateBlocks(DecompressionContext& context, BSAHash offset,
+                            size_t packedSize, size_t unpackedSize,
+                            const DataSink& sink) const
 {
-  if (outSize == 0) {
-    memcpy(&outSize, inBuffer, sizeof(BSAULong));
-    inBuffer += sizeof(BSAULong);
-    inSize -= sizeof(BSAULong);
+  z_stream& stream = context.zlib;
+  if (!context.zlibReady || inflateReset(&stream) != Z_OK) {
+    return false;
   }
 
-  if ((inSize == 0) || (outSize == 0)) {
-    return boost::shared_array<unsigned char>();
-  }
+  context.output.resize(StreamBlockSize);
 
-  boost::shared_array<unsigned char> outBuffer(new unsigned char[outSize]);
+  size_t remaining = unpackedSize;
+  bool failed      = false;
+  bool streamEnd   = false;
 
-  z_stream stream;
-  try {
-    stream.zalloc   = Z_NULL;
-    stream.zfree    = Z_NULL;
-    stream.opaque   = Z_NULL;
-    stream.avail_in = inSize;
-    stream.next_in  = static_cast<Bytef*>(inBuffer);
-    int zlibRet     = inflateInit2(&stream, 15 + 32);
-    if (zlibRet != Z_OK) {
-      result = ERROR_ZLIBINITFAILED;
-      return boost::shared_array<unsigned char>();
-    }
+  auto consume = [&](const unsigned char* data, size_t size) {
+    stream.next_in  = const_cast<Bytef*>(data);
+    stream.avail_in = static_cast<uInt>(size);
+
+    while (remaining > 0) {
+      const size_t outSize = (std::min)(remaining, StreamBlockSize);
+      stream.next_out      = context.output.data();
+      stream.avail_out     = static_cast<uInt>(outSize);
 
-    do {
-      stream.avail_out = outSize;
-      stream.next_out  = reinterpret_cast<Bytef*>(outBuffer.get());
-      zlibRet          = inflate(&stream, Z_NO_FLUSH);
-      if ((zlibRet != Z_OK) && (zlibRet != Z_STREAM_END) && (zlibRet != Z_BUF_ERROR)) {
-#pragma message("pass result code to caller")
-        throw std::runtime_error("invalid data");
+      const int ret = inflate(&stream, Z_NO_FLUSH);
+      if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+        failed = true;
+        break;
       }
-    } while (stream.avail_out == 0);
-    inflateEnd(&stream);
-    return outBuffer;
-  } catch (const std::exception&) {
-    result = ERROR_INVALIDDATA;
-    inflateEnd(&stream);
-    return boost::shared_array<unsigned char>();
-  }
+
+      const size_t produced = outSize - stream.avail_out;
+      if (produced > 0) {
+        sink(context.output.data(), produced);
+        remaining -= produced;
+      }
+
+      if (ret == Z_STREAM_END) {
+        streamEnd = true;
+        break;
+      }
+
+      // everything was consumed and flushed, the next block is needed
+      if (stream.avail_in == 0 && stream.avail_out != 0) {
+        break;
+      }
+    }
+
+    return !failed && !streamEnd && remaining > 0;
+  };
+
+  readBlocks(offset, packedSize, context.input, consume);
+
+  // data past the uncompressed size is ignored, like it always was
+  return !failed && remaining == 0;
 }
 
-EErrorCode Archive::extractCompressed(File::Ptr file, std::ofstream& outFile) const
+bool Archive::decompressFrameBlocks(DecompressionContext& context, BSAHash offset,
+                                    size_t packedSize, size_t unpackedSize,
+                                    const DataSink& sink) const
 {
-  EErrorCode result = ERROR_NONE;
-  if (file->m_FileSize == 0) {
-    // don't try to read empty file
-    return result;
+  if (context.lz4 == nullptr) {
+    return false;
   }
 
-  m_File.clear();
-  m_File.seekg(static_cast<std::ifstream::pos_type>(file->m_DataOffset), std::ios::beg);
-
-  if (m_Type == TYPE_FALLOUT4 || m_Type == TYPE_STARFIELD ||
-      m_Type == TYPE_STARFIELD_LZ4_TEXTURE || m_Type == TYPE_FALLOUT4NG_7 ||
-      m_Type == TYPE_FALLOUT4NG_8) {
-    if (!file->m_TextureChunks.size()) {
-      BSAULong inSize = file->m_FileSize;
-      std::unique_ptr<unsigned char[]> inBuffer(new unsigned char[inSize]);
-      m_File.read(reinterpret_cast<char*>(inBuffer.get()), inSize);
-      BSAULong length = file->m_UncompressedFileSize;
-      boost::shared_array<unsigned char> buffer =
-          decompress(inBuffer.get(), inSize, result, length);
-      if (result == ERROR_NONE) {
-        outFile.write(reinterpret_cast<char*>(buffer.get()), length);
-      }
-    } else {
-      bool isDX10                              = false;
-      DirectX::DDS_HEADER_DXT10 DX10HeaderData = {};
-      DirectX::DDS_HEADER DDSHeaderData = getDDSHeader(file, DX10HeaderData, isDX10);
-
-      outFile.write("DDS ", 4);
-      char* DDSHeader = new char[sizeof(DDSHeaderData)];
-      memcpy(DDSHeader, &DDSHeaderData, sizeof(DDSHeaderData));
-      outFile.write(DDSHeader, sizeof(DDSHeaderData));
-      delete[] DDSHeader;
-
-      if (isDX10) {
-        getDX10Header(DX10HeaderData, file, DDSHeaderData);
-        char* DX10Header = new char[sizeof(DX10HeaderData)];
-        memcpy(DX10Header, &DX10HeaderData, sizeof(DX10HeaderData));
-        outFile.write(DX10Header, sizeof(DX10HeaderData));
-        delete[] DX10Header;
+  LZ4F_resetDecompressionContext(context.lz4);
+  context.output.resize(StreamBlockSize);
+
+  size_t remaining = unpackedSize;
+  bool failed      = false;
+  bool frameEnd    = false;
+
+  auto consume = [&](const unsigned char* data, size_t size) {
+    size_t inPos = 0;
+
+    while (remaining > 0) {
+      size_t inChunk  = size - inPos;
+      size_t outChunk = (std::min)(remaining, StreamBlockSize);
+
+      const size_t ret =
+          LZ4F_decompress(context.lz4, context.output.data(), &outChunk,
+                          data + inPos, &inChunk, nullptr);
+      if (LZ4F_isError(ret)) {
+        failed = true;
+        break;
       }
 
-      for (BSAUInt i = 0; i < file->m_TextureChunks.size(); ++i) {
-        BSAULong length = file->m_TextureChunks[i].unpackedSize;
-        if (file->m_TextureChunks[i].packedSize > 0) {
-          unsigned char* chunk = new unsigned char[file->m_TextureChunks[i].packedSize];
-          m_File.read(reinterpret_cast<char*>(chunk),
-                      file->m_TextureChunks[i].packedSize);
-          if (m_Type == TYPE_STARFIELD_LZ4_TEXTURE) {
-            char* unpackedChunk = new char[length];
-            LZ4_decompress_safe(reinterpret_cast<char*>(chunk), unpackedChunk,
-                                file->m_TextureChunks[i].packedSize, length);
-            outFile.write(unpackedChunk, length);
-            delete[] unpackedChunk;
-          } else {
-            boost::shared_array<unsigned char> unpackedChunk =
-                decompress(chunk, file->m_TextureChunks[i].packedSize, result, length);
-            if (result == ERROR_NONE) {
-              outFile.write(reinterpret_cast<char*>(unpackedChunk.get()), length);
-            }
-          }
-          delete[] chunk;
-        } else {
-          char* chunk = new char[length];
-          m_File.read(chunk, length);
-          outFile.write(chunk, length);
-          delete[] chunk;
-        }
+      inPos += inChunk;
+      if (outChunk > 0) {
+        sink(context.output.data(), outChunk);
+        remaining -= outChunk;
       }
-    }
-  } else if (m_Type == TYPE_SKYRIMSE) {
-    BSAULong inSize = file->m_FileSize;
-    if (namePrefixed()) {
-      std::string fullName = readBString(m_File);
-      if (inSize <= fullName.length()) {
-#pragma message("report error!")
-        return result;
+
+      if (ret == 0) {
+        frameEnd = true;
+        break;
       }
-      inSize -= fullName.length() + 1;
-    }
-    BSAULong outSize = readType<BSAULong>(m_File);
-    inSize -= sizeof(BSAULong);
-    std::unique_ptr<unsigned char[]> inBuffer(new unsigned char[inSize]);
-    m_File.read(reinterpret_cast<char*>(inBuffer.get()), inSize);
-
-    LZ4F_decompressionContext_t dcContext = nullptr;
-    LZ4F_decompressOptions_t options      = {};
-    LZ4F_createDecompressionContext(&dcContext, LZ4F_VERSION);
-    size_t lzOutSize = outSize;
-    size_t lzInSize  = inSize;
-
-    std::unique_ptr<unsigned char[]> outBuffer(new unsigned char[outSize]);
-    LZ4F_decompress(dcContext, outBuffer.get(), &lzOutSize, inBuffer.get(), &lzInSize,
-                    &options);
-
-    outFile.write(reinterpret_cast<char*>(outBuffer.get()), outSize);
-  } else {
-    BSAULong inSize = file->m_FileSize;
-    if (namePrefixed()) {
-      std::string fullName = readBString(m_File);
-      if (inSize <= fullName.length()) {
-#pragma message("report error!")
-        return result;
+
+      // the decompressor needs the next block
+      if (inChunk == 0 && outChunk == 0) {
+        break;
       }
-      inSize -= fullName.length() + 1;
     }
-    std::unique_ptr<unsigned char[]> inBuffer(new unsigned char[inSize]);
-    m_File.read(reinterpret_cast<char*>(inBuffer.get()), inSize);
-    BSAULong length = 0UL;
-    boost::shared_array<unsigned char> buffer =
-        decompress(inBuffer.get(), inSize, result, length);
-    if (result == ERROR_NONE) {
-      outFile.write(reinterpret_cast<char*>(buffer.get()), length);
-    }
-  }
 
-  return result;
+    return !failed && !frameEnd && remaining > 0;
+  };
+
+  readBlocks(offset, packedSize, context.input, consume);
+
+  return !failed && remaining == 0;
 }
 
-EErrorCode Archive::extract(File::Ptr file, const char* outputDirectory) const
+bool Archive::decompressChunk(DecompressionContext& context, BSAHash offset,
+                              size_t packedSize, size_t unpackedSize,
+                              const DataSink& sink) const
 {
-  std::string fileName = makeString("%s/%s", outputDirectory, file->getName().c_str());
-  std::ofstream outputFile(fileName.c_str(),
-                           fstream::out | fstream::binary | fstream::trunc);
-  if (!outputFile.is_open()) {
-    return ERROR_ACCESSFAILED;
+  if (!lz4Chunks()) {
+    return inflateBlocks(context, offset, packedSize, unpackedSize, sink);
   }
 
-  EErrorCode result = ERROR_NONE;
-  if (compressed(file)) {
-    result = extractCompressed(file, outputFile);
-  } else {
-    result = extractDirect(file, outputFile);
+  // lz4 blocks can only be decompressed as a whole, memory is bounded by the size of
+  // a chunk rather than of the texture
+  const unsigned char* data = fileData(offset, packedSize, context.input);
+  context.output.resize(unpackedSize);
+
+  const bool ok = LZ4_decompress_safe(reinterpret_cast<const char*>(data),
+                                      reinterpret_cast<char*>(context.output.data()),
+                                      static_cast<int>(packedSize),
+                                      static_cast<int>(unpackedSize)) ==
+                  static_cast<int>(unpackedSize);
+  if (ok) {
+    sink(context.output.data(), unpackedSize);
   }
-  outputFile.close();
-  return result;
+
+  return ok;
 }
 
-void Archive::readFiles(std::queue<FileInfo>& queue, boost::mutex& mutex,
-                        boost::interprocess::interprocess_semaphore& bufferCount,
-                        boost::interprocess::interprocess_semaphore& queueFree,
-                        std::vector<File::Ptr>::iterator begin,
-                        std::vector<File::Ptr>::iterator end)
+void Archive::writeDDSHeader(const File::Ptr& file, const DataSink& sink) const
 {
-  for (; begin != end && !boost::this_thread::interruption_requested(); ++begin) {
-    queueFree.wait();
-
-    FileInfo fileInfo;
-    fileInfo.file = *begin;
-    size_t size   = static_cast<size_t>(fileInfo.file->m_FileSize);
-
-    m_File.seekg(fileInfo.file->m_DataOffset);
-    if (m_Type != TYPE_FALLOUT4 && m_Type != TYPE_STARFIELD &&
-        m_Type != TYPE_STARFIELD_LZ4_TEXTURE && m_Type != TYPE_FALLOUT4NG_7 &&
-        m_Type != TYPE_FALLOUT4NG_8) {
-      if (namePrefixed()) {
-        std::string fullName = readBString(m_File);
-        if (size <= fullName.length()) {
-#pragma message("report error!")
+  bool isDX10                              = false;
+  DirectX::DDS_HEADER_DXT10 DX10HeaderData = {};
+  DirectX::DDS_HEADER DDSHeaderData        = getDDSHeader(file, DX10HeaderData, isDX10);
+
+  sink(reinterpret_cast<const unsigned char*>("DDS "), 4);
+  sink(reinterpret_cast<const unsigned char*>(&DDSHeaderData), sizeof(DDSHeaderData));
+
+  if (isDX10) {
+    // This format requires DX10 header info
+    getDX10Header(DX10HeaderData, file, DDSHeaderData);
+    sink(reinterpret_cast<const unsigned char*>(&DX10HeaderData),
+         sizeof(DX10HeaderData));
+  }
+}
+
+EErrorCode Archive::extractData(const File::Ptr& file, DecompressionContext& context,
+                                const DataSink& sink) const
+{
+  // passes stored data on in blocks
+  auto copyBlocks = [&](BSAHash offset, size_t size) {
+    readBlocks(offset, size, context.input,
+               [&sink](const unsigned char* data, size_t blockSize) {
+                 sink(data, blockSize);
+                 return true;
+               });
+  };
+
+  if (isBA2()) {
+    if (!file->m_TextureChunks.empty()) {
+      // Texture stream format - requires building the header data for the DDS file
+      writeDDSHeader(file, sink);
+
+      // chunks are passed on one at a time
+      for (const FO4TextureChunk& chunk : file->m_TextureChunks) {
+        if (chunk.packedSize == 0) {
+          copyBlocks(chunk.offset, chunk.unpackedSize);
           continue;
         }
-        size -= fullName.length() + 1;
-      }
-      if (m_Type == TYPE_SKYRIMSE && compressed(fileInfo.file)) {
-        fileInfo.file->m_UncompressedFileSize = readType<BSAULong>(m_File);
-        size -= 4;
-      }
-      if (!fileInfo.file->m_TextureChunks.size()) {
-        fileInfo.data =
-            std::make_pair(boost::shared_array<unsigned char>(new unsigned char[size]),
-                           static_cast<BSAULong>(size));
-        m_File.read(reinterpret_cast<char*>(fileInfo.data.first.get()), size);
-      }
-    } else {
-      if (!fileInfo.file->m_TextureChunks.size()) {
-        if (size == 0)
-          size = fileInfo.file->m_UncompressedFileSize;
-        fileInfo.data =
-            std::make_pair(boost::shared_array<unsigned char>(new unsigned char[size]),
-                           static_cast<BSAULong>(size));
-        m_File.read(reinterpret_cast<char*>(fileInfo.data.first.get()), size);
-      } else {
-        fileInfo.file->m_UncompressedFileSize = 0L;
-        BSAULong totalSize                    = 0U;
-        for (BSAUInt i = 0; i < fileInfo.file->m_TextureChunks.size(); ++i) {
-          totalSize += fileInfo.file->m_TextureChunks[i].unpackedSize;
-        }
-        char* chunkData     = new char[totalSize];
-        BSAULong currentPos = 0U;
-        for (BSAUInt i = 0; i < fileInfo.file->m_TextureChunks.size(); ++i) {
-          BSAULong length = fileInfo.file->m_TextureChunks[i].unpackedSize;
-          if (fileInfo.file->m_TextureChunks[i].packedSize > 0) {
-            char* chunk = new char[fileInfo.file->m_TextureChunks[i].packedSize];
-            m_File.read(chunk, fileInfo.file->m_TextureChunks[i].packedSize);
-            if (m_Type == TYPE_FALLOUT4 || m_Type == TYPE_STARFIELD || m_Type == TYPE_FALLOUT4NG_7 || m_Type == TYPE_FALLOUT4NG_8) {
-              EErrorCode result = ERROR_NONE;
-              try {
-                boost::shared_array<unsigned char> unpackedChunk = decompress(
-                    reinterpret_cast<unsigned char*>(chunk),
-                    fileInfo.file->m_TextureChunks[i].packedSize, result, length);
-                memcpy(chunkData + currentPos,
-                       reinterpret_cast<char*>(unpackedChunk.get()), length);
-                unpackedChunk.reset();
-              } catch (const std::exception&) {
-#pragma message("report error!")
-                continue;
-              }
-            } else {
-              char* unpackedChunk = new char[length];
-              LZ4_decompress_safe(chunk, unpackedChunk,
-                                  fileInfo.file->m_TextureChunks[i].packedSize, length);
-              memcpy(chunkData + currentPos, unpackedChunk, length);
-              delete[] unpackedChunk;
-            }
-            delete[] chunk;
-            fileInfo.file->m_UncompressedFileSize += length;
-          } else {
-            char* chunk = new char[length];
-            m_File.read(chunk, length);
-            memcpy(chunkData + currentPos, chunk, length);
-            delete[] chunk;
-          }
-          currentPos += length;
+
+        if (!decompressChunk(context, chunk.offset, chunk.packedSize,
+                             chunk.unpackedSize, sink)) {
+          return ERROR_INVALIDDATA;
         }
-        fileInfo.file->m_FileSize = 0;
-        fileInfo.data             = std::make_pair(boost::shared_array<unsigned char>(
-                                           reinterpret_cast<unsigned char*>(chunkData)),
-                                                   static_cast<BSAULong>(totalSize));
       }
+    } else if (file->m_FileSize == 0) {
+      // stored uncompressed
+      copyBlocks(file->m_DataOffset, file->m_UncompressedFileSize);
+    } else if (!decompressChunk(context, file->m_DataOffset, file->m_FileSize,
+                                file->m_UncompressedFileSize, sink)) {
+      return ERROR_INVALIDDATA;
     }
 
-    {
-      boost::interprocess::scoped_lock<boost::mutex> lock(mutex);
-      queue.push(fileInfo);
-    }
-    bufferCount.post();
+    return ERROR_NONE;
   }
-}
 
-inline bool fileExists(const std::string& name)
-{
-  struct stat buffer;
-  return stat(name.c_str(), &buffer) != -1;
-}
+  BSAHash offset = file->m_DataOffset;
+  size_t size    = file->m_FileSize;
 
-void Archive::extractFiles(const std::string& targetDirectory,
-                           std::queue<FileInfo>& queue, boost::mutex& mutex,
-                           boost::interprocess::interprocess_semaphore& bufferCount,
-                           boost::interprocess::interprocess_semaphore& queueFree,
-                           int totalFiles, bool overwrite, int& filesDone)
-{
-  for (int i = 0; i < totalFiles; ++i) {
-    bufferCount.wait();
-    if (boost::this_thread::interruption_requested()) {
-      break;
+  if (namePrefixed()) {
+    // the full path of the file is stored as a bstring in front of the data
+    const size_t prefixSize = 1 + *fileData(offset, 1, context.input);
+    if (size <= prefixSize) {
+      return ERROR_INVALIDDATA;
     }
+    offset += prefixSize;
+    size -= prefixSize;
+  }
 
-    FileInfo fileInfo;
+  if (!compressed(file)) {
+    copyBlocks(offset, size);
+    return ERROR_NONE;
+  }
 
-    {
-      boost::interprocess::scoped_lock<boost::mutex> lock(mutex);
-      fileInfo = queue.front();
-      ++filesDone;
-      queue.pop();
-    }
-    queueFree.post();
+  // compressed data starts with the uncompressed size
+  if (size < sizeof(BSAUInt)) {
+    return ERROR_INVALIDDATA;
+  }
+
+  BSAUInt outSize;
+  memcpy(&outSize, fileData(offset, sizeof(BSAUInt), context.input), sizeof(BSAUInt));
+  offset += sizeof(BSAUInt);
+  size -= sizeof(BSAUInt);
+
+  bool ok = false;
+  if (m_Type == TYPE_SKYRIMSE) {
+    // Skyrim SE uses LZ4 Frame compression
+    ok = decompressFrameBlocks(context, offset, size, outSize, sink);
+  } else {
+    // Oblivion - Skyrim LE use zlib compression
+    ok = inflateBlocks(context, offset, size, outSize, sink);
+  }
+
+  return ok ? ERROR_NONE : ERROR_INVALIDDATA;
+}
 
-    DataBuffer dataBuffer = fileInfo.data;
+inline bool fileExists(const std::string& name)
+{
+  struct stat buffer;
+  return stat(name.c_str(), &buffer) != -1;
+}
 
-    std::string fileName = makeString("%s\\%s", targetDirectory.c_str(),
-                                      fileInfo.file->getFilePath().c_str());
-    if (!overwrite && fileExists(fileName)) {
-      continue;
+EErrorCode Archive::extractFile(const File::Ptr& file,
+                                const std::string& targetDirectory, bool overwrite,
+                                DecompressionContext& context) const
+{
+  const std::string fileName = targetDirectory + "\\" + file->getFilePath();
+  if (!overwrite && fileExists(fileName)) {
+    return ERROR_NONE;
+  }
+
+  std::ofstream outputFile(fileName.c_str(),
+                           fstream::out | fstream::binary | fstream::trunc);
+  if (!outputFile.is_open()) {
+    return ERROR_ACCESSFAILED;
+  }
+
+  try {
+    return extractData(file, context, [&outputFile](const unsigned char* data,
+                                                    size_t size) {
+      outputFile.write(reinterpret_cast<const char*>(data), size);
+    });
+  } catch (const std::exception&) {
+    return ERROR_INVALIDDATA;
+  }
+}
+
+std::unique_ptr<Archive::DecompressionContext> Archive::acquireContext() const
+{
+  {
+    std::scoped_lock lock(m_ContextMutex);
+    if (!m_Contexts.empty()) {
+      std::unique_ptr<DecompressionContext> context = std::move(m_Contexts.back());
+      m_Contexts.pop_back();
+      return context;
     }
+  }
 
-    std::ofstream outputFile(fileName.c_str(),
-                             fstream::out | fstream::binary | fstream::trunc);
+  return std::make_unique<DecompressionContext>();
+}
 
-    if (!outputFile.is_open()) {
-#pragma message("report error!")
-      continue;
-      // return ERROR_ACCESSFAILED;
+void Archive::releaseContext(std::unique_ptr<DecompressionContext> context) const
+{
+  // buffers of large files aren't worth keeping around
+  static const size_t maxBufferSize = 16 * 1024 * 1024;
+  for (std::vector<unsigned char>* buffer :
+       {&context->input, &context->output, &context->content}) {
+    if (buffer->capacity() > maxBufferSize) {
+      std::vector<unsigned char>().swap(*buffer);
     }
+  }
 
-    if (m_Type != TYPE_FALLOUT4 && m_Type != TYPE_STARFIELD &&
-        m_Type != TYPE_STARFIELD_LZ4_TEXTURE && m_Type != TYPE_FALLOUT4NG_7 &&
-        m_Type != TYPE_FALLOUT4NG_8) {
-      // BSA extraction
-      if (compressed(fileInfo.file)) {
-        // Decompress data
-        if (m_Type != TYPE_SKYRIMSE) {
-          // Oblivion - Skyrim LE use gzip compression
-          EErrorCode result = ERROR_NONE;
-          try {
-            BSAULong length = 0UL;
-            boost::shared_array<unsigned char> buffer =
-                decompress(dataBuffer.first.get(), dataBuffer.second, result, length);
-            if (buffer.get() != nullptr) {
-              outputFile.write(reinterpret_cast<char*>(buffer.get()), length);
-              buffer.reset();
-            }
-          } catch (const std::exception&) {
-#pragma message("report error!")
-            dataBuffer.first.reset();
-            fileInfo.data.first.reset();
-            continue;
-          }
-        } else {
-          // Skyrim SE uses LZ4 Frame compression
-          if (!fileInfo.file->m_TextureChunks.size()) {
-            char* outBuffer = new char[fileInfo.file->m_UncompressedFileSize];
-
-            LZ4F_decompressionContext_t dcContext = nullptr;
-            LZ4F_decompressOptions_t options      = {};
-            LZ4F_createDecompressionContext(&dcContext, LZ4F_VERSION);
-            size_t outSize = fileInfo.file->m_UncompressedFileSize;
-            size_t inSize  = dataBuffer.second;
-
-            LZ4F_decompress(dcContext, outBuffer, &outSize, dataBuffer.first.get(),
-                            &inSize, &options);
-            outputFile.write(outBuffer, fileInfo.file->m_UncompressedFileSize);
-            LZ4F_freeDecompressionContext(dcContext);
-            delete[] outBuffer;
-          }
-        }
-      } else {
-        // No compression - just write the data.
-        outputFile.write(reinterpret_cast<char*>(dataBuffer.first.get()),
-                         dataBuffer.second);
-      }
-    } else {
-      // BA2 format
-      if (fileInfo.file->m_TextureChunks.size()) {
-        // Texture stream format - requires building the header data for the DDS file
-        bool isDX10                              = false;
-        DirectX::DDS_HEADER_DXT10 DX10HeaderData = {};
-        DirectX::DDS_HEADER DDSHeaderData =
-            getDDSHeader(fileInfo.file, DX10HeaderData, isDX10);
-
-        outputFile.write("DDS ", 4);
-        char* DDSHeader = new char[sizeof(DDSHeaderData)];
-        memcpy(DDSHeader, &DDSHeaderData, sizeof(DDSHeaderData));
-        outputFile.write(DDSHeader, sizeof(DDSHeaderData));
-        delete[] DDSHeader;
-
-        if (isDX10) {
-          // This format requires DX10 header info
-          getDX10Header(DX10HeaderData, fileInfo.file, DDSHeaderData);
-
-          char* DX10Header = new char[sizeof(DX10HeaderData)];
-          memcpy(DX10Header, &DX10HeaderData, sizeof(DX10HeaderData));
-          outputFile.write(DX10Header, sizeof(DX10HeaderData));
-          delete[] DX10Header;
-        }
-      }
+  std::scoped_lock lock(m_ContextMutex);
+  m_Contexts.push_back(std::move(context));
+}
 
-      EErrorCode result = ERROR_NONE;
-      try {
-        BSAULong length = fileInfo.file->m_UncompressedFileSize;
-        if (fileInfo.file->m_FileSize > 0 && !fileInfo.file->m_TextureChunks.size()) {
-          BSAULong length = fileInfo.file->m_UncompressedFileSize;
-          boost::shared_array<unsigned char> buffer =
-              decompress(dataBuffer.first.get(), dataBuffer.second, result, length);
-          if (buffer.get() != nullptr) {
-            outputFile.write(reinterpret_cast<char*>(buffer.get()), length);
-            buffer.reset();
-          }
-        } else {
-          outputFile.write(reinterpret_cast<char*>(dataBuffer.first.get()),
-                           dataBuffer.second);
-        }
-      } catch (const std::exception&) {
-#pragma message("report error!")
-        dataBuffer.first.reset();
-        fileInfo.data.first.reset();
-        continue;
-      }
+EErrorCode Archive::readFile(const File::Ptr& file,
+                             std::vector<unsigned char>& data) const
+{
+  return readFile(file, 0, (std::numeric_limits<size_t>::max)(), data);
+}
+
+EErrorCode Archive::readFile(const File::Ptr& file, BSAHash offset, size_t size,
+                             std::vector<unsigned char>& data) const
+{
+  data.clear();
+
+  std::unique_ptr<DecompressionContext> context = acquireContext();
+
+  BSAHash position = 0;
+
+  // uncompressed data is passed straight from the mapping, so for those files only
+  // the requested range is ever touched
+  auto sink = [&](const unsigned char* piece, size_t pieceSize) {
+    const BSAHash end = position + pieceSize;
+    if (end > offset && data.size() < size) {
+      const size_t skip =
+          position < offset ? static_cast<size_t>(offset - position) : 0;
+      const size_t count = (std::min)(pieceSize - skip, size - data.size());
+      data.insert(data.end(), piece + skip, piece + skip + count);
     }
-    dataBuffer.first.reset();
-    fileInfo.data.first.reset();
+    position = end;
+  };
+
+  EErrorCode result;
+  try {
+    result = extractData(file, *context, sink);
+  } catch (const std::exception&) {
+    result = ERROR_INVALIDDATA;
+  }
+
+  releaseContext(std::move(context));
+  return result;
+}
+
+EErrorCode Archive::extract(File::Ptr file, const char* outputDirectory) const
+{
+  std::string fileName = makeString("%s/%s", outputDirectory, file->getName().c_str());
+  std::ofstream outputFile(fileName.c_str(),
+                           fstream::out | fstream::binary | fstream::trunc);
+  if (!outputFile.is_open()) {
+    return ERROR_ACCESSFAILED;
   }
+
+  std::unique_ptr<DecompressionContext> context = acquireContext();
+
+  EErrorCode result;
+  try {
+    result = extractData(file, *context, [&outputFile](const unsigned char* data,
+                                                       size_t size) {
+      outputFile.write(reinterpret_cast<const char*>(data), size);
+    });
+  } catch (const std::exception&) {
+    result = ERROR_INVALIDDATA;
+  }
+
+  releaseContext(std::move(context));
+  outputFile.close();
+  return result;
 }
 
 void Archive::createFolders(const std::string& targetDirectory, Folder::Ptr folder)
@@ -1149,64 +1270,741 @@ void Archive::createFolders(const std::string& targetDirectory, Folder::Ptr fold
   }
 }
 
+EErrorCode Archive::processFiles(
+    std::vector<File::Ptr>& files,
+    const boost::function<bool(int value, std::string fileName)>& progress,
+    unsigned int threadCount, const FileTask& task) const
+{
+  if (files.empty()) {
+    return ERROR_NONE;
+  }
+
+  std::sort(files.begin(), files.end(), ByOffset);
+
+  if (threadCount == 0) {
+    threadCount = (std::max)(std::thread::hardware_concurrency(), 1u);
+  }
+  threadCount = static_cast<unsigned int>(
+      (std::min)(static_cast<size_t>(threadCount), files.size()));
+
+  std::atomic<size_t> nextFile(0);
+  std::atomic<int> filesDone(0);
+  std::atomic<bool> canceled(false);
+  std::atomic<int> result(ERROR_NONE);
+
+  std::mutex doneMutex;
+  std::condition_variable doneCondition;
+  unsigned int workersDone = 0;
+
+  // every worker handles files on its own, with buffers that are reused for all the
+  // files it handles
+  auto worker = [&]() {
+    DecompressionContext context;
+
+    for (;;) {
+      const size_t index = nextFile++;
+      if (index >= files.size() || canceled) {
+        break;
+      }
+
+      const EErrorCode res = task(files[index], context);
+      if (res != ERROR_NONE) {
+        // the first error is reported
+        int expected = ERROR_NONE;
+        result.compare_exchange_strong(expected, res);
+      }
+
+      ++filesDone;
+    }
+
+    {
+      std::scoped_lock lock(doneMutex);
+      ++workersDone;
+    }
+    doneCondition.notify_one();
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned int i = 0; i < threadCount; ++i) {
+    workers.emplace_back(worker);
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(doneMutex);
+    while (workersDone < workers.size()) {
+      doneCondition.wait_for(lock, std::chrono::milliseconds(100));
+      lock.unlock();
+
+      const int done = filesDone;
+      size_t index   = (std::min)(static_cast<size_t>(done), files.size() - 1);
+      if (!progress((done * 100) / static_cast<int>(files.size()),
+                    files[index]->getName())) {
+        canceled = true;
+      }
+
+      lock.lock();
+    }
+  }
+
+  for (std::thread& thread : workers) {
+    thread.join();
+  }
+
+  if (canceled) {
+    return ERROR_CANCELED;
+  }
+
+  return static_cast<EErrorCode>(result.load());
+}
+
 EErrorCode Archive::extractAll(
     const char* outputDirectory,
     const boost::function<bool(int value, std::string fileName)>& progress,
-    bool overwrite)
+    bool overwrite, unsigned int threadCount)
 {
-#pragma message("report errors")
   createFolders(outputDirectory, m_RootFolder);
 
   std::vector<File::Ptr> fileList;
   m_RootFolder->collectFiles(fileList);
-  std::sort(fileList.begin(), fileList.end(), ByOffset);
-  m_File.seekg((*(fileList.begin()))->m_DataOffset);
-
-  std::queue<FileInfo> buffers;
-  boost::mutex queueMutex;
-  int filesDone = 0;
-  boost::interprocess::interprocess_semaphore bufferCount(0);
-  boost::interprocess::interprocess_semaphore queueFree(100);
-
-  boost::thread readerThread(boost::bind(&Archive::readFiles, this, boost::ref(buffers),
-                                         boost::ref(queueMutex),
-                                         boost::ref(bufferCount), boost::ref(queueFree),
-                                         fileList.begin(), fileList.end()));
-
-  boost::thread extractThread(boost::bind(
-      &Archive::extractFiles, this, outputDirectory, boost::ref(buffers),
-      boost::ref(queueMutex), boost::ref(bufferCount), boost::ref(queueFree),
-      static_cast<int>(fileList.size()), overwrite, boost::ref(filesDone)));
-
-  bool readerDone  = false;
-  bool extractDone = false;
-  bool canceled    = false;
-  while (!readerDone || !extractDone) {
-    if (!readerDone) {
-      readerDone = readerThread.timed_join(boost::posix_time::millisec(100));
+
+  // every worker reads, decompresses and writes files on its own
+  const std::string targetDirectory(outputDirectory);
+  return processFiles(fileList, progress, threadCount,
+                      [&](const File::Ptr& file, DecompressionContext& context) {
+                        return extractFile(file, targetDirectory, overwrite,
+                                           context);
+                      });
+}
+
+EErrorCode Archive::verify(
+    const boost::function<bool(int value, std::string fileName)>& progress,
+    std::vector<std::pair<std::string, EErrorCode>>* problems,
+    unsigned int threadCount) const
+{
+  std::mutex problemMutex;
+  EErrorCode firstProblem = ERROR_NONE;
+
+  auto report = [&](std::string path, EErrorCode problem) {
+    std::scoped_lock lock(problemMutex);
+    if (firstProblem == ERROR_NONE) {
+      firstProblem = problem;
+    }
+    if (problems != nullptr) {
+      problems->emplace_back(std::move(path), problem);
+    }
+  };
+
+  std::vector<Folder::Ptr> folders;
+  m_RootFolder->collectFolders(folders);
+
+  // only folders that were read from a folder record have a hash, names are missing
+  // if the archive doesn't store them
+  if (hasNameHashes()) {
+    for (const Folder::Ptr& folder : folders) {
+      if (folder->m_FileCount == 0 || folder->m_Name.empty()) {
+        continue;
+      }
+      const std::string path = folder->getFullPath();
+      if (calculateBSAFolderHash(path) != folder->m_NameHash) {
+        report(path, ERROR_INVALIDHASHES);
+      }
+    }
+  }
+
+  std::vector<File::Ptr> fileList;
+  m_RootFolder->collectFiles(fileList);
+
+  // the data is decompressed but dropped, which also checks that it lies within the
+  // archive
+  auto discard = [](const unsigned char*, size_t) {};
+
+  const EErrorCode result = processFiles(
+      fileList, progress, threadCount,
+      [&](const File::Ptr& file, DecompressionContext& context) {
+        if (hasNameHashes() && !file->m_Name.empty() &&
+            calculateBSAHash(file->m_Name) != file->m_NameHash) {
+          report(file->getFilePath(), ERROR_INVALIDHASHES);
+        }
+
+        EErrorCode res;
+        try {
+          res = extractData(file, context, discard);
+        } catch (const std::exception&) {
+          res = ERROR_INVALIDDATA;
+        }
+
+        if (res != ERROR_NONE) {
+          report(file->getFilePath(), res);
+        }
+        return res;
+      });
+
+  if (result == ERROR_CANCELED) {
+    return result;
+  }
+
+  return firstProblem;
+}
+
+struct Archive::PackedFile
+{
+  File::Ptr file;
+  // full path inside the archive
+  std::string path;
+  bool compress = false;
+
+  // data as stored in the archive, released once it's written
+  std::vector<unsigned char> data;
+  BSAUInt uncompressedSize = 0;
+
+  BSAHash offset     = 0;
+  BSAUInt storedSize = 0;
+
+  EErrorCode result = ERROR_NONE;
+  bool done         = false;
+};
+
+static bool zlibCompress(const std::vector<unsigned char>& input,
+                         std::vector<unsigned char>& output, size_t outputOffset)
+{
+  uLongf size = compressBound(static_cast<uLong>(input.size()));
+  output.resize(outputOffset + size);
+  if (compress2(output.data() + outputOffset, &size, input.data(),
+                static_cast<uLong>(input.size()), Z_DEFAULT_COMPRESSION) != Z_OK) {
+    return false;
+  }
+  output.resize(outputOffset + size);
+  return true;
+}
+
+static bool lz4CompressBlock(const std::vector<unsigned char>& input,
+                             std::vector<unsigned char>& output)
+{
+  if (input.size() > LZ4_MAX_INPUT_SIZE) {
+    return false;
+  }
+
+  const int bound = LZ4_compressBound(static_cast<int>(input.size()));
+  output.resize(bound);
+  const int size = LZ4_compress_default(reinterpret_cast<const char*>(input.data()),
+                                        reinterpret_cast<char*>(output.data()),
+                                        static_cast<int>(input.size()), bound);
+  if (size <= 0) {
+    return false;
+  }
+  output.resize(size);
+  return true;
+}
+
+static bool lz4CompressFrame(const std::vector<unsigned char>& input,
+                             std::vector<unsigned char>& output, size_t outputOffset)
+{
+  LZ4F_preferences_t preferences = {};
+  preferences.frameInfo.contentSize = input.size();
+
+  const size_t bound = LZ4F_compressFrameBound(input.size(), &preferences);
+  output.resize(outputOffset + bound);
+  const size_t size = LZ4F_compressFrame(output.data() + outputOffset, bound,
+                                         input.data(), input.size(), &preferences);
+  if (LZ4F_isError(size)) {
+    return false;
+  }
+  output.resize(outputOffset + size);
+  return true;
+}
+
+EErrorCode Archive::packFile(PackedFile& file, DecompressionContext& context) const
+{
+  std::vector<unsigned char>& content = context.content;
+  content.clear();
+
+  if (!file.file->m_SourceFile.empty()) {
+    std::ifstream source(file.file->m_SourceFile,
+                         std::ios::in | std::ios::binary | std::ios::ate);
+    if (!source.is_open()) {
+      return ERROR_SOURCEFILEMISSING;
+    }
+    content.resize(static_cast<size_t>(source.tellg()));
+    source.seekg(0, std::ios::beg);
+    if (!source.read(reinterpret_cast<char*>(content.data()), content.size())) {
+      return ERROR_SOURCEFILEMISSING;
+    }
+  } else {
+    const EErrorCode res = extractData(
+        file.file, context, [&content](const unsigned char* data, size_t size) {
+          content.insert(content.end(), data, data + size);
+        });
+    if (res != ERROR_NONE) {
+      return res;
+    }
+  }
+
+  // sizes are 30 bits in TES4 file records
+  if (content.size() > (isBA2() ? 0xFFFFFFFFULL : File::SIZEMASK)) {
+    return ERROR_INVALIDDATA;
+  }
+  file.uncompressedSize = static_cast<BSAUInt>(content.size());
+
+  std::vector<unsigned char>& data = file.data;
+  data.clear();
+
+  if (isBA2()) {
+    if (!file.compress) {
+      data.swap(content);
+      return ERROR_NONE;
+    }
+    const bool ok =
+        lz4Chunks() ? lz4CompressBlock(content, data) : zlibCompress(content, data, 0);
+    return ok ? ERROR_NONE : ERROR_INVALIDDATA;
+  }
+
+  if (namePrefixed()) {
+    // the full path of the file is stored as a bstring in front of the data
+    data.push_back(static_cast<unsigned char>(file.path.length()));
+    data.insert(data.end(), file.path.begin(), file.path.end());
+  }
+
+  if (!file.compress) {
+    data.insert(data.end(), content.begin(), content.end());
+    return ERROR_NONE;
+  }
+
+  // compressed data starts with the uncompressed size
+  const size_t sizeOffset = data.size();
+  data.resize(sizeOffset + sizeof(BSAUInt));
+  memcpy(data.data() + sizeOffset, &file.uncompressedSize, sizeof(BSAUInt));
+
+  bool ok = false;
+  if (m_Type == TYPE_SKYRIMSE) {
+    ok = lz4CompressFrame(content, data, data.size());
+  } else {
+    ok = zlibCompress(content, data, data.size());
+  }
+
+  return ok ? ERROR_NONE : ERROR_INVALIDDATA;
+}
+
+EErrorCode Archive::writeFileData(std::fstream& outfile, std::vector<PackedFile>& files,
+                                  unsigned int threadCount) const
+{
+  if (files.empty()) {
+    return ERROR_NONE;
+  }
+
+  if (threadCount == 0) {
+    threadCount = (std::max)(std::thread::hardware_concurrency(), 1u);
+  }
+  threadCount = static_cast<unsigned int>(
+      (std::min)(static_cast<size_t>(threadCount), files.size()));
+
+  // data has to be written in order, this limits how far the workers may get ahead
+  // of the file being written so memory use stays bounded
+  const size_t window = threadCount * size_t(4);
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  size_t nextFile     = 0;
+  size_t filesWritten = 0;
+  bool stopped        = false;
+
+  auto worker = [&]() {
+    DecompressionContext context;
+
+    for (;;) {
+      size_t index;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&] {
+          return stopped || nextFile >= files.size() ||
+                 nextFile < filesWritten + window;
+        });
+        if (stopped || nextFile >= files.size()) {
+          break;
+        }
+        index = nextFile++;
+      }
+
+      EErrorCode res;
+      try {
+        res = packFile(files[index], context);
+      } catch (const std::exception&) {
+        res = ERROR_INVALIDDATA;
+      }
+
+      {
+        std::scoped_lock lock(mutex);
+        files[index].result = res;
+        files[index].done   = true;
+      }
+      condition.notify_all();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned int i = 0; i < threadCount; ++i) {
+    workers.emplace_back(worker);
+  }
+
+  EErrorCode result = ERROR_NONE;
+  try {
+    for (PackedFile& file : files) {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&] {
+          return file.done;
+        });
+      }
+
+      if (file.result != ERROR_NONE) {
+        result = file.result;
+        break;
+      }
+
+      file.offset     = static_cast<BSAHash>(outfile.tellp());
+      file.storedSize = static_cast<BSAUInt>(file.data.size());
+      outfile.write(reinterpret_cast<const char*>(file.data.data()), file.data.size());
+      std::vector<unsigned char>().swap(file.data);
+
+      {
+        std::scoped_lock lock(mutex);
+        ++filesWritten;
+      }
+      condition.notify_all();
+    }
+  } catch (const std::ios_base::failure&) {
+    result = ERROR_INVALIDDATA;
+  }
+
+  {
+    std::scoped_lock lock(mutex);
+    stopped = true;
+  }
+  condition.notify_all();
+
+  for (std::thread& thread : workers) {
+    thread.join();
+  }
+
+  return result;
+}
+
+EErrorCode Archive::writeTES4(std::fstream& outfile, unsigned int threadCount)
+{
+  static const BSAUInt headerSize = 0x24;
+
+  struct FolderEntry
+  {
+    std::string path;
+    BSAHash hash;
+    std::vector<std::pair<BSAHash, File::Ptr>> files;
+  };
+
+  std::vector<Folder::Ptr> folders;
+  m_RootFolder->collectFolders(folders);
+
+  // the games look up folders and files with a binary search over the hashes
+  std::vector<FolderEntry> entries;
+  for (const Folder::Ptr& folder : folders) {
+    FolderEntry entry;
+    entry.path = folder->getFullPath();
+    entry.hash = calculateBSAFolderHash(entry.path);
+    if (entry.path.length() > 254) {
+      return ERROR_INVALIDDATA;
+    }
+
+    for (const File::Ptr& file : folder->m_Files) {
+      entry.files.emplace_back(calculateBSAHash(file->m_Name), file);
+    }
+
+    entries.push_back(std::move(entry));
+  }
+
+  std::sort(entries.begin(), entries.end(),
+            [](const FolderEntry& lhs, const FolderEntry& rhs) {
+              return lhs.hash < rhs.hash;
+            });
+
+  // Folder::addFolder() doesn't check for existing folders, folders with the same
+  // path are merged
+  for (size_t i = 1; i < entries.size();) {
+    if (entries[i].hash == entries[i - 1].hash &&
+        _stricmp(entries[i].path.c_str(), entries[i - 1].path.c_str()) == 0) {
+      entries[i - 1].files.insert(entries[i - 1].files.end(), entries[i].files.begin(),
+                                  entries[i].files.end());
+      entries.erase(entries.begin() + i);
+    } else {
+      ++i;
+    }
+  }
+
+  for (FolderEntry& entry : entries) {
+    std::sort(entry.files.begin(), entry.files.end(),
+              [](const auto& lhs, const auto& rhs) {
+                return lhs.first < rhs.first;
+              });
+  }
+
+  const bool hasDirNames  = (m_ArchiveFlags & FLAG_HASDIRNAMES) != 0;
+  const bool hasFileNames = (m_ArchiveFlags & FLAG_HASFILENAMES) != 0;
+
+  std::vector<PackedFile> files;
+  std::vector<std::string> fileNames;
+  BSAUInt folderNamesLength = 0;
+  BSAUInt fileNamesLength   = 0;
+  size_t recordsLength      = 0;
+
+  for (const FolderEntry& entry : entries) {
+    folderNamesLength += static_cast<BSAUInt>(entry.path.length() + 1);
+    if (hasDirNames) {
+      recordsLength += entry.path.length() + 2;
+    }
+    recordsLength += entry.files.size() * 16;
+
+    for (const auto& hashFile : entry.files) {
+      const File::Ptr& file = hashFile.second;
+
+      PackedFile packed;
+      packed.file     = file;
+      packed.path     = entry.path + "\\" + file->m_Name;
+      packed.compress = file->compressToggled() != defaultCompressed();
+      files.push_back(std::move(packed));
+
+      fileNames.push_back(file->m_Name);
+      fileNamesLength += static_cast<BSAUInt>(file->m_Name.length() + 1);
+    }
+  }
+
+  const size_t folderRecordSize = (m_Type == TYPE_SKYRIMSE) ? 24 : 16;
+  const size_t recordsOffset    = headerSize + entries.size() * folderRecordSize;
+  const size_t dataOffset =
+      recordsOffset + recordsLength + (hasFileNames ? fileNamesLength : 0);
+
+  // the data is written first, the records only once all offsets are known
+  outfile.seekp(dataOffset, fstream::beg);
+  const EErrorCode result = writeFileData(outfile, files, threadCount);
+  if (result != ERROR_NONE) {
+    return result;
+  }
+
+  if (static_cast<BSAHash>(outfile.tellp()) > 0xFFFFFFFFULL) {
+    // offsets are 32 bits
+    return ERROR_INVALIDDATA;
+  }
+
+  outfile.seekp(0, fstream::beg);
+  outfile.write("BSA\0", 4);
+  writeType<BSAUInt>(outfile, typeToID(m_Type));
+  writeType<BSAUInt>(outfile, headerSize);
+  writeType<BSAUInt>(outfile, m_ArchiveFlags);
+  writeType<BSAUInt>(outfile, static_cast<BSAUInt>(entries.size()));
+  writeType<BSAUInt>(outfile, static_cast<BSAUInt>(files.size()));
+  writeType<BSAUInt>(outfile, folderNamesLength);
+  writeType<BSAUInt>(outfile, fileNamesLength);
+  writeType<BSAUInt>(outfile, determineFileFlags(fileNames));
+
+  // folder records point at their file records, offset by the length of the file
+  // names for historic reasons
+  size_t recordOffset = recordsOffset;
+  for (const FolderEntry& entry : entries) {
+    writeType<BSAHash>(outfile, entry.hash);
+    writeType<BSAUInt>(outfile, static_cast<BSAUInt>(entry.files.size()));
+    if (m_Type == TYPE_SKYRIMSE) {
+      writeType<BSAUInt>(outfile, 0);
+      writeType<BSAHash>(outfile, recordOffset + fileNamesLength);
+    } else {
+      writeType<BSAUInt>(outfile, static_cast<BSAUInt>(recordOffset + fileNamesLength));
+    }
+
+    if (hasDirNames) {
+      recordOffset += entry.path.length() + 2;
     }
-    if (readerDone) {
-      extractDone = extractThread.timed_join(boost::posix_time::millisec(100));
-      // don't cancel extractor before reader is done or else reader may be stuck trying
-      // to write to a queue
-      if (canceled) {
-        // ensure the extract thread wakes up.
-        extractThread.interrupt();
-        bufferCount.post();
+    recordOffset += entry.files.size() * 16;
+  }
+
+  auto packed = files.begin();
+  for (const FolderEntry& entry : entries) {
+    if (hasDirNames) {
+      writeBString(outfile, entry.path);
+    }
+
+    for (const auto& hashFile : entry.files) {
+      BSAUInt size = packed->storedSize;
+      if (size > File::SIZEMASK) {
+        return ERROR_INVALIDDATA;
+      }
+      if (packed->compress != defaultCompressed()) {
+        // the flag inverts the default of the archive
+        size |= 1 << 30;
       }
+      writeType<BSAHash>(outfile, hashFile.first);
+      writeType<BSAUInt>(outfile, size);
+      writeType<BSAUInt>(outfile, static_cast<BSAUInt>(packed->offset));
+      ++packed;
     }
-    size_t index = (std::min)(static_cast<size_t>(filesDone), fileList.size() - 1);
-    if (!progress((filesDone * 100) / static_cast<int>(fileList.size()),
-                  fileList[index]->getName()) &&
-        !canceled) {
-      readerThread.interrupt();
-      canceled = true;  // don't interrupt repeatedly
+  }
+
+  if (hasFileNames) {
+    for (const std::string& name : fileNames) {
+      writeZString(outfile, name);
     }
   }
 
   return ERROR_NONE;
 }
 
+// BA2 names are hashed with crc32
+static BSAUInt ba2Hash(std::string_view name)
+{
+  std::string nameLower(name);
+  for (char& c : nameLower) {
+    c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    if (c == '/') {
+      c = '\\';
+    }
+  }
+  return static_cast<BSAUInt>(crc32(0, reinterpret_cast<const Bytef*>(nameLower.data()),
+                                    static_cast<uInt>(nameLower.length())));
+}
+
+EErrorCode Archive::writeBA2(std::fstream& outfile, unsigned int threadCount)
+{
+  static const BSAUInt recordSize = 36;
+
+  // starfield added fields to the header, see readMappedBA2()
+  BSAUInt headerSize;
+  switch (m_Type) {
+  case TYPE_STARFIELD:
+    headerSize = 32;
+    break;
+  case TYPE_STARFIELD_LZ4_TEXTURE:
+    headerSize = 36;
+    break;
+  default:
+    headerSize = 24;
+  }
+
+  // unlike bsas, files may be placed in the root folder
+  std::vector<Folder::Ptr> folders{m_RootFolder};
+  m_RootFolder->collectFolders(folders);
+
+  std::vector<PackedFile> files;
+  std::vector<BSAUInt> dirHashes;
+  for (const Folder::Ptr& folder : folders) {
+    const std::string folderPath = folder->getFullPath();
+    const BSAUInt dirHash        = ba2Hash(folderPath);
+
+    for (const File::Ptr& file : folder->m_Files) {
+      // only general archives are written, textures would need DX10 records
+      if (!file->m_TextureChunks.empty()) {
+        return ERROR_UNSUPPORTED;
+      }
+
+      PackedFile packed;
+      packed.file     = file;
+      packed.path     = folderPath.empty() ? file->m_Name
+                                           : folderPath + "\\" + file->m_Name;
+      packed.compress = file->compressToggled() != defaultCompressed();
+
+      if (packed.path.length() > 0xFFFF) {
+        return ERROR_INVALIDDATA;
+      }
+
+      files.push_back(std::move(packed));
+      dirHashes.push_back(dirHash);
+    }
+  }
+
+  outfile.seekp(headerSize + files.size() * recordSize, fstream::beg);
+  const EErrorCode result = writeFileData(outfile, files, threadCount);
+  if (result != ERROR_NONE) {
+    return result;
+  }
+
+  // the name table follows the data
+  const BSAHash nameTableOffset = static_cast<BSAHash>(outfile.tellp());
+  for (const PackedFile& file : files) {
+    writeType<BSAUShort>(outfile, static_cast<BSAUShort>(file.path.length()));
+    outfile.write(file.path.c_str(), file.path.length());
+  }
+
+  outfile.seekp(0, fstream::beg);
+  outfile.write("BTDX", 4);
+  writeType<BSAUInt>(outfile, typeToID(m_Type));
+  outfile.write("GNRL", 4);
+  writeType<BSAUInt>(outfile, static_cast<BSAUInt>(files.size()));
+  writeType<BSAHash>(outfile, nameTableOffset);
+  if (headerSize > 24) {
+    writeType<BSAUInt>(outfile, 1);
+    writeType<BSAUInt>(outfile, 0);
+  }
+  if (headerSize > 32) {
+    // compression method, lz4
+    writeType<BSAUInt>(outfile, 3);
+  }
+
+  for (size_t i = 0; i < files.size(); ++i) {
+    const PackedFile& file  = files[i];
+    const std::string& name = file.file->m_Name;
+    const size_t dot        = name.find_last_of('.');
+    const std::string_view stem(name.data(),
+                                dot == std::string::npos ? name.length() : dot);
+
+    char extension[4] = {};
+    if (dot != std::string::npos) {
+      for (size_t j = 0; j < 4 && dot + 1 + j < name.length(); ++j) {
+        extension[j] =
+            static_cast<char>(tolower(static_cast<unsigned char>(name[dot + 1 + j])));
+      }
+    }
+
+    writeType<BSAUInt>(outfile, ba2Hash(stem));
+    outfile.write(extension, 4);
+    writeType<BSAUInt>(outfile, dirHashes[i]);
+    writeType<BSAUInt>(outfile, 0x00100100);
+    writeType<BSAHash>(outfile, file.offset);
+    writeType<BSAUInt>(outfile, file.compress ? file.storedSize : 0);
+    writeType<BSAUInt>(outfile, file.uncompressedSize);
+    writeType<BSAUInt>(outfile, 0xBAADF00D);
+  }
+
+  return ERROR_NONE;
+}
+
+EErrorCode Archive::write(const char* fileName, unsigned int threadCount)
+{
+  if (m_Type == TYPE_MORROWIND) {
+    return ERROR_UNSUPPORTED;
+  }
+
+  if (m_Type != m_SourceType) {
+    // files from the archive are stored the way its type dictates
+    std::vector<File::Ptr> fileList;
+    m_RootFolder->collectFiles(fileList);
+    for (const File::Ptr& file : fileList) {
+      if (!file->m_New) {
+        return ERROR_UNSUPPORTED;
+      }
+    }
+  }
+
+  std::fstream outfile;
+  outfile.open(fileName, fstream::out | fstream::binary | fstream::trunc);
+  if (!outfile.is_open()) {
+    return ERROR_ACCESSFAILED;
+  }
+  outfile.exceptions(std::ios_base::badbit);
+
+  EErrorCode result;
+  try {
+    result = isBA2() ? writeBA2(outfile, threadCount) : writeTES4(outfile, threadCount);
+  } catch (const std::ios_base::failure&) {
+    result = ERROR_INVALIDDATA;
+  }
+
+  outfile.close();
+  return result;
+}
+
 bool Archive::compressed(const File::Ptr& file) const
 {
   if (m_Type != TYPE_FALLOUT4 && m_Type != TYPE_FALLOUT4NG_7 && m_Type != TYPE_FALLOUT4NG_8)
@@ -25,26 +25,24 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "bsafolder.h"
 #include "bsatypes.h"
 #include "errorcodes.h"
-#include <queue>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #ifndef Q_MOC_RUN
 #include <boost/function.hpp>
 #include <boost/shared_array.hpp>
 #endif  // Q_MOC_RUN
 
-namespace boost
-{
-class mutex;
-namespace interprocess
-{
-  class interprocess_semaphore;
-}
-}  // namespace boost
-
 namespace BSA
 {
 
 class File;
+class MappedFile;
+class MappedReader;
 
 /**
  * @brief top level structure to represent a bsa file
@@ -77,15 +75,26 @@ public:
    * @param fileName name of the file to read from
    * @param testHashes if true, the hashes of file names will be checked to ensure the
    * file is valid. This can be skipped for performance reasons
+   * @param mapFile if false, the records are parsed from the stream instead of a
+   * mapping of the file, this is mostly useful to compare both
    * @return ERROR_NONE on success or an error code
    */
-  EErrorCode read(const char* fileName, bool testHashes);
+  EErrorCode read(const char* fileName, bool testHashes, bool mapFile = true);
   /**
-   * write the archive to disc
-   * @param fileName name of the file to write to
-   * @return ERROR_NONE on success or an error code
+   * write the archive to disc. Files are compressed in parallel and written in a
+   * single pass, folders and files are sorted by hash like the games expect.
+   * TES4-style archives (Oblivion to Skyrim SE) and general BA2 (Fallout 4 and
+   * Starfield) are supported, texture archives are not.
+   * Files taken from an archive that was read can only be written with the type it
+   * was read as
+   * @param fileName name of the file to write to, must not be the archive that was
+   *                 read
+   * @param threadCount number of files compressed at the same time, 0 (default) for
+   *                    one per core
+   * @return ERROR_NONE on success, ERROR_UNSUPPORTED if the archive type can't be
+   *         written or the files were read from a DX10 archive, or an error code
    */
-  EErrorCode write(const char* fileName);
+  EErrorCode write(const char* fileName, unsigned int threadCount = 0);
   /**
    * @brief close the archive
    */
@@ -112,6 +121,28 @@ public:
    * @return ERROR_NONE on success or an error code
    */
   EErrorCode extract(File::Ptr file, const char* outputDirectory) const;
+  /**
+   * read the content of a file into memory, textures of BA2 archives get their DDS
+   * header like they do when extracted. Safe to call from several threads on the
+   * same archive
+   * @param file descriptor of the file to read
+   * @param data receives the content of the file
+   * @return ERROR_NONE on success or an error code
+   */
+  EErrorCode readFile(const File::Ptr& file, std::vector<unsigned char>& data) const;
+  /**
+   * read part of the content of a file into memory. Compressed files still have to
+   * be decompressed as a whole, but only the requested range is copied. Safe to call
+   * from several threads on the same archive
+   * @param file descriptor of the file to read
+   * @param offset position in the uncompressed content to start reading at
+   * @param size maximum number of bytes to read
+   * @param data receives the requested range, may be shorter than size if the file
+   *             ends first
+   * @return ERROR_NONE on success or an error code
+   */
+  EErrorCode readFile(const File::Ptr& file, BSAHash offset, size_t size,
+                      std::vector<unsigned char>& data) const;
   /**
    * @return archive flags
    */
@@ -124,12 +155,33 @@ public:
    *                        may be absolute or relative
    * @param progress callback function called on progress
    * @param overwrite if true (default) files are overwritten if they exist
-   * @return ERROR_NONE on success or an error code
+   * @param threadCount number of files extracted at the same time, 0 (default) for
+   *                    one per core
+   * @return ERROR_NONE on success, ERROR_CANCELED if the progress callback returned
+   *         false or the first error encountered
    */
   EErrorCode
   extractAll(const char* outputDirectory,
              const boost::function<bool(int value, std::string fileName)>& progress,
-             bool overwrite = true);
+             bool overwrite = true, unsigned int threadCount = 0);
+
+  /**
+   * check the integrity of all files: the data has to lie within the archive and
+   * decompress to the recorded size and, for archives that store name hashes, the
+   * hashes have to match the names. Files are checked in parallel, nothing is
+   * written
+   * @param progress callback function called on progress, may return false to cancel
+   * @param problems if not null, receives the path of every damaged file or folder
+   *                 together with the problem found
+   * @param threadCount number of files checked at the same time, 0 (default) for
+   *                    one per core
+   * @return ERROR_NONE if the archive is intact, ERROR_CANCELED if the progress
+   *         callback returned false or the first problem found
+   */
+  EErrorCode
+  verify(const boost::function<bool(int value, std::string fileName)>& progress,
+         std::vector<std::pair<std::string, EErrorCode>>* problems = nullptr,
+         unsigned int threadCount = 0) const;
 
   /**
    * @param file the file to check
@@ -141,7 +193,8 @@ public:
    * added to a folder, use BSA::Folder::addFile for that
    * @param name name of the file to be used inside the archive
    * @param sourceName filename path to the file to add
-   * @param compressed true if the file should be compressed (not supported yet!)
+   * @param compressed true if the file should be compressed when the archive is
+   *                   written
    * @return pointer to the new file
    */
   File::Ptr createFile(const std::string& name, const std::string& sourceName,
@@ -163,28 +216,58 @@ private:
     BSAHash nameTableOffset;
   };
 
-  struct FileInfo
-  {
-    File::Ptr file;
-    DataBuffer data;
-  };
+  // per-thread buffers and decompression state, see extractData()
+  struct DecompressionContext;
+
+  // a file being written, see write()
+  struct PackedFile;
+
+  // receives the data of a file as it is extracted, possibly in several pieces
+  typedef std::function<void(const unsigned char* data, size_t size)> DataSink;
+
+  // work done for a single file by processFiles()
+  typedef std::function<EErrorCode(const File::Ptr& file,
+                                   DecompressionContext& context)>
+      FileTask;
+
+  // folders of the directories seen while reading a name table, keyed by the
+  // directory as spelled in the archive
+  typedef std::unordered_map<std::string_view, Folder::Ptr> DirectoryCache;
 
 private:
   static Header readHeader(std::fstream& infile);
+  static Header readHeader(MappedReader& reader);
 
-  static ArchiveType typeFromID(BSAULong typeID);
+  EErrorCode readStream(const char* fileName, bool testHashes);
+  EErrorCode readMapped(const MappedFile& file, const char* fileName,
+                        bool testHashes);
+  EErrorCode readMappedBA2(MappedReader& reader, const Header& header);
+  EErrorCode readMappedMorrowind(MappedReader& reader, const Header& header);
+  EErrorCode readMappedTES4(MappedReader& reader, const Header& header,
+                            bool testHashes);
 
-  static boost::shared_array<unsigned char> decompress(unsigned char* inBuffer,
-                                                       BSAULong inSize,
-                                                       EErrorCode& result,
-                                                       BSAULong& outSize);
+  void addArchiveFile(DirectoryCache& directories, std::string_view filePath,
+                      BSAUInt size, BSAHash offset, BSAUInt uncompressedSize,
+                      FO4TextureHeader header, std::vector<FO4TextureChunk>& texChunks);
+
+  static ArchiveType typeFromID(BSAULong typeID);
 
   BSAULong typeToID(ArchiveType type);
 
   Folder readFolderRecord(std::fstream& file);
 
-  //  EErrorCode extractDirect(const File &fileInfo, std::ofstream &outFile);
-  //  EErrorCode extractCompressed(const File &fileInfo, std::ofstream &outFile);
+  bool isBA2() const
+  {
+    return m_Type == TYPE_FALLOUT4 || m_Type == TYPE_STARFIELD ||
+           m_Type == TYPE_STARFIELD_LZ4_TEXTURE || m_Type == TYPE_FALLOUT4NG_7 ||
+           m_Type == TYPE_FALLOUT4NG_8;
+  }
+
+  // the folder and file records of TES4-style archives store hashes of the names
+  bool hasNameHashes() const { return !isBA2() && m_Type != TYPE_MORROWIND; }
+
+  // chunks of version 3 BA2 are compressed as lz4 blocks instead of zlib streams
+  bool lz4Chunks() const { return m_Type == TYPE_STARFIELD_LZ4_TEXTURE; }
 
   bool defaultCompressed() const { return m_ArchiveFlags & FLAG_DEFAULTCOMPRESSED; }
   // starting with FO3 the bsa may prefix the file name to the file blob if archive flag
@@ -202,8 +285,22 @@ private:
   BSAULong countCharacters(const std::vector<std::string>& list) const;
   BSAULong determineFileFlags(const std::vector<std::string>& fileList) const;
 
-  void writeHeader(std::fstream& outfile, BSAULong fileFlags, BSAULong numFolders,
-                   BSAULong folderNamesLength, BSAULong fileNamesLength);
+  /**
+   * load the content of a file, from disc or from the archive that was read, and
+   * compress it the way it's stored in the new archive. Safe to call from several
+   * threads as long as each uses its own context
+   */
+  EErrorCode packFile(PackedFile& file, DecompressionContext& context) const;
+
+  /**
+   * pack files in parallel and write their data in order at the current position of
+   * outfile, this sets the offset and stored size of every file
+   */
+  EErrorCode writeFileData(std::fstream& outfile, std::vector<PackedFile>& files,
+                           unsigned int threadCount) const;
+
+  EErrorCode writeTES4(std::fstream& outfile, unsigned int threadCount);
+  EErrorCode writeBA2(std::fstream& outfile, unsigned int threadCount);
 
   DirectX::DDS_HEADER getDDSHeader(File::Ptr file,
                                    DirectX::DDS_HEADER_DXT10& DX10Header,
@@ -211,32 +308,98 @@ private:
   void getDX10Header(DirectX::DDS_HEADER_DXT10& DX10Header, File::Ptr file,
                      DirectX::DDS_HEADER DDSHeader) const;
 
-  EErrorCode extractDirect(File::Ptr file, std::ofstream& outFile) const;
-  EErrorCode extractCompressed(File::Ptr file, std::ofstream& outFile) const;
-
   void createFolders(const std::string& targetDirectory, Folder::Ptr folder);
 
-  void readFiles(std::queue<FileInfo>& queue, boost::mutex& mutex,
-                 boost::interprocess::interprocess_semaphore& bufferCount,
-                 boost::interprocess::interprocess_semaphore& queueFree,
-                 std::vector<File::Ptr>::iterator begin,
-                 std::vector<File::Ptr>::iterator end);
+  /**
+   * @return pointer to size bytes at offset in the archive. This points into the
+   *         mapping if the archive is mapped, otherwise the data is read into buffer.
+   *         Safe to call from several threads
+   * @throw data_invalid_exception if the data can't be read
+   */
+  const unsigned char* fileData(BSAHash offset, size_t size,
+                                std::vector<unsigned char>& buffer) const;
+
+  // receives consecutive blocks of data, returns false to stop reading
+  typedef std::function<bool(const unsigned char* data, size_t size)> BlockCallback;
+
+  /**
+   * pass size bytes at offset in the archive to callback. Mapped archives pass the
+   * whole range at once, otherwise it's read in blocks of bounded size. Safe to call
+   * from several threads
+   */
+  void readBlocks(BSAHash offset, size_t size, std::vector<unsigned char>& buffer,
+                  const BlockCallback& callback) const;
+
+  /**
+   * decompress a zlib stream at offset in the archive, passing the output to sink in
+   * blocks of bounded size
+   * @return true if unpackedSize bytes were decompressed
+   */
+  bool inflateBlocks(DecompressionContext& context, BSAHash offset, size_t packedSize,
+                     size_t unpackedSize, const DataSink& sink) const;
+
+  /**
+   * decompress an lz4 frame at offset in the archive, see inflateBlocks()
+   */
+  bool decompressFrameBlocks(DecompressionContext& context, BSAHash offset,
+                             size_t packedSize, size_t unpackedSize,
+                             const DataSink& sink) const;
+
+  /**
+   * decompress a compressed BA2 chunk, or a general file, at offset in the archive,
+   * see inflateBlocks()
+   */
+  bool decompressChunk(DecompressionContext& context, BSAHash offset,
+                       size_t packedSize, size_t unpackedSize,
+                       const DataSink& sink) const;
+
+  void writeDDSHeader(const File::Ptr& file, const DataSink& sink) const;
 
-  void extractFiles(const std::string& targetDirectory, std::queue<FileInfo>& queue,
-                    boost::mutex& mutex,
-                    boost::interprocess::interprocess_semaphore& bufferCount,
-                    boost::interprocess::interprocess_semaphore& queueFree,
-                    int totalFiles, bool overwrite, int& filesDone);
+  /**
+   * decompress a file and pass its content to sink. Safe to call from several
+   * threads as long as each uses its own context
+   */
+  EErrorCode extractData(const File::Ptr& file, DecompressionContext& context,
+                         const DataSink& sink) const;
+
+  EErrorCode extractFile(const File::Ptr& file, const std::string& targetDirectory,
+                         bool overwrite, DecompressionContext& context) const;
+
+  /**
+   * run task for every file on threadCount workers, each with its own context, while
+   * progress is reported from the calling thread. Files are handed out in the order
+   * of their data so reads stay mostly sequential
+   * @return ERROR_CANCELED if the progress callback returned false, otherwise the
+   *         first error returned by task
+   */
+  EErrorCode
+  processFiles(std::vector<File::Ptr>& files,
+               const boost::function<bool(int value, std::string fileName)>& progress,
+               unsigned int threadCount, const FileTask& task) const;
+
+  // contexts are pooled so concurrent readFile() calls don't share state and
+  // sequential calls don't set up decompression every time
+  std::unique_ptr<DecompressionContext> acquireContext() const;
+  void releaseContext(std::unique_ptr<DecompressionContext> context) const;
 
   void cleanFolder(Folder::Ptr folder);
 
 private:
   mutable std::fstream m_File;
+  // guards m_File while extracting from an archive that isn't mapped
+  mutable std::mutex m_FileMutex;
+  std::unique_ptr<MappedFile> m_Mapping;
+
+  mutable std::mutex m_ContextMutex;
+  mutable std::vector<std::unique_ptr<DecompressionContext>> m_Contexts;
 
   Folder::Ptr m_RootFolder;
 
   BSAULong m_ArchiveFlags;
   ArchiveType m_Type;
+  // type the archive was read as, files read from it are decompressed accordingly so
+  // write() doesn't convert them to another type
+  ArchiveType m_SourceType;
 };
 
 }  // namespace BSA
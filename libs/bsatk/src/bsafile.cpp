@@ -40,11 +40,8 @@ bool ByOffset(const File::Ptr& LHS, const File::Ptr& RHS)
   return LHS->getDataOffset() < RHS->getDataOffset();
 }
 
-static const unsigned long CHUNK_SIZE = 128 * 1024;
-
 File::File(std::fstream& file, Folder* folder)
-    : m_Folder(folder), m_New(false), m_FileSize(0), m_UncompressedFileSize(0),
-      m_ToggleCompressedWrite(false), m_DataOffsetWrite(0)
+    : m_Folder(folder), m_New(false), m_FileSize(0), m_UncompressedFileSize(0)
 {
   m_NameHash         = readType<BSAHash>(file);
   m_FileSize         = readType<BSAULong>(file);
@@ -53,13 +50,18 @@ File::File(std::fstream& file, Folder* folder)
   m_FileSize         = m_FileSize & SIZEMASK;
 }
 
+File::File(Folder* folder, BSAHash nameHash, BSAULong sizeFlags, BSAULong dataOffset)
+    : m_Folder(folder), m_New(false), m_NameHash(nameHash),
+      m_FileSize(sizeFlags & SIZEMASK), m_UncompressedFileSize(0),
+      m_DataOffset(dataOffset), m_ToggleCompressed((sizeFlags & COMPRESSMASK) != 0)
+{}
+
 File::File(const std::string& name, Folder* folder, BSAULong fileSize,
            BSAHash dataOffset, BSAULong uncompressedFileSize, FO4TextureHeader header,
            std::vector<FO4TextureChunk>& texChunks)
     : m_Folder(folder), m_New(false), m_Name(name), m_FileSize(fileSize),
       m_UncompressedFileSize(uncompressedFileSize), m_DataOffset(dataOffset),
-      m_TextureHeader(header), m_ToggleCompressedWrite(false),
-      m_TextureChunks(texChunks), m_DataOffsetWrite(0)
+      m_TextureHeader(header), m_TextureChunks(texChunks)
 {
   m_NameHash         = calculateBSAHash(name);
   m_ToggleCompressed = false;
@@ -71,8 +73,7 @@ File::File(const std::string& name, const std::string& sourceFile, Folder* folde
            bool toggleCompressed)
     : m_Folder(folder), m_New(true), m_Name(name), m_FileSize(0),
       m_UncompressedFileSize(0), m_DataOffset(0), m_ToggleCompressed(toggleCompressed),
-      m_SourceFile(sourceFile), m_ToggleCompressedWrite(toggleCompressed),
-      m_DataOffsetWrite(0)
+      m_SourceFile(sourceFile)
 {
   m_NameHash = calculateBSAHash(name);
 }
@@ -82,61 +83,6 @@ std::string File::getFilePath() const
   return m_Folder->getFullPath() + "\\" + m_Name;
 }
 
-void File::writeHeader(fstream& file) const
-{
-  writeType<BSAHash>(file, m_NameHash);
-  BSAULong size = m_FileSize;
-  if (m_ToggleCompressed) {
-    size |= (1 << 30);
-  }
-  writeType<BSAULong>(file, size);
-  writeType<BSAULong>(file, m_DataOffsetWrite);
-}
-
-EErrorCode File::writeData(fstream& sourceArchive, fstream& targetArchive) const
-{
-  m_DataOffsetWrite = static_cast<BSAULong>(targetArchive.tellp());
-  EErrorCode result = ERROR_NONE;
-
-  std::unique_ptr<char[]> inBuffer(new char[CHUNK_SIZE]);
-
-  if (m_SourceFile.length() == 0) {
-    // copy from source archive
-#pragma message("we may have to compress/decompress!")
-    sourceArchive.seekg(m_DataOffset, fstream::beg);
-
-    try {
-      unsigned long sizeLeft = m_FileSize;
-      while (sizeLeft > 0) {
-        int chunkSize = (std::min)(sizeLeft, CHUNK_SIZE);
-        sourceArchive.read(inBuffer.get(), chunkSize);
-        targetArchive.write(inBuffer.get(), chunkSize);
-        sizeLeft -= chunkSize;
-      }
-    } catch (const std::exception&) {
-      result = ERROR_INVALIDDATA;
-    }
-  } else {
-    // copy from file on disc
-    fstream sourceFile;
-    sourceFile.open(m_SourceFile.c_str());
-    if (!sourceFile.is_open()) {
-      return ERROR_SOURCEFILEMISSING;
-    }
-    sourceFile.seekg(0, fstream::end);
-    m_FileSize             = static_cast<BSAULong>(sourceFile.tellg());
-    unsigned long sizeLeft = m_FileSize;
-    sourceFile.seekg(0, fstream::beg);
-    while (sizeLeft > 0) {
-      int chunkSize = (std::min)(sizeLeft, CHUNK_SIZE);
-      sourceFile.read(inBuffer.get(), chunkSize);
-      targetArchive.write(inBuffer.get(), chunkSize);
-      sizeLeft -= chunkSize;
-    }
-  }
-  return result;
-}
-
 void File::readFileName(fstream& file, bool testHashes)
 {
   m_Name = readZString(file);
@@ -78,6 +78,15 @@ private:
    */
   File(std::fstream& file, Folder* folder);
 
+  /**
+   * construct file from a file record of a mapped archive
+   * @param folder the folder to add the file to
+   * @param nameHash hash of the file name
+   * @param sizeFlags the file size with the compression toggle in the upper bits
+   * @param dataOffset the offset of the file data in the archive
+   */
+  File(Folder* folder, BSAHash nameHash, BSAULong sizeFlags, BSAULong dataOffset);
+
   /**
    * construct file from morrowind BSA or BA2
    * @param name of the base file from source archive
@@ -111,8 +120,6 @@ private:
    *         an archive
    */
   BSAHash getDataOffset() const { return m_DataOffset; }
-  void writeHeader(std::fstream& file) const;
-  EErrorCode writeData(std::fstream& sourceArchive, std::fstream& targetArchive) const;
 
   void setFileSize(BSAULong fileSize) { m_FileSize = fileSize; }
 
@@ -133,8 +140,6 @@ private:
   std::vector<FO4TextureChunk> m_TextureChunks;
 
   std::string m_SourceFile;
-  bool m_ToggleCompressedWrite;
-  mutable BSAULong m_DataOffsetWrite;
 };
 
 extern bool ByOffset(const File::Ptr& LHS, const File::Ptr& RHS);
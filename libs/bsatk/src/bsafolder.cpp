@@ -18,7 +18,7 @@ License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
-#include <filesystem>
+#include <cctype>
 #include <limits.h>
 
 #include "bsaarchive.h"
@@ -31,6 +31,15 @@ using std::fstream;
 namespace BSA
 {
 
+static std::string foldCase(std::string_view name)
+{
+  std::string result(name);
+  for (char& c : result) {
+    c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+  }
+  return result;
+}
+
 Folder::Folder() : m_Parent(nullptr), m_Name()
 {
   m_NameHash  = calculateBSAHash(m_Name);
@@ -43,8 +52,8 @@ Folder::Ptr Folder::readFolder(std::fstream& file, BSAUInt fileNamesLength,
 {
   Folder::Ptr result(new Folder());
   result->m_NameHash  = readType<BSAHash>(file);
-  result->m_FileCount = readType<unsigned long>(file);
-  result->m_Offset    = readType<unsigned long>(file);
+  result->m_FileCount = readType<BSAULong>(file);
+  result->m_Offset    = readType<BSAULong>(file);
   std::streamoff pos  = file.tellg();
 
   file.seekg(result->m_Offset - fileNamesLength, fstream::beg);
@@ -91,36 +100,6 @@ Folder::Ptr Folder::readFolderSE(std::fstream& file, BSAUInt fileNamesLength,
   return result;
 }
 
-void Folder::writeHeader(std::fstream& file) const
-{
-  writeType<BSAHash>(file, m_NameHash);
-  writeType<BSAULong>(file, static_cast<BSAULong>(m_Files.size()));
-  writeType<BSAULong>(file, m_OffsetWrite);
-}
-
-void Folder::writeData(std::fstream& file, BSAULong fileNamesLength) const
-{
-  m_OffsetWrite = static_cast<BSAULong>(file.tellp()) + fileNamesLength;
-  writeBString(file, getFullPath());
-  for (std::vector<File::Ptr>::const_iterator iter = m_Files.begin();
-       iter != m_Files.end(); ++iter) {
-    (*iter)->writeHeader(file);
-  }
-}
-
-EErrorCode Folder::writeFileData(std::fstream& sourceFile,
-                                 std::fstream& targetFile) const
-{
-  for (std::vector<File::Ptr>::const_iterator iter = m_Files.begin();
-       iter != m_Files.end(); ++iter) {
-    EErrorCode error = (*iter)->writeData(sourceFile, targetFile);
-    if (error != ERROR_NONE) {
-      return error;
-    }
-  }
-  return ERROR_NONE;
-}
-
 std::string Folder::getFullPath() const
 {
   if (m_Parent != nullptr) {
@@ -138,78 +117,78 @@ std::string Folder::getFullPath() const
 
 void Folder::addFolderInt(Folder::Ptr folder)
 {
-  for (std::vector<Folder::Ptr>::iterator iter = m_SubFolders.begin();
-       iter != m_SubFolders.end(); ++iter) {
-    // for folder to be a subfolder of iter, the name of iter has to be the
-    // first path component of folders path and there has to be room left for a
-    // backslash and the name of folder itself
-    size_t nameLength = (*iter)->m_Name.length();
-    if ((folder->m_Name.length() > (*iter)->m_Name.length()) &&
-        (folder->m_Name.compare(0, (*iter)->m_Name.length(), (*iter)->m_Name) == 0) &&
-        ((folder->m_Name[nameLength] == '\\') || (folder->m_Name[nameLength] == '/'))) {
-      // remove the matched part of the path and recurse
-      folder->m_Name = folder->m_Name.substr((*iter)->m_Name.length() + 1);
-      (*iter)->addFolderInt(folder);
-      return;
-    }
+  const std::string path = folder->m_Name;
+
+  // create the folders for the leading path components, if necessary
+  Folder* parent        = this;
+  std::string_view name = path;
+
+  std::string_view::size_type pos = name.find_last_of("\\/");
+  if (pos != std::string_view::npos) {
+    parent = addFolderPath(name.substr(0, pos)).get();
+    name   = name.substr(pos + 1);
   }
 
-  // no subfolder matches, create one
-  std::string::size_type pos = folder->m_Name.find_first_of("\\/");
-  if (pos == std::string::npos) {
-    // no more path components, add the new folder right here
-    folder->m_Parent = this;
-    m_SubFolders.push_back(folder);
+  folder->m_Name   = std::string(name);
+  folder->m_Parent = parent;
+
+  Folder::Ptr existing = parent->findSubFolder(name);
+  if (!existing) {
+    parent->insertSubFolder(folder);
+  } else if (existing->m_Files.empty()) {
+    // the folder was created as the parent of a folder read earlier, take its place
+    folder->m_SubFolders     = std::move(existing->m_SubFolders);
+    folder->m_SubFolderIndex = std::move(existing->m_SubFolderIndex);
+    for (const Folder::Ptr& subFolder : folder->m_SubFolders) {
+      subFolder->m_Parent = folder.get();
+    }
+    parent->m_SubFolders[parent->m_SubFolderIndex[foldCase(name)]] = folder;
   } else {
-    // add dummy folder for the next path component
-    Folder::Ptr dummy(new Folder);
-    dummy->m_Parent = this;
-    dummy->m_Name   = folder->m_Name.substr(0, pos);
-    folder->m_Name  = folder->m_Name.substr(pos + 1);
-    dummy->addFolderInt(folder);
-    m_SubFolders.push_back(dummy);
+    // the same folder is stored twice, keep both
+    parent->m_SubFolders.push_back(folder);
   }
 }
 
-Folder::Ptr Folder::addOrFindFolderInt(Folder* folder)
+Folder::Ptr Folder::addFolderPath(std::string_view path)
 {
-  for (std::vector<Folder::Ptr>::iterator iter = m_SubFolders.begin();
-       iter != m_SubFolders.end(); ++iter) {
-    // for folder to be a subfolder of iter, the name of iter has to be the
-    // first path component of folders path and there has to be room left for a
-    // backslash and the name of folder itself
-    size_t nameLength = (*iter)->m_Name.length();
-    if ((folder->m_Name.length() > (*iter)->m_Name.length()) &&
-        (folder->m_Name.compare(0, (*iter)->m_Name.length(), (*iter)->m_Name) == 0) &&
-        ((folder->m_Name[nameLength] == '\\') || (folder->m_Name[nameLength] == '/'))) {
-      // remove the matched part of the path and recurse
-      folder->m_Name = folder->m_Name.substr((*iter)->m_Name.length() + 1);
-      return (*iter)->addOrFindFolderInt(folder);
-    } else {
-      std::string::size_type pos = folder->m_Name.find_first_of("\\/");
-      if (pos == std::string::npos && (*iter)->m_Name.compare(folder->m_Name) == 0) {
-        return *iter;
-      }
+  Folder* current = this;
+  Folder::Ptr result;
+
+  for (;;) {
+    std::string_view::size_type pos = path.find_first_of("\\/");
+    std::string_view name           = path.substr(0, pos);
+
+    result = current->findSubFolder(name);
+    if (!result) {
+      result.reset(new Folder);
+      result->m_Parent = current;
+      result->m_Name   = std::string(name);
+      current->insertSubFolder(result);
     }
+
+    if (pos == std::string_view::npos) {
+      return result;
+    }
+
+    current = result.get();
+    path    = path.substr(pos + 1);
   }
+}
 
-  // no subfolder matches, create one
-  std::string::size_type pos = folder->m_Name.find_first_of("\\/");
-  if (pos == std::string::npos) {
-    // no more path components, add the new folder right here
-    folder->m_Parent = this;
-    m_SubFolders.push_back(Folder::Ptr(folder));
-    return m_SubFolders.back();
-  } else {
-    // add dummy folder for the next path component
-    Folder::Ptr dummy(new Folder);
-    dummy->m_Parent    = this;
-    dummy->m_Name      = folder->m_Name.substr(0, pos);
-    folder->m_Name     = folder->m_Name.substr(pos + 1);
-    Folder::Ptr result = dummy->addOrFindFolderInt(folder);
-    m_SubFolders.push_back(dummy);
-    return result;
+Folder::Ptr Folder::findSubFolder(std::string_view name) const
+{
+  auto iter = m_SubFolderIndex.find(foldCase(name));
+  if (iter == m_SubFolderIndex.end()) {
+    return Folder::Ptr();
   }
+  return m_SubFolders[iter->second];
+}
+
+void Folder::insertSubFolder(const Folder::Ptr& folder)
+{
+  // the first folder with a name stays indexed if there are duplicates
+  m_SubFolderIndex.emplace(foldCase(folder->m_Name), m_SubFolders.size());
+  m_SubFolders.push_back(folder);
 }
 
 Folder::Ptr Folder::addFolder(std::fstream& file, BSAUInt fileNamesLength,
@@ -225,32 +204,35 @@ Folder::Ptr Folder::addFolder(std::fstream& file, BSAUInt fileNamesLength,
   return temp;
 }
 
-Folder::Ptr Folder::addFolderFromFile(std::string filePath, BSAUInt size,
+Folder::Ptr Folder::addFolderFromFile(std::string_view filePath, BSAUInt size,
                                       BSAHash offset, BSAUInt uncompressedSize,
                                       FO4TextureHeader header,
                                       std::vector<FO4TextureChunk>& texChunks)
 {
-  std::filesystem::path file(filePath);
+  std::string_view::size_type pos = filePath.find_last_of("\\/");
 
-  Folder* tempFolder = new Folder();
-
-  tempFolder->m_NameHash = calculateBSAHash(filePath);
-  tempFolder->m_Name     = file.parent_path().string();
-  Folder::Ptr result     = addOrFindFolderInt(tempFolder);
-
-  if (result.get() != tempFolder) {
-    delete tempFolder;
+  Folder::Ptr result;
+  if (pos == std::string_view::npos) {
+    result = addFolderPath(std::string_view());
+    result->addArchiveFile(filePath, size, offset, uncompressedSize, header, texChunks);
+  } else {
+    result = addFolderPath(filePath.substr(0, pos));
+    result->addArchiveFile(filePath.substr(pos + 1), size, offset, uncompressedSize,
+                           header, texChunks);
   }
 
-  std::string fileName = file.filename().string();
-
-  result->m_FileCount++;
-  result->m_Files.push_back(File::Ptr(new File(fileName, result.get(), size, offset,
-                                               uncompressedSize, header, texChunks)));
-
   return result;
 }
 
+void Folder::addArchiveFile(std::string_view name, BSAUInt size, BSAHash offset,
+                            BSAUInt uncompressedSize, FO4TextureHeader header,
+                            std::vector<FO4TextureChunk>& texChunks)
+{
+  m_FileCount++;
+  m_Files.push_back(File::Ptr(new File(std::string(name), this, size, offset,
+                                       uncompressedSize, header, texChunks)));
+}
+
 bool Folder::resolveFileNames(std::fstream& file, bool testHashes)
 {
   bool hashesValid = true;
@@ -290,7 +272,7 @@ Folder::Ptr Folder::addFolder(const std::string& folderName)
   Folder::Ptr newFolder(new Folder);
   newFolder->m_Name   = folderName;
   newFolder->m_Parent = this;
-  m_SubFolders.push_back(newFolder);
+  insertSubFolder(newFolder);
   return newFolder;
 }
 
@@ -26,6 +26,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "errorcodes.h"
 #include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace BSA
@@ -123,12 +125,24 @@ private:
   void addFolderInt(Folder::Ptr folder);
 
   /**
-   * recursive function that returns an existing folder match or generates the structure
-   * for a new folder
-   * @param folder folder to find or create
-   * @return the final determined / generated Folder
+   * returns the folder for a path relative to this one, missing folders are created.
+   * Path components are matched case-insensitively
+   * @param path path of the folder, components separated by backslashes or slashes
+   * @return the existing or new folder
    */
-  Folder::Ptr addOrFindFolderInt(Folder* folder);
+  Folder::Ptr addFolderPath(std::string_view path);
+
+  /**
+   * @param name name of a direct subfolder
+   * @return the subfolder with that name, compared case-insensitively, or an empty
+   * pointer
+   */
+  Folder::Ptr findSubFolder(std::string_view name) const;
+
+  /**
+   * add a folder as a direct subfolder and index its name
+   */
+  void insertSubFolder(const Folder::Ptr& folder);
 
   /**
    * Add a new folder to the structure.
@@ -137,15 +151,20 @@ private:
   Folder::Ptr addFolder(std::fstream& file, BSAUInt fileNamesLength, BSAUInt& endPos,
                         ArchiveType type);
 
-  Folder::Ptr addFolderFromFile(std::string filePath, BSAUInt size, BSAHash offset,
-                                BSAUInt uncompressedSize, FO4TextureHeader header,
+  Folder::Ptr addFolderFromFile(std::string_view filePath, BSAUInt size,
+                                BSAHash offset, BSAUInt uncompressedSize,
+                                FO4TextureHeader header,
                                 std::vector<FO4TextureChunk>& texChunks);
 
+  /**
+   * add a file from a BA2 or Morrowind archive to this folder
+   */
+  void addArchiveFile(std::string_view name, BSAUInt size, BSAHash offset,
+                      BSAUInt uncompressedSize, FO4TextureHeader header,
+                      std::vector<FO4TextureChunk>& texChunks);
+
   bool resolveFileNames(std::fstream& file, bool testHashes);
 
-  void writeHeader(std::fstream& file) const;
-  void writeData(std::fstream& file, BSAULong fileNamesLength) const;
-  EErrorCode writeFileData(std::fstream& sourceFile, std::fstream& targetFile) const;
   void collectFolders(std::vector<Folder::Ptr>& folderList) const;
   void collectFiles(std::vector<File::Ptr>& fileList) const;
   void collectFileNames(std::vector<std::string>& nameList) const;
@@ -158,9 +177,9 @@ private:
   BSAULong m_FileCount;
   BSAHash m_Offset;
   std::vector<Folder::Ptr> m_SubFolders;
+  // lowercase names of the subfolders to their index in m_SubFolders
+  std::unordered_map<std::string, size_t> m_SubFolderIndex;
   std::vector<File::Ptr> m_Files;
-
-  mutable BSAULong m_OffsetWrite;
 };
 
 }  // namespace BSA
@@ -0,0 +1,53 @@
+/*
+Mod Organizer BSA handling
+
+Copyright (C) 2012 Sebastian Herbord. All rights reserved.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "bsamapping.h"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace BSA
+{
+
+struct MappedFile::Mapping
+{
+  boost::interprocess::file_mapping file;
+  boost::interprocess::mapped_region region;
+};
+
+MappedFile::MappedFile(const char* fileName)
+    : m_Mapping(new Mapping), m_Data(nullptr), m_Size(0)
+{
+  using namespace boost::interprocess;
+
+  try {
+    m_Mapping->file   = file_mapping(fileName, read_only);
+    m_Mapping->region = mapped_region(m_Mapping->file, read_only);
+  } catch (const interprocess_exception& e) {
+    throw data_invalid_exception(
+        makeString("failed to map %s: %s", fileName, e.what()));
+  }
+
+  m_Data = static_cast<const unsigned char*>(m_Mapping->region.get_address());
+  m_Size = m_Mapping->region.get_size();
+}
+
+MappedFile::~MappedFile() {}
+
+}  // namespace BSA
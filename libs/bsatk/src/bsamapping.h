@@ -0,0 +1,161 @@
+/*
+Mod Organizer BSA handling
+
+Copyright (C) 2012 Sebastian Herbord. All rights reserved.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef BSAMAPPING_H
+#define BSAMAPPING_H
+
+#include "bsaexception.h"
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+namespace BSA
+{
+
+/**
+ * @brief read-only memory mapping of an archive
+ */
+class MappedFile
+{
+
+public:
+  /**
+   * map the whole file
+   * @param fileName name of the file to map
+   * @throw data_invalid_exception if the file can't be mapped
+   */
+  explicit MappedFile(const char* fileName);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&)            = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const unsigned char* data() const { return m_Data; }
+  size_t size() const { return m_Size; }
+
+private:
+  struct Mapping;
+
+  std::unique_ptr<Mapping> m_Mapping;
+  const unsigned char* m_Data;
+  size_t m_Size;
+};
+
+/**
+ * @brief bounds-checked cursor over mapped data. Strings are returned as views into
+ * the mapping, so nothing is copied until a name is actually stored
+ */
+class MappedReader
+{
+
+public:
+  MappedReader(const unsigned char* data, size_t size)
+      : m_Data(data), m_Size(size), m_Pos(0)
+  {}
+
+  size_t tell() const { return m_Pos; }
+
+  /**
+   * move the cursor to an absolute position
+   * @throw data_invalid_exception if the position is past the end of the data
+   */
+  void seek(size_t pos)
+  {
+    if (pos > m_Size) {
+      throw data_invalid_exception("can't read from bsa");
+    }
+    m_Pos = pos;
+  }
+
+  void skip(size_t size) { take(size); }
+
+  /**
+   * @return pointer to the next size bytes, the cursor is moved past them
+   * @throw data_invalid_exception if there are not enough bytes left
+   */
+  const unsigned char* take(size_t size)
+  {
+    if (size > m_Size - m_Pos) {
+      throw data_invalid_exception("can't read from bsa");
+    }
+    const unsigned char* result = m_Data + m_Pos;
+    m_Pos += size;
+    return result;
+  }
+
+  template <typename T>
+  T read()
+  {
+    return get<T>(take(sizeof(T)));
+  }
+
+  /**
+   * @return string of the given length, cut at the first null character
+   */
+  std::string_view readString(size_t length)
+  {
+    const char* begin = reinterpret_cast<const char*>(take(length));
+    const void* end   = memchr(begin, '\0', length);
+    return std::string_view(begin, end != nullptr
+                                       ? static_cast<const char*>(end) - begin
+                                       : length);
+  }
+
+  /**
+   * @return string prefixed with its length as a single byte
+   */
+  std::string_view readBString() { return readString(read<unsigned char>()); }
+
+  /**
+   * @return null-terminated string, the cursor is moved past the terminator
+   */
+  std::string_view readZString()
+  {
+    const char* begin = reinterpret_cast<const char*>(m_Data + m_Pos);
+    const void* end   = memchr(begin, '\0', m_Size - m_Pos);
+    if (end == nullptr) {
+      throw data_invalid_exception("can't read from bsa");
+    }
+    const size_t length = static_cast<const char*>(end) - begin;
+    m_Pos += length + 1;
+    return std::string_view(begin, length);
+  }
+
+  /**
+   * read a value from a record that was taken as a whole
+   */
+  template <typename T>
+  static T get(const unsigned char* data)
+  {
+    T value;
+    memcpy(&value, data, sizeof(T));
+    return value;
+  }
+
+private:
+  const unsigned char* m_Data;
+  size_t m_Size;
+  size_t m_Pos;
+};
+
+}  // namespace BSA
+
+#endif  // BSAMAPPING_H
@@ -41,7 +41,8 @@ typedef unsigned long long BSAHash;
 typedef unsigned char BSAUChar;
 typedef unsigned short BSAUShort;
 typedef unsigned int BSAUInt;
-typedef unsigned long BSAULong;
+// unsigned long is 64 bits outside of Windows but the archives store 32 bits
+typedef uint32_t BSAULong;
 typedef unsigned long long BSAHash;
 
 #endif  // WIN32
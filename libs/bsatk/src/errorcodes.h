@@ -33,7 +33,8 @@ enum EErrorCode
   ERROR_ACCESSFAILED,
   ERROR_ZLIBINITFAILED,
   ERROR_SOURCEFILEMISSING,
-  ERROR_CANCELED
+  ERROR_CANCELED,
+  ERROR_UNSUPPORTED
 };
 
 };
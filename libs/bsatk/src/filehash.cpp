@@ -20,6 +20,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "filehash.h"
 #include <algorithm>
+#include <cctype>
 #include <climits>
 #include <cstdlib>
 #include <cstring>
@@ -88,10 +89,43 @@ BSAHash calculateBSAHash(const std::string& fileName)
     } else if (strcmp(ext + 1, "wav") == 0) {
       hash1 |= 0x80000000;
     }
+  }
+
+  // names without an extension still hash the middle of the name
+  BSAHash hash2 = static_cast<BSAHash>(genHashInt(fileNameLowerU + 1, extU - 2)) +
+                  static_cast<BSAHash>(genHashInt(extU, extU + extLen));
+
+  hash1 |= (hash2 & 0xFFFFFFFF) << 32;
+
+  return hash1;
+}
+
+BSAHash calculateBSAFolderHash(const std::string& folderName)
+{
+  std::string nameLower(folderName);
+  for (char& c : nameLower) {
+    c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    if (c == '/') {
+      c = '\\';
+    }
+  }
+
+  const unsigned char* nameLowerU =
+      reinterpret_cast<const unsigned char*>(nameLower.c_str());
+  const size_t length = nameLower.length();
+
+  if (length == 0) {
+    return 0ULL;
+  }
 
-    BSAHash hash2 = static_cast<BSAHash>(genHashInt(fileNameLowerU + 1, extU - 2)) +
-                    static_cast<BSAHash>(genHashInt(extU, extU + strlen(ext)));
+  BSAHash hash1 = static_cast<BSAHash>(nameLowerU[length - 1]) |
+                  (static_cast<BSAHash>(length > 2 ? nameLowerU[length - 2] : 0) << 8) |
+                  (static_cast<BSAHash>(length) << 16) |
+                  (static_cast<BSAHash>(nameLowerU[0]) << 24);
 
+  if (length > 2) {
+    BSAHash hash2 =
+        static_cast<BSAHash>(genHashInt(nameLowerU + 1, nameLowerU + length - 2));
     hash1 |= (hash2 & 0xFFFFFFFF) << 32;
   }
 
@@ -26,4 +26,12 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 BSAHash calculateBSAHash(const std::string& fileName);
 
+/**
+ * @brief calculateBSAFolderHash
+ * @param folderName full path of the folder inside the archive
+ * @return hash of the folder as stored in the folder records. Unlike file names,
+ *         folder names are hashed as a whole, dots don't start an extension
+ */
+BSAHash calculateBSAFolderHash(const std::string& folderName);
+
 #endif  // FILEHASH_H
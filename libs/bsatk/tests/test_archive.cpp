@@ -0,0 +1,149 @@
+#pragma warning(push)
+#pragma warning(disable : 4668)
+#include <gtest/gtest.h>
+#pragma warning(pop)
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "bsaarchive.h"
+#include "testarchives.h"
+
+using TestArchives::archiveContent;
+using TestArchives::expectedContent;
+
+class WriteTest : public testing::TestWithParam<ArchiveType>
+{};
+
+// archives written from loose files are read back with the same content
+//
+TEST_P(WriteTest, LooseFiles)
+{
+  const auto directory = TestArchives::testDirectory("write");
+  const auto path      = directory / "archive";
+  const auto files     = TestArchives::generateFiles(300, 12);
+
+  ASSERT_EQ(BSA::ERROR_NONE, TestArchives::writeArchive(path, GetParam(), files));
+
+  BSA::Archive archive;
+  ASSERT_EQ(BSA::ERROR_NONE, archive.read(path.string().c_str(), true));
+  EXPECT_EQ(GetParam(), archive.getType());
+  EXPECT_EQ(expectedContent(files), archiveContent(archive));
+}
+
+// files taken from an archive that was read are repacked the same way
+//
+TEST_P(WriteTest, FromArchive)
+{
+  const auto directory = TestArchives::testDirectory("rewrite");
+  const auto path      = directory / "archive";
+  const auto copyPath  = directory / "copy";
+  const auto files     = TestArchives::generateFiles(300, 12);
+
+  ASSERT_EQ(BSA::ERROR_NONE, TestArchives::writeArchive(path, GetParam(), files));
+
+  BSA::Archive archive;
+  ASSERT_EQ(BSA::ERROR_NONE, archive.read(path.string().c_str(), true));
+  ASSERT_EQ(BSA::ERROR_NONE, archive.write(copyPath.string().c_str(), 2));
+
+  BSA::Archive copy;
+  ASSERT_EQ(BSA::ERROR_NONE, copy.read(copyPath.string().c_str(), true));
+  EXPECT_EQ(expectedContent(files), archiveContent(copy));
+}
+
+INSTANTIATE_TEST_SUITE_P(Archives, WriteTest,
+                         testing::Values(TYPE_OBLIVION, TYPE_FALLOUT3, TYPE_SKYRIMSE,
+                                         TYPE_FALLOUT4, TYPE_STARFIELD,
+                                         TYPE_STARFIELD_LZ4_TEXTURE));
+
+TEST(WriteTest, MorrowindUnsupported)
+{
+  const auto directory = TestArchives::testDirectory("morrowind");
+  const auto files     = TestArchives::generateFiles(10, 2);
+
+  EXPECT_EQ(BSA::ERROR_UNSUPPORTED,
+            TestArchives::writeArchive(directory / "archive", TYPE_MORROWIND, files));
+}
+
+namespace
+{
+
+template <class T>
+void put(std::ofstream& file, T value)
+{
+  file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// a texture archive with a single uncompressed 4x4 texture
+void writeTextureArchive(const std::filesystem::path& path)
+{
+  const std::string name = "textures\\test.dds";
+  const uint32_t size    = 16;
+
+  const uint64_t headerSize = 24;
+  const uint64_t recordSize = 24 + 24;
+  const uint64_t dataOffset = headerSize + recordSize;
+
+  std::ofstream file(path, std::ios::binary);
+
+  file.write("BTDX", 4);
+  put<uint32_t>(file, 1);
+  file.write("DX10", 4);
+  put<uint32_t>(file, 1);
+  put<uint64_t>(file, dataOffset + size);
+
+  // name hash, extension, directory hash
+  put<uint32_t>(file, 0);
+  file.write("dds\0", 4);
+  put<uint32_t>(file, 0);
+  // unknown, chunk count, chunk header size, height, width, mips, format (BC1),
+  // cubemap, unknown
+  put<uint8_t>(file, 0);
+  put<uint8_t>(file, 1);
+  put<uint16_t>(file, 24);
+  put<uint16_t>(file, 4);
+  put<uint16_t>(file, 4);
+  put<uint8_t>(file, 1);
+  put<uint8_t>(file, 71);
+  put<uint8_t>(file, 0);
+  put<uint8_t>(file, 0);
+  // offset, packed size, unpacked size, first and last mip, unknown
+  put<uint64_t>(file, dataOffset);
+  put<uint32_t>(file, 0);
+  put<uint32_t>(file, size);
+  put<uint16_t>(file, 0);
+  put<uint16_t>(file, 0);
+  put<uint32_t>(file, 0xBAADF00D);
+
+  file.write(std::string(size, 'x').data(), size);
+
+  put<uint16_t>(file, static_cast<uint16_t>(name.length()));
+  file.write(name.data(), name.length());
+}
+
+}  // namespace
+
+// textures of DX10 archives can't be written since only general archives are
+//
+TEST(WriteTest, TexturesUnsupported)
+{
+  const auto directory = TestArchives::testDirectory("textures");
+  const auto path      = directory / "textures.ba2";
+  writeTextureArchive(path);
+
+  BSA::Archive archive;
+  ASSERT_EQ(BSA::ERROR_NONE, archive.read(path.string().c_str(), false));
+
+  // the texture is extracted with a dds header in front of it
+  const auto content = archiveContent(archive);
+  ASSERT_EQ(1u, content.size());
+  EXPECT_EQ(std::string(16, 'x'), content.begin()->second.substr(
+                                      content.begin()->second.size() - 16));
+
+  EXPECT_EQ(BSA::ERROR_UNSUPPORTED,
+            archive.write((directory / "copy.ba2").string().c_str()));
+}
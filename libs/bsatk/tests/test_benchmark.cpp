@@ -0,0 +1,149 @@
+#pragma warning(push)
+#pragma warning(disable : 4668)
+#include <gtest/gtest.h>
+#pragma warning(pop)
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bsaarchive.h"
+#include "testarchives.h"
+
+// the benchmarks are disabled since generating the archives takes a while, run them
+// with
+//
+//   bsatk-tests --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*
+//
+// the number of files defaults to 100k and can be changed with the
+// BSATK_BENCHMARK_FILES environment variable
+//
+class BenchmarkTest : public testing::Test
+{
+protected:
+  static void SetUpTestSuite()
+  {
+    size_t fileCount = 100000;
+    if (const char* value = std::getenv("BSATK_BENCHMARK_FILES")) {
+      fileCount = std::strtoul(value, nullptr, 10);
+    }
+
+    directory() = TestArchives::testDirectory("benchmark");
+    files()     = TestArchives::generateFiles(fileCount, fileCount / 100 + 1);
+
+    ASSERT_EQ(BSA::ERROR_NONE,
+              TestArchives::writeArchive(generalArchive(), TYPE_FALLOUT4, files()));
+    ASSERT_EQ(BSA::ERROR_NONE,
+              TestArchives::writeArchive(sseArchive(), TYPE_SKYRIMSE, files()));
+
+    // one folder per file, spread over 16 parents
+    const auto folderFiles = TestArchives::generateFiles(fileCount, fileCount);
+    ASSERT_EQ(BSA::ERROR_NONE,
+              TestArchives::writeArchive(foldersArchive(), TYPE_FALLOUT4, folderFiles));
+  }
+
+  static void TearDownTestSuite()
+  {
+    files().clear();
+    std::filesystem::remove_all(directory());
+  }
+
+  static std::filesystem::path& directory()
+  {
+    static std::filesystem::path path;
+    return path;
+  }
+
+  static std::vector<TestArchives::GeneratedFile>& files()
+  {
+    static std::vector<TestArchives::GeneratedFile> files;
+    return files;
+  }
+
+  static std::filesystem::path generalArchive() { return directory() / "general.ba2"; }
+  static std::filesystem::path sseArchive() { return directory() / "sse.bsa"; }
+  static std::filesystem::path foldersArchive() { return directory() / "folders.ba2"; }
+
+  static void report(const char* what, double ms, size_t count)
+  {
+    std::printf("%-40s %10.1f ms %12.0f files/s\n", what, ms,
+                ms > 0 ? count * 1000.0 / ms : 0.0);
+  }
+};
+
+TEST_F(BenchmarkTest, DISABLED_Read)
+{
+  for (const auto& path : {generalArchive(), sseArchive()}) {
+    for (bool mapFile : {true, false}) {
+      BSA::Archive archive;
+      const double ms = TestArchives::measure([&] {
+        ASSERT_EQ(BSA::ERROR_NONE, archive.read(path.string().c_str(), false, mapFile));
+      });
+
+      const std::string what = path.filename().string() +
+                               (mapFile ? " read (mapped)" : " read (stream)");
+      report(what.c_str(), ms, files().size());
+    }
+  }
+}
+
+// the folders of BA2 archives are created from the path of every file
+//
+TEST_F(BenchmarkTest, DISABLED_ResolveFolders)
+{
+  for (bool mapFile : {true, false}) {
+    BSA::Archive archive;
+    const double ms = TestArchives::measure([&] {
+      ASSERT_EQ(BSA::ERROR_NONE,
+                archive.read(foldersArchive().string().c_str(), false, mapFile));
+    });
+
+    report(mapFile ? "folders.ba2 read (mapped)" : "folders.ba2 read (stream)", ms,
+           files().size());
+  }
+}
+
+// worker counts are doubled up to the number of cores, or 4 if there are fewer
+//
+TEST_F(BenchmarkTest, DISABLED_ExtractAll)
+{
+  const unsigned int maxWorkers = std::max(std::thread::hardware_concurrency(), 4u);
+  const auto output             = directory() / "output";
+
+  const auto extract = [&](BSA::Archive& archive, unsigned int workers) {
+    std::filesystem::remove_all(output);
+    std::filesystem::create_directories(output);
+
+    return TestArchives::measure([&] {
+      ASSERT_EQ(BSA::ERROR_NONE,
+                archive.extractAll(
+                    output.string().c_str(),
+                    [](int, std::string) {
+                      return true;
+                    },
+                    true, workers));
+    });
+  };
+
+  for (const auto& path : {generalArchive(), sseArchive()}) {
+    BSA::Archive archive;
+    ASSERT_EQ(BSA::ERROR_NONE, archive.read(path.string().c_str(), false));
+
+    // the first extraction is much slower whatever the number of workers, the file
+    // system is still busy with the archives that were just written
+    extract(archive, 0);
+
+    for (unsigned int workers = 1; workers <= maxWorkers; workers *= 2) {
+      const double ms        = extract(archive, workers);
+      const std::string what = path.filename().string() + " extractAll (" +
+                               std::to_string(workers) + " workers)";
+      report(what.c_str(), ms, files().size());
+    }
+  }
+
+  std::filesystem::remove_all(output);
+}
@@ -0,0 +1,36 @@
+#pragma warning(push)
+#pragma warning(disable : 4668)
+#include <gtest/gtest.h>
+#pragma warning(pop)
+
+#include "bsaarchive.h"
+#include "testarchives.h"
+
+using TestArchives::archiveContent;
+using TestArchives::expectedContent;
+
+class ReadTest : public testing::TestWithParam<ArchiveType>
+{};
+
+// the mapped and the stream parsers must give the same archive
+//
+TEST_P(ReadTest, MappedMatchesStream)
+{
+  const auto directory = TestArchives::testDirectory("read");
+  const auto path      = directory / "archive";
+  const auto files     = TestArchives::generateFiles(500, 20);
+
+  ASSERT_EQ(BSA::ERROR_NONE, TestArchives::writeArchive(path, GetParam(), files));
+
+  BSA::Archive mapped, stream;
+  ASSERT_EQ(BSA::ERROR_NONE, mapped.read(path.string().c_str(), true, true));
+  ASSERT_EQ(BSA::ERROR_NONE, stream.read(path.string().c_str(), true, false));
+
+  const auto expected = expectedContent(files);
+  EXPECT_EQ(expected, archiveContent(mapped));
+  EXPECT_EQ(expected, archiveContent(stream));
+}
+
+INSTANTIATE_TEST_SUITE_P(Archives, ReadTest,
+                         testing::Values(TYPE_FALLOUT3, TYPE_SKYRIMSE, TYPE_FALLOUT4,
+                                         TYPE_STARFIELD, TYPE_STARFIELD_LZ4_TEXTURE));
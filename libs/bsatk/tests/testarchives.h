@@ -0,0 +1,185 @@
+#ifndef BSATK_TESTARCHIVES_H
+#define BSATK_TESTARCHIVES_H
+
+#include "bsaarchive.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+// archives used by the tests and the benchmarks, the files are written to disk and
+// packed with BSA::Archive::write() since that's the only way to create an archive
+//
+namespace TestArchives
+{
+
+struct GeneratedFile
+{
+  // path in the archive, separated by backslashes
+  std::string path;
+  std::string content;
+};
+
+// content of a generated file, from a few bytes to a few kilobytes and repetitive
+// enough to be compressed
+//
+inline std::string fileContent(const std::string& path, size_t index)
+{
+  const std::string unit = path + ":" + std::to_string(index) + ";";
+
+  std::string content;
+  for (size_t i = 0; i < index % 64 + 1; ++i) {
+    content += unit;
+  }
+
+  return content;
+}
+
+// files spread evenly over the given number of folders, which are two levels deep
+//
+inline std::vector<GeneratedFile> generateFiles(size_t fileCount, size_t folderCount)
+{
+  std::vector<GeneratedFile> files;
+  files.reserve(fileCount);
+
+  for (size_t i = 0; i < fileCount; ++i) {
+    const size_t folder = i % folderCount;
+    std::string path    = "meshes\\group" + std::to_string(folder % 16) + "\\folder" +
+                       std::to_string(folder) + "\\file" + std::to_string(i) + ".nif";
+    std::string content = fileContent(path, i);
+
+    files.push_back({std::move(path), std::move(content)});
+  }
+
+  return files;
+}
+
+// writes the files next to the archive and packs them into an archive of the given
+// type, every other file is stored uncompressed
+//
+inline BSA::EErrorCode writeArchive(const std::filesystem::path& archivePath,
+                                    ArchiveType type,
+                                    const std::vector<GeneratedFile>& files,
+                                    unsigned int threadCount = 0)
+{
+  const auto looseDirectory = std::filesystem::path(archivePath).concat(".loose");
+  std::filesystem::remove_all(looseDirectory);
+  std::filesystem::create_directories(looseDirectory);
+
+  BSA::Archive archive;
+  archive.setType(type);
+
+  // Folder::addFolder() doesn't look for existing folders
+  std::map<std::string, BSA::Folder::Ptr> folders;
+
+  for (size_t i = 0; i < files.size(); ++i) {
+    const std::string source = (looseDirectory / std::to_string(i)).string();
+    std::ofstream(source, std::ios::binary) << files[i].content;
+
+    const size_t slash      = files[i].path.rfind('\\');
+    BSA::Folder::Ptr folder = archive.getRoot();
+
+    if (slash != std::string::npos) {
+      size_t start = 0;
+      for (;;) {
+        const size_t end       = files[i].path.find('\\', start);
+        const std::string path = files[i].path.substr(0, end);
+
+        auto itor = folders.find(path);
+        if (itor == folders.end()) {
+          itor = folders
+                     .emplace(path, folder->addFolder(files[i].path.substr(
+                                        start, end - start)))
+                     .first;
+        }
+
+        folder = itor->second;
+        if (end == slash) {
+          break;
+        }
+
+        start = end + 1;
+      }
+    }
+
+    folder->addFile(
+        archive.createFile(files[i].path.substr(slash + 1), source, i % 2 == 0));
+  }
+
+  const BSA::EErrorCode result =
+      archive.write(archivePath.string().c_str(), threadCount);
+  std::filesystem::remove_all(looseDirectory);
+
+  return result;
+}
+
+// path to content of every file in the archive, empty content for files that can't
+// be read
+//
+inline std::map<std::string, std::string> archiveContent(BSA::Archive& archive)
+{
+  std::map<std::string, std::string> result;
+
+  std::vector<BSA::Folder::Ptr> folders = {archive.getRoot()};
+  while (!folders.empty()) {
+    const BSA::Folder::Ptr folder = folders.back();
+    folders.pop_back();
+
+    for (unsigned int i = 0; i < folder->getNumSubFolders(); ++i) {
+      folders.push_back(folder->getSubFolder(i));
+    }
+
+    for (unsigned int i = 0; i < folder->getNumFiles(); ++i) {
+      const BSA::File::Ptr file = folder->getFile(i);
+
+      std::vector<unsigned char> data;
+      if (archive.readFile(file, data) != BSA::ERROR_NONE) {
+        data.clear();
+      }
+      result[file->getFilePath()] = std::string(data.begin(), data.end());
+    }
+  }
+
+  return result;
+}
+
+inline std::map<std::string, std::string>
+expectedContent(const std::vector<GeneratedFile>& files)
+{
+  std::map<std::string, std::string> result;
+  for (const auto& file : files) {
+    result[file.path] = file.content;
+  }
+
+  return result;
+}
+
+// directory for the files of a test, emptied when created
+//
+inline std::filesystem::path testDirectory(const std::string& name)
+{
+  const auto path = std::filesystem::temp_directory_path() / "bsatk-tests" / name;
+  std::filesystem::remove_all(path);
+  std::filesystem::create_directories(path);
+
+  return path;
+}
+
+// time taken by f, in milliseconds
+//
+template <class F>
+double measure(F&& f)
+{
+  const auto start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                   start)
+      .count();
+}
+
+}  // namespace TestArchives
+
+#endif  // BSATK_TESTARCHIVES_H
@@ -65,7 +65,7 @@ void ESP::File::init()
             break;
           case TES3SubRecord::TYPE_MAST:
             if (subRec.data().size() > 0)
-              m_Masters.insert(reinterpret_cast<const char*>(&subRec.data()[0]));
+              m_Masters.emplace_back(reinterpret_cast<const char*>(&subRec.data()[0]));
             break;
           }
         }
@@ -121,7 +121,7 @@ void ESP::File::onHEDR(const SubRecord& rec)
 void ESP::File::onMAST(const SubRecord& rec)
 {
   if (rec.data().size() > 0)
-    m_Masters.insert(reinterpret_cast<const char*>(&rec.data()[0]));
+    m_Masters.emplace_back(reinterpret_cast<const char*>(&rec.data()[0]));
 }
 
 void ESP::File::onCNAM(const SubRecord& rec)
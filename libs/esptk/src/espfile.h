@@ -4,8 +4,8 @@
 #include "record.h"
 #include "tes3record.h"
 #include <fstream>
-#include <set>
 #include <string>
+#include <vector>
 
 namespace ESP
 {
@@ -25,9 +25,13 @@ public:
   bool isMedium() const;
   bool isOverlay() const;
   bool isDummy() const;
+  uint16_t formVersion() const { return m_MainRecord.formVersion(); }
   std::string author() const { return m_Author; }
   std::string description() const { return m_Description; }
-  std::set<std::string> masters() const { return m_Masters; }
+
+  // in the order they are declared in the plugin, which is the order used to
+  // resolve form ids
+  const std::vector<std::string>& masters() const { return m_Masters; }
 
 private:
   void init();
@@ -61,7 +65,7 @@ private:
   std::string m_Author;
   std::string m_Description;
 
-  std::set<std::string> m_Masters;
+  std::vector<std::string> m_Masters;
 };
 
 }  // namespace ESP
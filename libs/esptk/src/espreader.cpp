@@ -0,0 +1,296 @@
+#include "espreader.h"
+#include "espexceptions.h"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <cstring>
+#include <zlib.h>
+
+namespace
+{
+
+// size of the record and group headers before skyrim, which added the form
+// version
+constexpr std::size_t OblivionHeaderSize = 20;
+constexpr std::size_t HeaderSize         = 24;
+
+// type, size
+constexpr std::size_t SubRecordHeaderSize = 6;
+
+// deflate cannot compress better than about 1032:1, a larger uncompressed size
+// comes from a corrupted record and would only cause a huge allocation
+constexpr std::size_t MaxCompressionRatio = 1032;
+
+template <class T>
+T readValue(const uint8_t* p)
+{
+  T value;
+  std::memcpy(&value, p, sizeof(T));
+  return value;
+}
+
+std::string_view readType(const uint8_t* p)
+{
+  return std::string_view(reinterpret_cast<const char*>(p), 4);
+}
+
+}  // namespace
+
+void ESP::SubRecordRange::iterator::read()
+{
+  if (m_Offset >= m_Data.size()) {
+    m_Offset = m_Data.size();
+    m_Next   = m_Offset;
+    return;
+  }
+
+  std::size_t offset = m_Offset;
+  if (m_Data.size() - offset < SubRecordHeaderSize) {
+    throw ESP::InvalidRecordException("sub-record incomplete");
+  }
+
+  std::size_t size = readValue<uint16_t>(&m_Data[offset + 4]);
+
+  // XXXX holds the size of the next sub-record, which is too large for the
+  // 16-bit size field
+  if (readType(&m_Data[offset]) == "XXXX") {
+    if (size != 4 || m_Data.size() - offset < SubRecordHeaderSize + 4 +
+                                                   SubRecordHeaderSize) {
+      throw ESP::InvalidRecordException("sub-record incomplete");
+    }
+
+    size = readValue<uint32_t>(&m_Data[offset + SubRecordHeaderSize]);
+    offset += SubRecordHeaderSize + 4;
+  }
+
+  const std::size_t dataOffset = offset + SubRecordHeaderSize;
+  if (m_Data.size() - dataOffset < size) {
+    throw ESP::InvalidRecordException("sub-record incomplete");
+  }
+
+  m_Current =
+      SubRecordView(readType(&m_Data[offset]), m_Data.subspan(dataOffset, size));
+  m_Next = dataOffset + size;
+}
+
+ESP::SubRecordRange::iterator::iterator(std::span<const uint8_t> data,
+                                        std::size_t offset)
+    : m_Data(data), m_Offset(offset)
+{
+  read();
+}
+
+ESP::SubRecordRange::iterator& ESP::SubRecordRange::iterator::operator++()
+{
+  m_Offset = m_Next;
+  read();
+  return *this;
+}
+
+ESP::SubRecordRange::iterator ESP::SubRecordRange::iterator::operator++(int)
+{
+  auto copy = *this;
+  ++*this;
+  return copy;
+}
+
+ESP::RecordView::RecordView(const uint8_t* header, std::size_t headerSize,
+                            std::span<const uint8_t> data)
+    : m_Header(header), m_HeaderSize(headerSize), m_Data(data)
+{}
+
+std::string_view ESP::RecordView::type() const
+{
+  return readType(m_Header);
+}
+
+uint32_t ESP::RecordView::flags() const
+{
+  return readValue<uint32_t>(m_Header + 8);
+}
+
+uint32_t ESP::RecordView::formId() const
+{
+  return readValue<uint32_t>(m_Header + 12);
+}
+
+uint16_t ESP::RecordView::formVersion() const
+{
+  if (m_HeaderSize < HeaderSize) {
+    return 0;
+  }
+
+  return readValue<uint16_t>(m_Header + 20);
+}
+
+std::span<const uint8_t> ESP::RecordView::data(std::vector<uint8_t>& buffer) const
+{
+  if (!isCompressed()) {
+    return m_Data;
+  }
+
+  // compressed records start with the size of the uncompressed data, followed
+  // by a zlib stream
+  if (m_Data.size() < 4) {
+    throw ESP::InvalidRecordException("compressed record incomplete");
+  }
+
+  const uint32_t size = readValue<uint32_t>(m_Data.data());
+  if (size > (m_Data.size() - 4) * MaxCompressionRatio) {
+    throw ESP::InvalidRecordException("invalid uncompressed record size");
+  }
+
+  buffer.resize(size);
+
+  uLongf destSize = size;
+  const int res   = uncompress(buffer.data(), &destSize, m_Data.data() + 4,
+                               static_cast<uLong>(m_Data.size() - 4));
+
+  if (res != Z_OK || destSize != size) {
+    throw ESP::InvalidRecordException("failed to decompress record");
+  }
+
+  return std::span<const uint8_t>(buffer.data(), size);
+}
+
+ESP::GroupView::GroupView(const uint8_t* header, std::size_t headerSize,
+                          std::span<const uint8_t> data)
+    : m_Header(header), m_HeaderSize(headerSize), m_Data(data)
+{}
+
+uint32_t ESP::GroupView::label() const
+{
+  return readValue<uint32_t>(m_Header + 8);
+}
+
+std::string_view ESP::GroupView::labelType() const
+{
+  return readType(m_Header + 8);
+}
+
+int32_t ESP::GroupView::groupType() const
+{
+  return readValue<int32_t>(m_Header + 12);
+}
+
+ESP::EntryRange ESP::GroupView::children() const
+{
+  return EntryRange(m_Data, m_HeaderSize);
+}
+
+ESP::EntryView::EntryView(const uint8_t* header, std::size_t headerSize,
+                          std::span<const uint8_t> data)
+    : m_Header(header), m_HeaderSize(headerSize), m_Data(data)
+{}
+
+bool ESP::EntryView::isGroup() const
+{
+  return readType(m_Header) == "GRUP";
+}
+
+void ESP::EntryRange::iterator::read()
+{
+  if (m_Offset >= m_Data.size()) {
+    m_Offset = m_Data.size();
+    m_Next   = m_Offset;
+    return;
+  }
+
+  if (m_Data.size() - m_Offset < m_HeaderSize) {
+    throw ESP::InvalidRecordException("record incomplete");
+  }
+
+  const uint8_t* header  = &m_Data[m_Offset];
+  const std::size_t size = readValue<uint32_t>(header + 4);
+
+  // the size of a group includes its header, the size of a record does not
+  std::size_t total;
+  if (readType(header) == "GRUP") {
+    if (size < m_HeaderSize) {
+      throw ESP::InvalidRecordException("invalid group size");
+    }
+    total = size;
+  } else {
+    total = m_HeaderSize + size;
+  }
+
+  if (m_Data.size() - m_Offset < total) {
+    throw ESP::InvalidRecordException("record incomplete");
+  }
+
+  m_Current = EntryView(header, m_HeaderSize,
+                        m_Data.subspan(m_Offset + m_HeaderSize, total - m_HeaderSize));
+  m_Next    = m_Offset + total;
+}
+
+ESP::EntryRange::iterator::iterator(std::span<const uint8_t> data,
+                                    std::size_t headerSize, std::size_t offset)
+    : m_Data(data), m_HeaderSize(headerSize), m_Offset(offset)
+{
+  read();
+}
+
+ESP::EntryRange::iterator& ESP::EntryRange::iterator::operator++()
+{
+  m_Offset = m_Next;
+  read();
+  return *this;
+}
+
+ESP::EntryRange::iterator ESP::EntryRange::iterator::operator++(int)
+{
+  auto copy = *this;
+  ++*this;
+  return copy;
+}
+
+struct ESP::PluginReader::Mapping
+{
+  boost::interprocess::file_mapping file;
+  boost::interprocess::mapped_region region;
+};
+
+ESP::PluginReader::PluginReader(const std::filesystem::path& path)
+    : m_HeaderSize(HeaderSize)
+{
+  std::error_code ec;
+  const auto fileSize = std::filesystem::file_size(path, ec);
+  if (ec) {
+    throw ESP::InvalidFileException("file not found");
+  }
+
+  // mapping an empty file fails
+  if (fileSize < OblivionHeaderSize + 4) {
+    throw ESP::InvalidFileException("file incomplete");
+  }
+
+  try {
+    using namespace boost::interprocess;
+
+    m_Mapping         = std::make_unique<Mapping>();
+    m_Mapping->file   = file_mapping(path.c_str(), read_only);
+    m_Mapping->region = mapped_region(m_Mapping->file, read_only);
+  } catch (const boost::interprocess::interprocess_exception& e) {
+    throw ESP::InvalidFileException(e.what());
+  }
+
+  m_Data = std::span<const uint8_t>(
+      static_cast<const uint8_t*>(m_Mapping->region.get_address()),
+      m_Mapping->region.get_size());
+
+  if (readType(m_Data.data()) != "TES4") {
+    throw ESP::InvalidFileException("invalid file type");
+  }
+
+  // same check as Record::readFrom(), oblivion has the HEDR sub-record right
+  // after the shorter header
+  if (readType(m_Data.data() + OblivionHeaderSize) == "HEDR") {
+    m_HeaderSize = OblivionHeaderSize;
+  }
+}
+
+ESP::PluginReader::~PluginReader() = default;
+
+ESP::RecordView ESP::PluginReader::header() const
+{
+  return entries().begin()->record();
+}
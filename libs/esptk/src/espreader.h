@@ -0,0 +1,298 @@
+#ifndef ESPREADER_H
+#define ESPREADER_H
+
+#include "record.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace ESP
+{
+
+/**
+ * @brief view on a sub-record, the data points into the record it was read from
+ */
+class SubRecordView
+{
+public:
+  SubRecordView() = default;
+  SubRecordView(std::string_view type, std::span<const uint8_t> data)
+      : m_Type(type), m_Data(data)
+  {}
+
+  std::string_view type() const { return m_Type; }
+  std::span<const uint8_t> data() const { return m_Data; }
+
+private:
+  std::string_view m_Type;
+  std::span<const uint8_t> m_Data;
+};
+
+/**
+ * @brief forward range over the sub-records in the data of a record, XXXX
+ *        sub-records are handled transparently
+ */
+class SubRecordRange
+{
+public:
+  class iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = SubRecordView;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const SubRecordView*;
+    using reference         = const SubRecordView&;
+
+    iterator() = default;
+    iterator(std::span<const uint8_t> data, std::size_t offset);
+
+    reference operator*() const { return m_Current; }
+    pointer operator->() const { return &m_Current; }
+
+    iterator& operator++();
+    iterator operator++(int);
+
+    bool operator==(const iterator& other) const { return m_Offset == other.m_Offset; }
+
+  private:
+    std::span<const uint8_t> m_Data;
+    std::size_t m_Offset = 0;
+    std::size_t m_Next   = 0;
+    SubRecordView m_Current;
+
+    void read();
+  };
+
+  explicit SubRecordRange(std::span<const uint8_t> data) : m_Data(data) {}
+
+  iterator begin() const { return iterator(m_Data, 0); }
+  iterator end() const { return iterator(m_Data, m_Data.size()); }
+
+private:
+  std::span<const uint8_t> m_Data;
+};
+
+/**
+ * @brief view on a record inside a mapped plugin, nothing is copied unless the
+ *        record is compressed
+ */
+class RecordView
+{
+public:
+  RecordView() = default;
+  RecordView(const uint8_t* header, std::size_t headerSize,
+             std::span<const uint8_t> data);
+
+  std::string_view type() const;
+  uint32_t flags() const;
+  uint32_t formId() const;
+
+  /**
+   * @return the form version of the record, 0 for oblivion-style records
+   */
+  uint16_t formVersion() const;
+
+  bool flagSet(Record::EFlag flag) const { return (flags() & flag) != 0; }
+  bool isCompressed() const { return flagSet(Record::FLAG_COMPRESSED); }
+
+  /**
+   * @return the data of the record as stored in the file
+   */
+  std::span<const uint8_t> rawData() const { return m_Data; }
+
+  /**
+   * @brief returns the uncompressed data of the record
+   * @param buffer used to decompress the record if it is compressed, can be
+   *        reused between records to avoid allocations
+   * @return a view into the file for uncompressed records, into the buffer
+   *         otherwise
+   */
+  std::span<const uint8_t> data(std::vector<uint8_t>& buffer) const;
+
+  /**
+   * @brief returns the sub-records of this record, see data()
+   */
+  SubRecordRange subRecords(std::vector<uint8_t>& buffer) const
+  {
+    return SubRecordRange(data(buffer));
+  }
+
+private:
+  const uint8_t* m_Header  = nullptr;
+  std::size_t m_HeaderSize = 0;
+  std::span<const uint8_t> m_Data;
+};
+
+class EntryRange;
+
+/**
+ * @brief view on a group inside a mapped plugin
+ */
+class GroupView
+{
+public:
+  GroupView() = default;
+  GroupView(const uint8_t* header, std::size_t headerSize,
+            std::span<const uint8_t> data);
+
+  /**
+   * @return the raw label of the group, its meaning depends on the group type
+   */
+  uint32_t label() const;
+
+  /**
+   * @return the label as a record type, only meaningful for top groups
+   */
+  std::string_view labelType() const;
+
+  int32_t groupType() const;
+
+  /**
+   * @return the records and groups directly inside this group
+   */
+  EntryRange children() const;
+
+private:
+  const uint8_t* m_Header  = nullptr;
+  std::size_t m_HeaderSize = 0;
+  std::span<const uint8_t> m_Data;
+};
+
+/**
+ * @brief either a record or a group
+ */
+class EntryView
+{
+public:
+  EntryView() = default;
+  EntryView(const uint8_t* header, std::size_t headerSize,
+            std::span<const uint8_t> data);
+
+  bool isGroup() const;
+
+  RecordView record() const { return RecordView(m_Header, m_HeaderSize, m_Data); }
+  GroupView group() const { return GroupView(m_Header, m_HeaderSize, m_Data); }
+
+private:
+  const uint8_t* m_Header  = nullptr;
+  std::size_t m_HeaderSize = 0;
+  std::span<const uint8_t> m_Data;
+};
+
+/**
+ * @brief forward range over consecutive records and groups
+ */
+class EntryRange
+{
+public:
+  class iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = EntryView;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const EntryView*;
+    using reference         = const EntryView&;
+
+    iterator() = default;
+    iterator(std::span<const uint8_t> data, std::size_t headerSize,
+             std::size_t offset);
+
+    reference operator*() const { return m_Current; }
+    pointer operator->() const { return &m_Current; }
+
+    iterator& operator++();
+    iterator operator++(int);
+
+    bool operator==(const iterator& other) const { return m_Offset == other.m_Offset; }
+
+  private:
+    std::span<const uint8_t> m_Data;
+    std::size_t m_HeaderSize = 0;
+    std::size_t m_Offset     = 0;
+    std::size_t m_Next       = 0;
+    EntryView m_Current;
+
+    void read();
+  };
+
+  EntryRange(std::span<const uint8_t> data, std::size_t headerSize)
+      : m_Data(data), m_HeaderSize(headerSize)
+  {}
+
+  iterator begin() const { return iterator(m_Data, m_HeaderSize, 0); }
+  iterator end() const { return iterator(m_Data, m_HeaderSize, m_Data.size()); }
+
+private:
+  std::span<const uint8_t> m_Data;
+  std::size_t m_HeaderSize;
+};
+
+/**
+ * @brief memory-mapped reader for the records and groups of a plugin
+ *
+ * unlike File, this walks the whole plugin; the views it returns point
+ * directly into the mapping and are only valid while the reader is alive
+ *
+ * only TES4-style plugins (oblivion and later) are supported
+ */
+class PluginReader
+{
+public:
+  explicit PluginReader(const std::filesystem::path& path);
+  ~PluginReader();
+
+  PluginReader(const PluginReader&)            = delete;
+  PluginReader& operator=(const PluginReader&) = delete;
+
+  /**
+   * @return the TES4 header record
+   */
+  RecordView header() const;
+
+  /**
+   * @return all top-level entries, starting with the header record
+   */
+  EntryRange entries() const { return EntryRange(m_Data, m_HeaderSize); }
+
+  /**
+   * @brief calls the given callable for every record in the plugin, including
+   *        the header and the records in nested groups, in file order
+   */
+  template <class F>
+  void forEachRecord(F&& f) const
+  {
+    forEachRecord(entries(), f);
+  }
+
+  std::size_t size() const { return m_Data.size(); }
+
+private:
+  struct Mapping;
+
+  std::unique_ptr<Mapping> m_Mapping;
+  std::span<const uint8_t> m_Data;
+  std::size_t m_HeaderSize;
+
+  template <class F>
+  static void forEachRecord(const EntryRange& range, F& f)
+  {
+    for (const auto& entry : range) {
+      if (entry.isGroup()) {
+        forEachRecord(entry.group().children(), f);
+      } else {
+        f(entry.record());
+      }
+    }
+  }
+};
+
+}  // namespace ESP
+
+#endif  // ESPREADER_H
@@ -35,6 +35,12 @@ public:
 
   const std::vector<uint8_t>& data() const { return m_Data; }
 
+  /**
+   * @return the form version of the record, 0 for oblivion-style records that
+   *         do not have one
+   */
+  uint16_t formVersion() const { return m_FormVersion; }
+
 private:
   struct Header
   {
@@ -48,6 +54,7 @@ private:
   std::vector<uint8_t> m_Data;
 
   bool m_OblivionStyle;
+  uint16_t m_FormVersion;
 };
 
 }  // namespace ESP
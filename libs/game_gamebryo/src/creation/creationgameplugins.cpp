@@ -19,23 +19,6 @@ CreationGamePlugins::CreationGamePlugins(IOrganizer* organizer)
     : GamebryoGamePlugins(organizer)
 {}
 
-QStringList CreationGamePlugins::getLoadOrder()
-{
-  QString loadOrderPath = organizer()->profile()->absolutePath() + "/loadorder.txt";
-  QString pluginsPath   = organizer()->profile()->absolutePath() + "/plugins.txt";
-
-  bool loadOrderIsNew = !m_LastRead.isValid() || !QFileInfo(loadOrderPath).exists() ||
-                        QFileInfo(loadOrderPath).lastModified() > m_LastRead;
-  bool pluginsIsNew =
-      !m_LastRead.isValid() || QFileInfo(pluginsPath).lastModified() > m_LastRead;
-
-  if (loadOrderIsNew || !pluginsIsNew) {
-    return readLoadOrderList(m_Organizer->pluginList(), loadOrderPath);
-  } else {
-    return readPluginList(m_Organizer->pluginList());
-  }
-}
-
 void CreationGamePlugins::writePluginList(const IPluginList* pluginList,
                                           const QString& filePath)
 {
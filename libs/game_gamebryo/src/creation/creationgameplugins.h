@@ -15,7 +15,6 @@ protected:
   virtual void writePluginList(const MOBase::IPluginList* pluginList,
                                const QString& filePath) override;
   virtual QStringList readPluginList(MOBase::IPluginList* pluginList) override;
-  virtual QStringList getLoadOrder() override;
   virtual bool lightPluginsAreSupported() override;
 
 private:
@@ -9,6 +9,7 @@
 
 #include <QDateTime>
 #include <QDir>
+#include <QFileInfo>
 #include <QString>
 #include <QStringEncoder>
 #include <QStringList>
@@ -18,6 +19,8 @@ using MOBase::IPluginList;
 using MOBase::reportError;
 using MOBase::SafeWriteFile;
 
+static const QStringList ListFileNames = {"plugins.txt", "loadorder.txt"};
+
 GamebryoGamePlugins::GamebryoGamePlugins(IOrganizer* organizer) : m_Organizer(organizer)
 {}
 
@@ -28,15 +31,44 @@ void GamebryoGamePlugins::writePluginLists(const IPluginList* pluginList)
     return;
   }
 
+  auto state = currentState(pluginList);
+
+  // nothing changed since the lists were last written, which happens a lot
+  // while plugins are being moved around
+  if (const auto last = unchangedState();
+      last && last->loadOrder == state.loadOrder && last->active == state.active) {
+    return;
+  }
+
   writePluginList(pluginList, m_Organizer->profile()->absolutePath() + "/plugins.txt");
   writeLoadOrderList(pluginList,
                      m_Organizer->profile()->absolutePath() + "/loadorder.txt");
 
+  recordState(std::move(state));
   m_LastRead = QDateTime::currentDateTime();
 }
 
 void GamebryoGamePlugins::readPluginLists(MOBase::IPluginList* pluginList)
 {
+  // the lists are still the ones that were last written, there is no need to
+  // parse them again
+  if (const auto last = unchangedState()) {
+    const QStringList primary = organizer()->managedGame()->primaryPlugins();
+
+    pluginList->setLoadOrder(last->loadOrder);
+    for (const QString& pluginName : pluginList->pluginNames()) {
+      if (primary.contains(pluginName, Qt::CaseInsensitive) ||
+          last->active.contains(pluginName.toLower())) {
+        pluginList->setState(pluginName, IPluginList::STATE_ACTIVE);
+      } else {
+        pluginList->setState(pluginName, IPluginList::STATE_INACTIVE);
+      }
+    }
+
+    m_LastRead = QDateTime::currentDateTime();
+    return;
+  }
+
   QString loadOrderPath = organizer()->profile()->absolutePath() + "/loadorder.txt";
   QString pluginsPath   = organizer()->profile()->absolutePath() + "/plugins.txt";
 
@@ -62,6 +94,10 @@ void GamebryoGamePlugins::readPluginLists(MOBase::IPluginList* pluginList)
 
 QStringList GamebryoGamePlugins::getLoadOrder()
 {
+  if (const auto last = unchangedState()) {
+    return last->loadOrder;
+  }
+
   QString loadOrderPath = organizer()->profile()->absolutePath() + "/loadorder.txt";
   QString pluginsPath   = organizer()->profile()->absolutePath() + "/plugins.txt";
 
@@ -141,6 +177,63 @@ void GamebryoGamePlugins::writeList(const IPluginList* pluginList,
   }
 }
 
+GamebryoGamePlugins::ListsState
+GamebryoGamePlugins::currentState(const IPluginList* pluginList) const
+{
+  ListsState state;
+  state.profilePath = m_Organizer->profile()->absolutePath();
+
+  state.loadOrder = pluginList->pluginNames();
+  std::sort(state.loadOrder.begin(), state.loadOrder.end(),
+            [pluginList](const QString& lhs, const QString& rhs) {
+              return pluginList->priority(lhs) < pluginList->priority(rhs);
+            });
+
+  for (const QString& pluginName : state.loadOrder) {
+    if (pluginList->state(pluginName) == IPluginList::STATE_ACTIVE) {
+      state.active.insert(pluginName.toLower());
+    }
+  }
+
+  return state;
+}
+
+void GamebryoGamePlugins::recordState(ListsState state)
+{
+  for (const auto& fileName : ListFileNames) {
+    const QFileInfo info(state.profilePath + "/" + fileName);
+    state.stamps[fileName] = {info.exists() ? info.size() : -1, info.lastModified()};
+  }
+
+  std::scoped_lock lock(m_StateMutex);
+  m_State = std::move(state);
+}
+
+std::optional<GamebryoGamePlugins::ListsState>
+GamebryoGamePlugins::unchangedState() const
+{
+  const QString profilePath = m_Organizer->profile()->absolutePath();
+
+  std::scoped_lock lock(m_StateMutex);
+
+  if (!m_State || m_State->profilePath != profilePath) {
+    return {};
+  }
+
+  for (const auto& [fileName, stamp] : m_State->stamps) {
+    const QFileInfo info(profilePath + "/" + fileName);
+
+    // a missing list means the load order is rebuilt from the plugins, which
+    // may have changed
+    if (!info.exists() || stamp.first != info.size() ||
+        stamp.second != info.lastModified()) {
+      return {};
+    }
+  }
+
+  return m_State;
+}
+
 QStringList GamebryoGamePlugins::readLoadOrderList(MOBase::IPluginList* pluginList,
                                                    const QString& filePath)
 {
@@ -2,10 +2,15 @@
 #define GAMEBRYOGAMEPLUGINS_H
 
 #include <QDateTime>
+#include <QSet>
 #include <QStringList>
 #include <gameplugins.h>
 #include <imoinfo.h>
 
+#include <map>
+#include <mutex>
+#include <optional>
+
 class GamebryoGamePlugins : public MOBase::GamePlugins
 {
 public:
@@ -33,11 +38,41 @@ protected:
   QDateTime m_LastRead;
 
 private:
+  // the load order and the active plugins, as last written to the lists of a
+  // profile
+  //
+  struct ListsState
+  {
+    QString profilePath;
+    QStringList loadOrder;
+    QSet<QString> active;
+
+    // size and modification time of the lists when the state was recorded
+    std::map<QString, std::pair<qint64, QDateTime>> stamps;
+  };
+
   void writeList(const MOBase::IPluginList* pluginList, const QString& filePath,
                  bool loadOrder);
 
+  // builds the state of the given plugin list, without stamps
+  //
+  ListsState currentState(const MOBase::IPluginList* pluginList) const;
+
+  // records the given state along with the current stamps of the lists
+  //
+  void recordState(ListsState state);
+
+  // returns the recorded state if the lists of the current profile were not
+  // modified since it was recorded
+  //
+  std::optional<ListsState> unchangedState() const;
+
 private:
   std::map<QString, QByteArray> m_LastSaveHash;
+
+  // the refresher thread calls getLoadOrder()
+  mutable std::mutex m_StateMutex;
+  std::optional<ListsState> m_State;
 };
 
 #endif  // GAMEBRYOGAMEPLUGINS_H
@@ -226,8 +226,12 @@ private:
 
 std::shared_ptr<ArchiveFileTree> ArchiveFileTree::makeTree(Archive const& archive)
 {
-  auto const& data = archive.getFileList();
+  return makeTree(archive.getFileList());
+}
 
+std::shared_ptr<ArchiveFileTree>
+ArchiveFileTree::makeTree(std::vector<FileData*> const& data)
+{
   std::vector<ArchiveFileTreeImpl::File> files;
   files.reserve(data.size());
 
@@ -276,5 +280,12 @@ void mapToArchive(std::vector<FileData*> const& data, It begin, It end)
 void ArchiveFileTree::mapToArchive(
     Archive& archive, std::vector<std::shared_ptr<const FileTreeEntry>> const& entries)
 {
-  ::mapToArchive(archive.getFileList(), entries.cbegin(), entries.cend());
+  mapToArchive(archive.getFileList(), entries);
+}
+
+void ArchiveFileTree::mapToArchive(
+    std::vector<FileData*> const& files,
+    std::vector<std::shared_ptr<const FileTreeEntry>> const& entries)
+{
+  ::mapToArchive(files, entries.cbegin(), entries.cend());
 }
@@ -38,6 +38,16 @@ public:
    */
   static std::shared_ptr<ArchiveFileTree> makeTree(Archive const& archive);
 
+  /**
+   * @brief Create a new file tree from a list of archive entries.
+   *
+   * @param files Entries of the archive, in the same order as
+   *     Archive::getFileList(), e.g. from a cached listing.
+   *
+   * @return a file tree representing the given entries.
+   */
+  static std::shared_ptr<ArchiveFileTree> makeTree(std::vector<FileData*> const& files);
+
   /**
    * @brief Update the given archive to reflect change in this tree.
    *
@@ -64,6 +74,17 @@ public:
   mapToArchive(Archive& archive,
                std::vector<std::shared_ptr<const FileTreeEntry>> const& entries);
 
+  /**
+   * @brief Same as above, for the given list of archive entries.
+   *
+   * @param files Entries of the archive, in the same order as
+   *     Archive::getFileList(), e.g. from a cached listing.
+   * @param entries List of entries to mark for extraction.
+   */
+  static void
+  mapToArchive(std::vector<FileData*> const& files,
+               std::vector<std::shared_ptr<const FileTreeEntry>> const& entries);
+
 protected:
   using IFileTree::IFileTree;
 };
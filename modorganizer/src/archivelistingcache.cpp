@@ -0,0 +1,185 @@
+#include "archivelistingcache.h"
+
+#include <log.h>
+#include <safewritefile.h>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include <algorithm>
+
+using namespace MOBase;
+
+// bumped when the layout of the listings changes
+static constexpr quint32 CacheVersion = 1;
+
+// upper bound of the entries reserved up front when reading a listing
+static constexpr quint32 MaxReservedEntries = 64 * 1024;
+
+namespace
+{
+
+// an entry read from a listing, only the output paths can be changed
+//
+class CachedFileData : public FileData
+{
+public:
+  CachedFileData(std::wstring path, uint64_t size, uint64_t crc, bool isDirectory)
+      : m_Path(std::move(path)), m_Size(size), m_CRC(crc), m_IsDirectory(isDirectory)
+  {}
+
+  std::wstring getArchiveFilePath() const override { return m_Path; }
+  uint64_t getSize() const override { return m_Size; }
+
+  void addOutputFilePath(std::wstring const& filepath) override
+  {
+    m_OutputPaths.push_back(filepath);
+  }
+
+  const std::vector<std::wstring>& getOutputFilePaths() const override
+  {
+    return m_OutputPaths;
+  }
+
+  void clearOutputFilePaths() override { m_OutputPaths.clear(); }
+
+  uint64_t getCRC() const override { return m_CRC; }
+  bool isDirectory() const override { return m_IsDirectory; }
+
+private:
+  std::wstring m_Path;
+  uint64_t m_Size;
+  uint64_t m_CRC;
+  bool m_IsDirectory;
+  std::vector<std::wstring> m_OutputPaths;
+};
+
+}  // namespace
+
+void ArchiveListingCache::setCacheDirectory(const QString& cacheDirectory)
+{
+  m_Directory = cacheDirectory.isEmpty()
+                    ? QString()
+                    : QDir(cacheDirectory).absoluteFilePath("archives");
+}
+
+std::vector<std::unique_ptr<FileData>>
+ArchiveListingCache::get(const QString& archivePath) const
+{
+  if (m_Directory.isEmpty()) {
+    return {};
+  }
+
+  QFile file(listingPath(archivePath));
+  if (!file.open(QIODevice::ReadOnly)) {
+    // not cached
+    return {};
+  }
+
+  const QByteArray data = qUncompress(file.readAll());
+  QDataStream stream(data);
+
+  quint32 version = 0;
+  qint64 size = 0, modified = 0;
+  quint32 count = 0;
+  stream >> version >> size >> modified >> count;
+
+  if (stream.status() != QDataStream::Ok || version != CacheVersion) {
+    log::debug("discarding archive listing for '{}'", archivePath);
+    return {};
+  }
+
+  const QFileInfo fi(archivePath);
+  if (fi.size() != size || fi.lastModified().toMSecsSinceEpoch() != modified) {
+    // the archive was replaced since it was listed
+    return {};
+  }
+
+  // the count is not trusted, a damaged listing fails to read long before
+  std::vector<std::unique_ptr<FileData>> files;
+  files.reserve(std::min<quint32>(count, MaxReservedEntries));
+
+  for (quint32 i = 0; i < count; ++i) {
+    QString path;
+    quint64 fileSize = 0, crc = 0;
+    bool isDirectory = false;
+    stream >> path >> fileSize >> crc >> isDirectory;
+
+    if (stream.status() != QDataStream::Ok) {
+      break;
+    }
+
+    files.push_back(std::make_unique<CachedFileData>(path.toStdWString(), fileSize,
+                                                     crc, isDirectory));
+  }
+
+  if (stream.status() != QDataStream::Ok) {
+    log::warn("archive listing for '{}' is truncated, discarding", archivePath);
+    return {};
+  }
+
+  return files;
+}
+
+void ArchiveListingCache::put(const QString& archivePath,
+                              const std::vector<FileData*>& files) const
+{
+  if (m_Directory.isEmpty() || files.empty()) {
+    return;
+  }
+
+  const QFileInfo fi(archivePath);
+
+  QByteArray data;
+  QDataStream stream(&data, QIODevice::WriteOnly);
+
+  stream << CacheVersion << fi.size() << fi.lastModified().toMSecsSinceEpoch()
+         << static_cast<quint32>(files.size());
+
+  for (const auto* f : files) {
+    stream << QString::fromStdWString(f->getArchiveFilePath())
+           << static_cast<quint64>(f->getSize()) << static_cast<quint64>(f->getCRC())
+           << f->isDirectory();
+  }
+
+  try {
+    QDir().mkpath(m_Directory);
+
+    SafeWriteFile file(listingPath(archivePath));
+    file->write(qCompress(data));
+    file.commit();
+  } catch (const std::exception& e) {
+    log::error("failed to write archive listing for '{}': {}", archivePath, e.what());
+  }
+}
+
+void ArchiveListingCache::remove(const QString& archivePath) const
+{
+  if (m_Directory.isEmpty()) {
+    return;
+  }
+
+  const QString path = listingPath(archivePath);
+  if (QFile::exists(path) && !QFile::remove(path)) {
+    log::warn("failed to remove archive listing '{}'", path);
+  }
+}
+
+QString ArchiveListingCache::archiveKey(const QString& archivePath)
+{
+  // archives can be installed from anywhere, the key is derived from the full path
+  const QString path = QDir::cleanPath(QFileInfo(archivePath).absoluteFilePath());
+  const QByteArray hash =
+      QCryptographicHash::hash(path.toLower().toUtf8(), QCryptographicHash::Sha1);
+
+  return QString::fromLatin1(hash.toHex());
+}
+
+QString ArchiveListingCache::listingPath(const QString& archivePath) const
+{
+  return QDir(m_Directory).absoluteFilePath(archiveKey(archivePath) + ".listing");
+}
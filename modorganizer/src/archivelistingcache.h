@@ -0,0 +1,56 @@
+#ifndef ARCHIVELISTINGCACHE_H
+#define ARCHIVELISTINGCACHE_H
+
+#include <archive.h>
+
+#include <QString>
+
+#include <memory>
+#include <vector>
+
+// persistent cache of the list of entries in the archives that were installed
+// (see InstallationManager::install())
+//
+// listing a large solid archive requires reading all of its headers, which can
+// take seconds and happens again on every reinstall; the flattened entries are
+// stored in one file per archive in the cache directory and are reused as long
+// as the size and the modification time of the archive did not change, so the
+// file tree can be built without opening the archive
+//
+class ArchiveListingCache
+{
+public:
+  // sets the cache directory of the instance, listings are stored in its
+  // "archives" subdirectory; caching is disabled if the path is empty
+  //
+  void setCacheDirectory(const QString& cacheDirectory);
+
+  // returns the entries of the given archive, in the same order as in
+  // Archive::getFileList(), or an empty list if the archive is not in the cache
+  // or changed since it was cached
+  //
+  std::vector<std::unique_ptr<FileData>> get(const QString& archivePath) const;
+
+  // stores the entries of the given archive, errors are logged
+  //
+  void put(const QString& archivePath, const std::vector<FileData*>& files) const;
+
+  // removes the listing of the given archive, if any, used when a download is
+  // deleted
+  //
+  void remove(const QString& archivePath) const;
+
+  // returns the name under which data about the given archive is cached, derived
+  // from its full path
+  //
+  static QString archiveKey(const QString& archivePath);
+
+private:
+  QString m_Directory;
+
+  // path of the listing for the given archive
+  //
+  QString listingPath(const QString& archivePath) const;
+};
+
+#endif  // ARCHIVELISTINGCACHE_H
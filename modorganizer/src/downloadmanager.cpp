@@ -316,6 +316,19 @@ void DownloadManager::setOutputDirectory(const QString& outputDirectory,
   m_DirWatcher.addPath(m_OutputDirectory);
 }
 
+void DownloadManager::setCacheDirectory(const QString& cacheDirectory)
+{
+  m_CacheDirectory = cacheDirectory;
+  m_Preparer.setCacheDirectory(cacheDirectory);
+  m_ListingCache.setCacheDirectory(cacheDirectory);
+
+  // prepared files are only removed with their download otherwise, downloads
+  // deleted while MO was not running would keep them forever
+  if (!m_OutputDirectory.isEmpty()) {
+    m_Preparer.prune(m_OutputDirectory);
+  }
+}
+
 void DownloadManager::setShowHidden(bool showHidden)
 {
   m_ShowHidden = showHidden;
@@ -789,11 +802,16 @@ void DownloadManager::removeFile(int index, bool deleteFile)
   }
 
   if (deleteFile) {
+    // the preparer may have the archive open, this waits until it's done with it
+    m_Preparer.remove(filePath);
+
     if (!shellDelete(QStringList(filePath), true)) {
       reportError(tr("failed to delete %1").arg(filePath));
       return;
     }
 
+    m_ListingCache.remove(filePath);
+
     QFile metaFile(filePath.append(".meta"));
     if (metaFile.exists() && !shellDelete(QStringList(filePath), true)) {
       reportError(tr("failed to delete meta file for %1").arg(filePath));
@@ -2273,6 +2291,10 @@ void DownloadManager::downloadFinished(int index)
         setState(info, STATE_READY);
       }
 
+      // list the archive and extract what installers need in the background, so
+      // the installation can start right away
+      m_Preparer.prepare(info->m_Output.fileName());
+
       emit update(index);
     }
     reply->close();
@@ -20,6 +20,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef DOWNLOADMANAGER_H
 #define DOWNLOADMANAGER_H
 
+#include "downloadpreparer.h"
 #include "serverinfo.h"
 #include <QElapsedTimer>
 #include <QFile>
@@ -190,6 +191,14 @@ public:
    **/
   void setOutputDirectory(const QString& outputDirectory, const bool refresh = true);
 
+  /**
+   * @brief set the cache directory of the instance, finished downloads are listed
+   *into it
+   *
+   * @param cacheDirectory the cache directory
+   **/
+  void setCacheDirectory(const QString& cacheDirectory);
+
   /**
    * @brief disables feedback from the downlods fileSystemWhatcher untill
    *disableDownloadsWatcherEnd() is called
@@ -624,6 +633,13 @@ private:
   MOBase::IPluginGame const* m_ManagedGame;
 
   QTimer m_TimeoutTimer;
+
+  // prepares finished downloads for installation
+  DownloadPreparer m_Preparer;
+
+  // only used to remove the listings and the prepared files of deleted downloads
+  QString m_CacheDirectory;
+  ArchiveListingCache m_ListingCache;
 };
 
 class ScopedDisableDirWatcher
@@ -0,0 +1,444 @@
+#include "downloadpreparer.h"
+#include "thread_utils.h"
+
+#include <log.h>
+#include <scopeguard.h>
+#include <utility.h>
+
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QSettings>
+
+#include <algorithm>
+#include <set>
+#include <utility>
+#include <vector>
+
+using namespace MOBase;
+
+// directory of the prepared files in the cache directory
+static const QString PreparedDirectory = "prepared";
+
+// directory of the files prepared from the given archive
+static QString archiveDirectory(const QString& cacheDirectory,
+                                const QString& archivePath)
+{
+  return QDir(cacheDirectory)
+      .absoluteFilePath(PreparedDirectory + "/" +
+                        ArchiveListingCache::archiveKey(archivePath));
+}
+
+// images are only prepared if they are small enough in total, the fomod installer
+// extracts them from the archive otherwise
+static constexpr uint64_t MaxImagesSize = 128 * 1024 * 1024;
+
+// total size of the prepared files, the archives that were prepared the longest
+// time ago are removed beyond it
+static constexpr uint64_t MaxPreparedSize = 1024 * 1024 * 1024;
+
+// removes the prepared files of the given archive, if any
+static void removeDirectory(const QString& cacheDirectory, const QString& archivePath)
+{
+  if (cacheDirectory.isEmpty()) {
+    return;
+  }
+
+  QDir directory(archiveDirectory(cacheDirectory, archivePath));
+  if (directory.exists() && !directory.removeRecursively()) {
+    log::warn("failed to remove prepared files of '{}'", archivePath);
+  }
+}
+
+// removes the prepared files of archives that are not in the downloads directory
+// anymore, along with the temporary directories of extractions that were
+// interrupted
+static void removeOrphans(const QString& cacheDirectory,
+                          const QString& downloadsDirectory)
+{
+  if (cacheDirectory.isEmpty()) {
+    return;
+  }
+
+  TimeThis tt("DownloadPreparer::removeOrphans()");
+
+  std::set<QString> keys;
+  for (const auto& fi : QDir(downloadsDirectory).entryInfoList(QDir::Files)) {
+    keys.insert(ArchiveListingCache::archiveKey(fi.absoluteFilePath()));
+  }
+
+  const QDir root(QDir(cacheDirectory).absoluteFilePath(PreparedDirectory));
+  int removed = 0;
+
+  for (const auto& fi : root.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+    if (fi.suffix() != "tmp" && keys.contains(fi.fileName())) {
+      continue;
+    }
+
+    if (QDir(fi.absoluteFilePath()).removeRecursively()) {
+      ++removed;
+    } else {
+      log::warn("failed to remove prepared files in '{}'", fi.absoluteFilePath());
+    }
+  }
+
+  if (removed > 0) {
+    log::debug("removed the prepared files of {} archives that are gone", removed);
+  }
+}
+
+// removes the prepared files of the archives that were prepared the longest time
+// ago until the total size is under MaxPreparedSize
+static void limitSize(const QString& cacheDirectory)
+{
+  if (cacheDirectory.isEmpty()) {
+    return;
+  }
+
+  struct Prepared
+  {
+    QString path;
+    qint64 time;
+    uint64_t size;
+  };
+
+  std::vector<Prepared> prepared;
+  uint64_t totalSize = 0;
+
+  const QDir root(QDir(cacheDirectory).absoluteFilePath(PreparedDirectory));
+
+  for (const auto& fi : root.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+    if (fi.suffix() == "tmp") {
+      continue;
+    }
+
+    uint64_t size = 0;
+    QDirIterator files(fi.absoluteFilePath(), QDir::Files | QDir::Hidden,
+                       QDirIterator::Subdirectories);
+
+    while (files.hasNext()) {
+      files.next();
+      size += files.fileInfo().size();
+    }
+
+    const QFileInfo stamp(fi.absoluteFilePath() + "/archive.ini");
+    prepared.push_back({fi.absoluteFilePath(),
+                        stamp.lastModified().toMSecsSinceEpoch(), size});
+    totalSize += size;
+  }
+
+  if (totalSize <= MaxPreparedSize) {
+    return;
+  }
+
+  std::sort(prepared.begin(), prepared.end(), [](auto&& a, auto&& b) {
+    return a.time < b.time;
+  });
+
+  int removed = 0;
+
+  for (const auto& p : prepared) {
+    if (totalSize <= MaxPreparedSize) {
+      break;
+    }
+
+    if (QDir(p.path).removeRecursively()) {
+      totalSize -= p.size;
+      ++removed;
+    } else {
+      log::warn("failed to remove prepared files in '{}'", p.path);
+    }
+  }
+
+  if (removed > 0) {
+    log::debug("removed the prepared files of {} archives, over {} bytes", removed,
+               MaxPreparedSize);
+  }
+}
+
+DownloadPreparer::DownloadPreparer()
+    : m_Stop(false), m_Current(nullptr), m_CancelCurrent(false)
+{
+  m_Thread = MOShared::startSafeThread([this] {
+    run();
+  });
+}
+
+DownloadPreparer::~DownloadPreparer()
+{
+  {
+    std::scoped_lock lock(m_Mutex);
+    m_Stop = true;
+
+    if (m_Current != nullptr) {
+      m_Current->cancel();
+    }
+  }
+
+  m_Wake.notify_one();
+  m_Thread.join();
+}
+
+void DownloadPreparer::setCacheDirectory(const QString& cacheDirectory)
+{
+  std::scoped_lock lock(m_Mutex);
+  m_CacheDirectory = cacheDirectory;
+  m_ListingCache.setCacheDirectory(cacheDirectory);
+}
+
+void DownloadPreparer::prepare(const QString& archivePath)
+{
+  {
+    std::scoped_lock lock(m_Mutex);
+    m_Queue.push_back(archivePath);
+  }
+
+  m_Wake.notify_one();
+}
+
+void DownloadPreparer::prune(const QString& downloadsDirectory)
+{
+  {
+    std::scoped_lock lock(m_Mutex);
+    m_PruneDirectory = downloadsDirectory;
+  }
+
+  m_Wake.notify_one();
+}
+
+void DownloadPreparer::remove(const QString& archivePath)
+{
+  // the same archive may be given with different separators
+  const QString key = ArchiveListingCache::archiveKey(archivePath);
+
+  std::unique_lock lock(m_Mutex);
+
+  std::erase_if(m_Queue, [&](const QString& path) {
+    return ArchiveListingCache::archiveKey(path) == key;
+  });
+
+  if (!m_CurrentPath.isEmpty() &&
+      ArchiveListingCache::archiveKey(m_CurrentPath) == key) {
+    m_CancelCurrent = true;
+
+    if (m_Current != nullptr) {
+      m_Current->cancel();
+    }
+
+    m_Done.wait(lock, [&] {
+      return m_CurrentPath.isEmpty();
+    });
+  }
+
+  removeDirectory(m_CacheDirectory, archivePath);
+}
+
+QString DownloadPreparer::preparedDirectory(const QString& cacheDirectory,
+                                           const QString& archivePath)
+{
+  if (cacheDirectory.isEmpty()) {
+    return {};
+  }
+
+  const QString directory = archiveDirectory(cacheDirectory, archivePath);
+  const QString stampPath = directory + "/archive.ini";
+
+  if (!QFileInfo::exists(stampPath)) {
+    return {};
+  }
+
+  const QSettings stamp(stampPath, QSettings::IniFormat);
+  const QFileInfo fi(archivePath);
+
+  if (stamp.value("size").toLongLong() != fi.size() ||
+      stamp.value("modified").toLongLong() != fi.lastModified().toMSecsSinceEpoch()) {
+    return {};
+  }
+
+  return directory + "/files";
+}
+
+void DownloadPreparer::run()
+{
+  auto archive = CreateArchive();
+  if (!archive->isValid()) {
+    log::error("downloads will not be prepared, the archive library is not available");
+    return;
+  }
+
+  {
+    std::scoped_lock lock(m_Mutex);
+    m_Current = archive.get();
+  }
+
+  for (;;) {
+    QString archivePath;
+    QString pruneDirectory;
+    QString cacheDirectory;
+    ArchiveListingCache listingCache;
+
+    {
+      std::unique_lock lock(m_Mutex);
+      m_Wake.wait(lock, [&] {
+        return m_Stop || !m_Queue.empty() || !m_PruneDirectory.isEmpty();
+      });
+
+      if (m_Stop) {
+        m_Current = nullptr;
+        return;
+      }
+
+      if (!m_PruneDirectory.isEmpty()) {
+        pruneDirectory = std::exchange(m_PruneDirectory, QString());
+      } else {
+        archivePath = std::move(m_Queue.front());
+        m_Queue.pop_front();
+
+        m_CurrentPath   = archivePath;
+        m_CancelCurrent = false;
+      }
+
+      cacheDirectory = m_CacheDirectory;
+      listingCache   = m_ListingCache;
+    }
+
+    if (!pruneDirectory.isEmpty()) {
+      removeOrphans(cacheDirectory, pruneDirectory);
+      limitSize(cacheDirectory);
+      continue;
+    }
+
+    prepareArchive(*archive, archivePath, cacheDirectory, listingCache);
+    limitSize(cacheDirectory);
+
+    {
+      std::scoped_lock lock(m_Mutex);
+      m_CurrentPath.clear();
+    }
+
+    m_Done.notify_all();
+  }
+}
+
+bool DownloadPreparer::cancelled() const
+{
+  return m_Stop || m_CancelCurrent;
+}
+
+void DownloadPreparer::prepareArchive(Archive& archive, const QString& archivePath,
+                                      const QString& cacheDirectory,
+                                      const ArchiveListingCache& listingCache)
+{
+  TimeThis tt("DownloadPreparer::prepareArchive()");
+
+  const QFileInfo fi(archivePath);
+
+  // the user is not asked for a password in the background, protected archives
+  // fail to open and are prepared when they are installed
+  if (!archive.open(archivePath.toStdWString(), [] {
+        return std::wstring();
+      })) {
+    log::debug("not preparing '{}', the archive cannot be opened", archivePath);
+    return;
+  }
+
+  ON_BLOCK_EXIT([&archive] {
+    archive.close();
+  });
+
+  const auto& files = archive.getFileList();
+  listingCache.put(archivePath, files);
+
+  // same files as InstallerFomod::buildFomodTree()
+  static const std::set<QString> imageSuffixes{"png", "jpg", "jpeg", "gif", "bmp"};
+
+  bool hasConfig = false;
+  std::vector<FileData*> selected;
+  std::vector<FileData*> images;
+  uint64_t imagesSize = 0;
+
+  for (auto* f : files) {
+    if (f->isDirectory()) {
+      continue;
+    }
+
+    const QFileInfo path(
+        QString::fromStdWString(f->getArchiveFilePath()).replace("\\", "/").toLower());
+
+    if (path.dir().dirName() == "fomod") {
+      if (path.fileName() == "moduleconfig.xml") {
+        hasConfig = true;
+        selected.push_back(f);
+      } else if (path.fileName() == "info.xml") {
+        selected.push_back(f);
+      }
+    } else if (imageSuffixes.contains(path.suffix())) {
+      images.push_back(f);
+      imagesSize += f->getSize();
+    }
+  }
+
+  // only the listing is useful for other installers
+  if (!hasConfig || cacheDirectory.isEmpty()) {
+    return;
+  }
+
+  if (imagesSize <= MaxImagesSize) {
+    selected.insert(selected.end(), images.begin(), images.end());
+  }
+
+  for (auto* f : selected) {
+    f->addOutputFilePath(f->getArchiveFilePath());
+  }
+
+  // files are extracted to a temporary directory that replaces the previous one
+  // once complete, the installation manager never sees a partial directory
+  const QString directory = archiveDirectory(cacheDirectory, archivePath);
+  const QString temp      = directory + ".tmp";
+
+  QDir(temp).removeRecursively();
+
+  // cancel() only has an effect while extract() runs, a stop or a removal requested
+  // since the archive was dequeued is checked here and then on every progress update
+  if (cancelled()) {
+    return;
+  }
+
+  auto progressCallback = [this, &archive](auto, uint64_t, uint64_t) {
+    if (cancelled()) {
+      archive.cancel();
+    }
+  };
+
+  if (!archive.extract(QDir::toNativeSeparators(temp + "/files").toStdWString(),
+                       progressCallback, nullptr, nullptr)) {
+    log::debug("failed to prepare '{}'", archivePath);
+    QDir(temp).removeRecursively();
+    return;
+  }
+
+  {
+    QSettings stamp(temp + "/archive.ini", QSettings::IniFormat);
+    stamp.setValue("size", fi.size());
+    stamp.setValue("modified", fi.lastModified().toMSecsSinceEpoch());
+  }
+
+  // remove() waits for this function to return before deleting the directory, but
+  // the download may also have been deleted from outside while it was extracted
+  if (cancelled() || !QFileInfo::exists(archivePath)) {
+    log::debug("not preparing '{}', the archive was removed", archivePath);
+    QDir(temp).removeRecursively();
+    return;
+  }
+
+  removeDirectory(cacheDirectory, archivePath);
+  if (!QDir().rename(temp, directory)) {
+    log::warn("failed to move prepared files of '{}' to '{}'", archivePath, directory);
+    QDir(temp).removeRecursively();
+    return;
+  }
+
+  log::debug("prepared {} files of '{}' for installation", selected.size(),
+             archivePath);
+}
@@ -0,0 +1,104 @@
+#ifndef DOWNLOADPREPARER_H
+#define DOWNLOADPREPARER_H
+
+#include "archivelistingcache.h"
+
+#include <QString>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// prepares finished downloads for installation in a background thread (see
+// DownloadManager::downloadFinished())
+//
+// the archive is listed into the listing cache, and the files the fomod
+// installer reads before showing its dialog (the configuration and the images)
+// are extracted to the "prepared" subdirectory of the instance cache, under the
+// key of the archive (see ArchiveListingCache::archiveKey()); the installation
+// manager uses both instead of opening the archive, as long as the archive did
+// not change
+//
+// prepared files are removed along with their download, and on startup for the
+// downloads that are gone; the oldest ones are also removed once their total size
+// goes over a limit
+//
+class DownloadPreparer
+{
+public:
+  DownloadPreparer();
+
+  // cancels the download being prepared and waits for the thread
+  //
+  ~DownloadPreparer();
+
+  // sets the cache directory of the instance, where the listings and the
+  // prepared files are stored
+  //
+  void setCacheDirectory(const QString& cacheDirectory);
+
+  // queues the given archive to be prepared
+  //
+  void prepare(const QString& archivePath);
+
+  // removes the prepared files of archives that are not in the given downloads
+  // directory anymore in the background, and then the oldest ones until the
+  // total size is under the limit
+  //
+  void prune(const QString& downloadsDirectory);
+
+  // removes the prepared files of the given archive, if any, used when a download
+  // is deleted
+  //
+  // the archive is dropped from the queue, and if it is being prepared, the
+  // extraction is cancelled and this waits until the thread is done with it so
+  // the files are not recreated once removed
+  //
+  void remove(const QString& archivePath);
+
+  // returns the directory containing the files extracted from the given archive,
+  // or an empty string if the archive was not prepared or changed since
+  //
+  // files are stored under their path in the archive
+  //
+  static QString preparedDirectory(const QString& cacheDirectory,
+                                   const QString& archivePath);
+
+private:
+  std::mutex m_Mutex;
+  std::condition_variable m_Wake;
+  std::deque<QString> m_Queue;
+
+  // downloads directory given to prune(), empty if there is nothing to prune
+  QString m_PruneDirectory;
+  QString m_CacheDirectory;
+  ArchiveListingCache m_ListingCache;
+
+  // also read without the mutex while an archive is prepared
+  std::atomic<bool> m_Stop;
+
+  // archive being prepared, used to cancel the extraction on shutdown
+  Archive* m_Current;
+
+  // path of the archive being prepared, empty while the thread is idle; remove()
+  // sets m_CancelCurrent and waits on m_Done until it is cleared
+  QString m_CurrentPath;
+  std::atomic<bool> m_CancelCurrent;
+  std::condition_variable m_Done;
+
+  std::thread m_Thread;
+
+  void run();
+  void prepareArchive(Archive& archive, const QString& archivePath,
+                      const QString& cacheDirectory,
+                      const ArchiveListingCache& listingCache);
+
+  // whether the archive being prepared should be left alone, on shutdown or
+  // because it is being removed
+  //
+  bool cancelled() const;
+};
+
+#endif  // DOWNLOADPREPARER_H
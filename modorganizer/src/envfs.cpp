@@ -285,18 +285,18 @@ void forEachEntryImpl(void* cx, HandleCloserThread& hc,
       if (!isDotDir(&ObjectName)) {
         ObjectName.MaximumLength = ObjectName.Length;
 
+        FILETIME ft;
+        ft.dwLowDateTime  = DirInfo->LastWriteTime.LowPart;
+        ft.dwHighDateTime = DirInfo->LastWriteTime.HighPart;
+
         if (DirInfo->FileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
           if (dirStartF && dirEndF) {
-            dirStartF(cx, toStringView(&oa));
+            dirStartF(cx, toStringView(&oa), ft);
             forEachEntryImpl(cx, hc, buffers, &oa, depth + 1, dirStartF, dirEndF,
                              fileF);
             dirEndF(cx, toStringView(&oa));
           }
         } else {
-          FILETIME ft;
-          ft.dwLowDateTime  = DirInfo->LastWriteTime.LowPart;
-          ft.dwHighDateTime = DirInfo->LastWriteTime.HighPart;
-
           fileF(cx, toStringView(&oa), ft, DirInfo->AllocationSize.QuadPart);
         }
       }
@@ -376,7 +376,7 @@ Directory getFilesAndDirs(const std::wstring& path)
 
   env::forEachEntry(
       path, &cx,
-      [](void* pcx, std::wstring_view path) {
+      [](void* pcx, std::wstring_view path, FILETIME) {
         Context* cx = (Context*)pcx;
 
         cx->current.top()->dirs.push_back(Directory(path));
@@ -165,7 +165,8 @@ private:
   std::list<ThreadInfo> m_threads;
 };
 
-using DirStartF = void(void*, std::wstring_view);
+// the time given when a directory starts is its last modification time
+using DirStartF = void(void*, std::wstring_view, FILETIME);
 using DirEndF   = void(void*, std::wstring_view);
 using FileF     = void(void*, std::wstring_view, FILETIME, uint64_t);
 
@@ -29,13 +29,27 @@ const std::type_index ModDataContentIndex{typeid(ModDataContent)};
 class GameFeatures::CombinedModDataChecker : public ModDataChecker
 {
   std::vector<std::shared_ptr<ModDataChecker>> m_modDataCheckers;
-  mutable std::shared_ptr<ModDataChecker> m_fixer = nullptr;
+
+  // returns the first checker that does not consider the tree invalid, or null
+  //
+  // nothing is remembered between calls, installers check trees concurrently (see
+  // IPluginInstaller::supportsConcurrentChecks())
+  std::pair<std::shared_ptr<ModDataChecker>, CheckReturn>
+  findChecker(std::shared_ptr<const MOBase::IFileTree> const& fileTree) const
+  {
+    for (auto& modDataChecker : m_modDataCheckers) {
+      auto check = modDataChecker->dataLooksValid(fileTree);
+      if (check != CheckReturn::INVALID) {
+        return {modDataChecker, check};
+      }
+    }
+    return {nullptr, CheckReturn::INVALID};
+  }
 
 public:
   void setCheckers(std::vector<std::shared_ptr<ModDataChecker>> checkers)
   {
     m_modDataCheckers = std::move(checkers);
-    m_fixer           = nullptr;
   }
 
   bool isValid() const { return !m_modDataCheckers.empty(); }
@@ -43,29 +57,17 @@ public:
   CheckReturn
   dataLooksValid(std::shared_ptr<const MOBase::IFileTree> fileTree) const override
   {
-    m_fixer = nullptr;
-
-    for (auto& modDataChecker : m_modDataCheckers) {
-      auto check = modDataChecker->dataLooksValid(fileTree);
-
-      switch (check) {
-      case CheckReturn::FIXABLE:
-        m_fixer = modDataChecker;
-        [[fallthrough]];
-      case CheckReturn::VALID:
-        return CheckReturn::VALID;
-      case CheckReturn::INVALID:
-        break;
-      }
-    }
-    return CheckReturn::INVALID;
+    // fixable trees are reported as valid
+    return findChecker(fileTree).second == CheckReturn::INVALID ? CheckReturn::INVALID
+                                                                : CheckReturn::VALID;
   }
 
   std::shared_ptr<MOBase::IFileTree>
   fix(std::shared_ptr<MOBase::IFileTree> fileTree) const override
   {
-    if (m_fixer) {
-      return m_fixer->fix(fileTree);
+    auto [checker, check] = findChecker(fileTree);
+    if (check == CheckReturn::FIXABLE) {
+      return checker->fix(fileTree);
     }
 
     return nullptr;
@@ -17,6 +17,7 @@ You should have received a copy of the GNU General Public License
 along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <optional>
 #include <tuple>
 
 #include "installationmanager.h"
@@ -56,6 +57,8 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <boost/scoped_ptr.hpp>
 
 #include "archivefiletree.h"
+#include "downloadpreparer.h"
+#include "installerdetection.h"
 
 using namespace MOBase;
 using namespace MOShared;
@@ -84,6 +87,11 @@ InstallationManager::InstallationManager() : m_ParentWidget(nullptr), m_IsRunnin
   if (!m_ArchiveHandler->isValid()) {
     throw MyException(getErrorString(m_ArchiveHandler->getLastError()));
   }
+
+  // the user waits for the extractions done here, unlike the preparation of
+  // downloads (see DownloadPreparer), so all the cores are used
+  m_ArchiveHandler->setDecodeThreadCount(0);
+
   m_ArchiveHandler->setLogCallback([](auto level, auto const& message) {
     using LogLevel = Archive::LogLevel;
     switch (level) {
@@ -239,6 +247,9 @@ bool InstallationManager::extractFiles(QString extractPath, QString title,
     future = futureWatcher.future();
   }
 
+  // summed over the install, see postInstallCleanup()
+  m_ExtractionStats += m_ArchiveHandler->getExtractionStats();
+
   // Check the result:
   if (!future.result()) {
     if (m_ArchiveHandler->getLastError() == Archive::Error::ERROR_EXTRACT_CANCELLED) {
@@ -273,9 +284,6 @@ QStringList InstallationManager::extractFiles(
                  return entry->isFile();
                });
 
-  // Update the archive:
-  ArchiveFileTree::mapToArchive(*m_ArchiveHandler, files);
-
   // Retrieve the file path:
   QStringList result;
 
@@ -285,6 +293,17 @@ QStringList InstallationManager::extractFiles(
     m_TempFilesToDelete.insert(path);
   }
 
+  // the files may have been extracted when the download finished
+  if (copyPreparedFiles(files)) {
+    return result;
+  }
+
+  // Update the archive, the installation starts over if the tree doesn't match it
+  if (!openPendingArchive()) {
+    return QStringList();
+  }
+  ArchiveFileTree::mapToArchive(*m_ArchiveHandler, files);
+
   if (!extractFiles(QDir::tempPath(), tr("Extracting files"), false, silent)) {
     return QStringList();
   }
@@ -508,7 +527,7 @@ InstallationResult InstallationManager::doInstall(GuessedValue<QString>& modName
     return {IPluginInstaller::RESULT_CANCELED};
   }
 
-  // Copy the created files:
+  // Move the created files, they are temporary anyway:
   for (auto& p : m_CreatedFiles) {
     QString destPath =
         QDir::cleanPath(targetDirectory + QDir::separator() + p.first->path());
@@ -524,7 +543,11 @@ InstallationResult InstallationManager::doInstall(GuessedValue<QString>& modName
       dir.mkpath(".");
     }
 
-    QFile::copy(p.second, destPath);
+    // renaming is instant when the temporary directory is on the same volume as the
+    // mods, copy otherwise
+    if (!QFile::rename(p.second, destPath)) {
+      QFile::copy(p.second, destPath);
+    }
   }
 
   QSettings settingsFile(targetDirectory + "/meta.ini", QSettings::IniFormat);
@@ -576,13 +599,164 @@ bool InstallationManager::isRunning() const
   return m_IsRunning;
 }
 
+bool InstallationManager::openArchive(const QString& fileName)
+{
+  bool archiveOpen =
+      m_ArchiveHandler->open(fileName.toStdWString(), [this]() -> std::wstring {
+        m_Password = QString();
+
+        // Note: If we are not in the Qt event thread, we cannot use queryPassword()
+        // directly, so we emit passwordRequested() that is connected to
+        // queryPassword(). The connection is made using Qt::BlockingQueuedConnection,
+        // so the emit "call" is actually blocking. We cannot use emit if we are in the
+        // even thread, otherwize we have a deadlock.
+        if (QThread::currentThread() != QApplication::instance()->thread()) {
+          emit passwordRequested();
+        } else {
+          queryPassword();
+        }
+        return m_Password.toStdWString();
+      });
+  if (!archiveOpen) {
+    log::debug("integrated archiver can't open {}: {} ({})", fileName,
+               getErrorString(m_ArchiveHandler->getLastError()),
+               m_ArchiveHandler->getLastError());
+  }
+
+  return archiveOpen;
+}
+
+bool InstallationManager::openPendingArchive()
+{
+  if (m_PendingArchive.isEmpty()) {
+    return !m_ListingMismatch;
+  }
+
+  const QString fileName = m_PendingArchive;
+  m_PendingArchive.clear();
+
+  if (!openArchive(fileName)) {
+    throw MyException(tr("Failed to open %1: %2")
+                          .arg(fileName)
+                          .arg(getErrorString(m_ArchiveHandler->getLastError())));
+  }
+
+  // the tree refers to entries by index, they must match the cached listing
+  const auto& files = m_ArchiveHandler->getFileList();
+  bool matches      = files.size() == m_CachedFiles.size();
+  for (std::size_t i = 0; matches && i < files.size(); ++i) {
+    matches = files[i]->getArchiveFilePath() == m_CachedFiles[i]->getArchiveFilePath();
+  }
+
+  if (!matches) {
+    log::warn("the content of {} does not match its cached listing, removing it",
+              fileName);
+    m_ListingCache.remove(fileName);
+    m_ListingMismatch = true;
+  }
+
+  return matches;
+}
+
+std::vector<FileData*> InstallationManager::cachedFiles() const
+{
+  std::vector<FileData*> files;
+  files.reserve(m_CachedFiles.size());
+
+  for (auto& f : m_CachedFiles) {
+    files.push_back(f.get());
+  }
+
+  return files;
+}
+
+void InstallationManager::logExtractionStats()
+{
+  const auto stats = std::exchange(m_ExtractionStats, {});
+  if (stats.entries == 0) {
+    return;
+  }
+
+  auto ms = [](std::chrono::nanoseconds d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+  };
+
+  auto mb = [](uint64_t bytes) {
+    return static_cast<double>(bytes) / (1024 * 1024);
+  };
+
+  log::info("extracted {} entries to {} files, {:.1f} MB decoded, {:.1f} MB written "
+            "in {:.0f}ms (decode {:.0f}ms, create {:.0f}ms, write {:.0f}ms, "
+            "close {:.0f}ms, callbacks {:.0f}ms)",
+            stats.entries, stats.files, mb(stats.bytesDecoded), mb(stats.bytesWritten),
+            ms(stats.total), ms(stats.decode), ms(stats.create), ms(stats.write),
+            ms(stats.close), ms(stats.callbacks));
+}
+
+bool InstallationManager::copyPreparedFiles(
+    std::vector<std::shared_ptr<const FileTreeEntry>> const& entries)
+{
+  if (m_PreparedDirectory.isEmpty()) {
+    return false;
+  }
+
+  // the entries of the archive, whether it was opened or not
+  const std::vector<FileData*> files =
+      m_PendingArchive.isEmpty() ? m_ArchiveHandler->getFileList() : cachedFiles();
+
+  ArchiveFileTree::mapToArchive(files, entries);
+
+  ON_BLOCK_EXIT([&files]() {
+    for (auto* f : files) {
+      f->clearOutputFilePaths();
+    }
+  });
+
+  // only use the prepared files if all of them are there
+  for (auto* f : files) {
+    if (!f->getOutputFilePaths().empty() &&
+        !QFileInfo::exists(m_PreparedDirectory + "/" +
+                           QString::fromStdWString(f->getArchiveFilePath()))) {
+      return false;
+    }
+  }
+
+  for (auto* f : files) {
+    const QString source =
+        m_PreparedDirectory + "/" + QString::fromStdWString(f->getArchiveFilePath());
+
+    for (auto const& output : f->getOutputFilePaths()) {
+      const QString destPath = QDir::tempPath() + "/" + QString::fromStdWString(output);
+
+      if (QFile::exists(destPath)) {
+        QFile::remove(destPath);
+      }
+
+      QFileInfo(destPath).absoluteDir().mkpath(".");
+
+      if (!QFile::copy(source, destPath)) {
+        log::warn("failed to copy prepared file {} to {}", source, destPath);
+        return false;
+      }
+    }
+  }
+
+  log::debug("using prepared files from {}", m_PreparedDirectory);
+  return true;
+}
+
 void InstallationManager::postInstallCleanup()
 {
+  logExtractionStats();
+
   // Clear the list of created files:
   m_CreatedFiles.clear();
 
   // Close the archive:
   m_ArchiveHandler->close();
+  m_PendingArchive.clear();
+  m_CachedFiles.clear();
+  m_PreparedDirectory.clear();
 
   // directories we may want to remove. sorted from longest to shortest to ensure we
   // remove subdirectories first.
@@ -722,34 +896,34 @@ InstallationResult InstallationManager::install(const QString& fileName,
   // installer when it uncompresses a split archive, then finds it has a real archive
   // to deal with.
   m_ArchiveHandler->close();
+  m_PendingArchive.clear();
+  m_CachedFiles.clear();
 
-  // open the archive and construct the directory tree the installers work on
+  // construct the directory tree the installers work on, from the cached listing if
+  // the archive was installed before, in which case the archive is only opened once
+  // files have to be extracted
 
-  bool archiveOpen =
-      m_ArchiveHandler->open(fileName.toStdWString(), [this]() -> std::wstring {
-        m_Password = QString();
+  std::shared_ptr<IFileTree> filesTree;
 
-        // Note: If we are not in the Qt event thread, we cannot use queryPassword()
-        // directly, so we emit passwordRequested() that is connected to
-        // queryPassword(). The connection is made using Qt::BlockingQueuedConnection,
-        // so the emit "call" is actually blocking. We cannot use emit if we are in the
-        // even thread, otherwize we have a deadlock.
-        if (QThread::currentThread() != QApplication::instance()->thread()) {
-          emit passwordRequested();
-        } else {
-          queryPassword();
-        }
-        return m_Password.toStdWString();
-      });
-  if (!archiveOpen) {
-    log::debug("integrated archiver can't open {}: {} ({})", fileName,
-               getErrorString(m_ArchiveHandler->getLastError()),
-               m_ArchiveHandler->getLastError());
+  // when starting over because the listing didn't match the archive, it's skipped in
+  // case it could not be removed
+  if (!std::exchange(m_ListingMismatch, false)) {
+    m_CachedFiles = m_ListingCache.get(fileName);
   }
+
+  if (!m_CachedFiles.empty()) {
+    log::debug("using cached listing of {} entries for {}", m_CachedFiles.size(),
+               fileName);
+    filesTree        = ArchiveFileTree::makeTree(cachedFiles());
+    m_PendingArchive = fileName;
+  } else if (openArchive(fileName)) {
+    filesTree = ArchiveFileTree::makeTree(*m_ArchiveHandler);
+    m_ListingCache.put(fileName, m_ArchiveHandler->getFileList());
+  }
+
   ON_BLOCK_EXIT(std::bind(&InstallationManager::postInstallCleanup, this));
 
-  std::shared_ptr<IFileTree> filesTree =
-      archiveOpen ? ArchiveFileTree::makeTree(*m_ArchiveHandler) : nullptr;
+  m_PreparedDirectory = DownloadPreparer::preparedDirectory(m_CacheDirectory, fileName);
 
   auto installers = m_PluginContainer->plugins<IPluginInstaller>();
 
@@ -758,15 +932,26 @@ InstallationResult InstallationManager::install(const QString& fileName,
               return lhs->priority() > rhs->priority();
             });
 
+  std::erase_if(installers, [this](IPluginInstaller* installer) {
+    // installer can't be null here but vc static code analysis thinks it could
+    return (installer == nullptr) || !m_PluginContainer->isEnabled(installer);
+  });
+
+  // the installers that support it check the tree concurrently, the results are
+  // consumed in priority order below
+  std::optional<InstallerDetection> detection;
+  if (filesTree != nullptr) {
+    detection.emplace(installers, filesTree);
+  }
+
+  auto isArchiveSupported = [&](IPluginInstaller* installer) {
+    return (filesTree != nullptr) &&
+           detection->isArchiveSupported(installer, filesTree);
+  };
+
   InstallationResult installResult(IPluginInstaller::RESULT_NOTATTEMPTED);
 
   for (IPluginInstaller* installer : installers) {
-    // don't use inactive installers (installer can't be null here but vc static code
-    // analysis thinks it could)
-    if ((installer == nullptr) || !m_PluginContainer->isEnabled(installer)) {
-      continue;
-    }
-
     // try only manual installers if that was requested
     if (installResult.result() == IPluginInstaller::RESULT_MANUALREQUESTED) {
       if (!installer->isManualInstaller()) {
@@ -780,8 +965,7 @@ InstallationResult InstallationManager::install(const QString& fileName,
       {  // simple case
         IPluginInstallerSimple* installerSimple =
             dynamic_cast<IPluginInstallerSimple*>(installer);
-        if ((installerSimple != nullptr) && (filesTree != nullptr) &&
-            (installer->isArchiveSupported(filesTree))) {
+        if ((installerSimple != nullptr) && isArchiveSupported(installer)) {
           installResult.m_result =
               installerSimple->install(modName, filesTree, version, modID);
           if (installResult) {
@@ -799,15 +983,19 @@ InstallationResult InstallationManager::install(const QString& fileName,
             // stops at this root):
             p->detach();
 
-            p->mapToArchive(*m_ArchiveHandler);
+            // the installation starts over below if the tree doesn't match the archive
+            if (openPendingArchive()) {
+              p->mapToArchive(*m_ArchiveHandler);
 
-            // Clean the created files:
-            cleanCreatedFiles(filesTree);
+              // Clean the created files:
+              cleanCreatedFiles(filesTree);
 
-            // the simple installer only prepares the installation, the rest
-            // works the same for all installers
-            installResult = doInstall(modName, gameName, modID, version, newestVersion,
-                                      categoryID, fileCategoryID, repository);
+              // the simple installer only prepares the installation, the rest
+              // works the same for all installers
+              installResult = doInstall(modName, gameName, modID, version,
+                                        newestVersion, categoryID, fileCategoryID,
+                                        repository);
+            }
           }
         }
       }
@@ -816,7 +1004,7 @@ InstallationResult InstallationManager::install(const QString& fileName,
         IPluginInstallerCustom* installerCustom =
             dynamic_cast<IPluginInstallerCustom*>(installer);
         if ((installerCustom != nullptr) &&
-            (((filesTree != nullptr) && installer->isArchiveSupported(filesTree)) ||
+            (isArchiveSupported(installer) ||
              ((filesTree == nullptr) &&
               installerCustom->isArchiveSupported(fileName)))) {
           std::set<QString> installerExt = installerCustom->supportedExtensions();
@@ -835,6 +1023,14 @@ InstallationResult InstallationManager::install(const QString& fileName,
       log::error("plugin \"{}\" incompatible: {}", installer->name(), e.what());
     }
 
+    if (m_ListingMismatch) {
+      // the tree was built from a listing that doesn't match the archive so no file
+      // could be extracted from it, start over with the tree of the archive itself
+      log::warn("installing {} again from the content of the archive", fileName);
+      postInstallCleanup();
+      return install(fileName, modName, modID);
+    }
+
     // act upon the installation result. at this point the files have already been
     // extracted to the correct location
     switch (installResult.result()) {
@@ -25,6 +25,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <iinstallationmanager.h>
 #include <iplugininstaller.h>
 
+#include <QDir>
 #include <QObject>
 #define WIN32_LEAN_AND_MEAN
 #include <QProgressDialog>
@@ -34,6 +35,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <map>
 #include <set>
 
+#include "archivelistingcache.h"
 #include "modinfo.h"
 #include "plugincontainer.h"
 
@@ -140,6 +142,16 @@ public:
     m_DownloadsDirectory = downloadDirectory;
   }
 
+  /**
+   * @brief update the directory where archive listings are cached
+   * @param cacheDirectory the cache directory of the instance
+   */
+  void setCacheDirectory(const QString& cacheDirectory)
+  {
+    m_CacheDirectory = cacheDirectory;
+    m_ListingCache.setCacheDirectory(cacheDirectory);
+  }
+
   /**
    * @brief install a mod from an archive
    *
@@ -330,6 +342,48 @@ private:
   bool extractFiles(QString extractPath, QString title, bool showFilenames,
                     bool silent);
 
+  /**
+   * @brief Open the given archive in the archive handler, asking for a password if
+   *     needed.
+   *
+   * @return true if the archive was opened, false otherwise.
+   */
+  bool openArchive(const QString& fileName);
+
+  /**
+   * @brief Open the archive being installed if its tree was built from a cached
+   *     listing and it has not been opened yet.
+   *
+   * This must be called before mapping entries of the tree to the archive. An
+   * exception is thrown if the archive cannot be opened.
+   *
+   * @return false if the content of the archive does not match the listing, in
+   *     which case the listing is removed and the tree cannot be mapped, see
+   *     m_ListingMismatch.
+   */
+  bool openPendingArchive();
+
+  /**
+   * @return the entries of the cached listing of the archive being installed.
+   */
+  std::vector<FileData*> cachedFiles() const;
+
+  /**
+   * @brief Copy the given entries to the temporary directory from the files that
+   *     were extracted when the archive was downloaded (see DownloadPreparer).
+   *
+   * @return true if all the entries were copied, false if some of them were not
+   *     prepared, in which case they must be extracted from the archive.
+   */
+  bool copyPreparedFiles(
+      std::vector<std::shared_ptr<const MOBase::FileTreeEntry>> const& entries);
+
+  /**
+   * @brief Log the counters of the extractions done for the current install, and
+   *     reset them.
+   */
+  void logExtractionStats();
+
 private:
   // The plugin container, mostly to check if installer are enabled or not.
   const PluginContainer* m_PluginContainer;
@@ -346,6 +400,24 @@ private:
   QString m_CurrentFile;
   QString m_Password;
 
+  // Listings of the archives that were installed before, and the archive whose tree
+  // was built from its cached listing but that has not been opened yet.
+  ArchiveListingCache m_ListingCache;
+  QString m_PendingArchive;
+  std::vector<std::unique_ptr<FileData>> m_CachedFiles;
+
+  // Set when the archive did not match its cached listing, install() then starts
+  // over from the archive itself.
+  bool m_ListingMismatch = false;
+
+  // Files extracted from the archive being installed when it was downloaded, if any,
+  // they are stored in the cache directory of the instance.
+  QString m_CacheDirectory;
+  QString m_PreparedDirectory;
+
+  // Counters of the extractions done for the current install.
+  Archive::ExtractionStats m_ExtractionStats;
+
   // Map from entries in the tree that is used by the installer and absolute
   // paths to temporary files.
   std::map<std::shared_ptr<const MOBase::FileTreeEntry>, QString> m_CreatedFiles;
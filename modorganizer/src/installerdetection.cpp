@@ -0,0 +1,123 @@
+#include "installerdetection.h"
+
+#include <log.h>
+
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+
+using namespace MOBase;
+
+InstallerDetection::InstallerDetection(std::vector<IPluginInstaller*> const& installers,
+                                       std::shared_ptr<const IFileTree> tree)
+    : m_Tree(std::move(tree)), m_Stop(false), m_Finished(false)
+{
+  for (auto* installer : installers) {
+    if (installer->supportsConcurrentChecks()) {
+      m_Checks.push_back(std::make_unique<Check>(Check{.installer = installer}));
+    }
+  }
+
+  if (m_Checks.empty()) {
+    return;
+  }
+
+  // trees are populated when they are first read, walking the whole tree here
+  // means the checks never modify it
+  m_Tree->walk([](auto&&, auto&&) {
+    return IFileTree::WalkReturn::CONTINUE;
+  });
+
+  // the checks are queued in priority order, so the thread pool starts with the
+  // installers that are consumed first
+  for (auto& check : m_Checks) {
+    check->future = QtConcurrent::run([this, c = check.get()] {
+      run(*c);
+    });
+  }
+}
+
+InstallerDetection::~InstallerDetection()
+{
+  finish();
+}
+
+bool InstallerDetection::isArchiveSupported(IPluginInstaller* installer,
+                                            std::shared_ptr<const IFileTree> tree)
+{
+  if (!m_Finished) {
+    auto itor = std::find_if(m_Checks.begin(), m_Checks.end(), [&](auto&& check) {
+      return check->installer == installer;
+    });
+
+    if (itor != m_Checks.end()) {
+      Check& check = **itor;
+      check.future.waitForFinished();
+
+      if (check.error) {
+        std::rethrow_exception(check.error);
+      }
+
+      if (check.supported) {
+        // the installer is probably the one that is used, the tree will be given
+        // to it
+        finish();
+      }
+
+      return check.supported;
+    }
+  }
+
+  // installers that may ask the user are checked here, on the calling thread
+  const bool supported = installer->isArchiveSupported(tree);
+
+  if (supported) {
+    finish();
+  }
+
+  return supported;
+}
+
+void InstallerDetection::finish()
+{
+  if (m_Finished) {
+    return;
+  }
+
+  m_Finished = true;
+  m_Stop     = true;
+
+  for (auto& check : m_Checks) {
+    check->future.waitForFinished();
+  }
+
+  for (auto& check : m_Checks) {
+    if (!check->ran) {
+      log::debug("installer '{}' was not checked", check->installer->name());
+      continue;
+    }
+
+    log::debug("installer '{}' {} the archive, checked in {:.1f}ms",
+               check->installer->name(),
+               check->supported ? "supports" : "does not support",
+               std::chrono::duration<double, std::milli>(check->time).count());
+  }
+}
+
+void InstallerDetection::run(Check& check) const
+{
+  if (m_Stop) {
+    return;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+
+  try {
+    check.supported = check.installer->isArchiveSupported(m_Tree);
+  } catch (...) {
+    check.error = std::current_exception();
+  }
+
+  check.time = std::chrono::steady_clock::now() - start;
+  check.ran  = true;
+}
@@ -0,0 +1,75 @@
+#ifndef INSTALLERDETECTION_H
+#define INSTALLERDETECTION_H
+
+#include <ifiletree.h>
+#include <iplugininstaller.h>
+
+#include <QFuture>
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <vector>
+
+// runs the support checks of the installers concurrently on the tree of the
+// archive being installed (see InstallationManager::install())
+//
+// every installer walks the tree on its own in isArchiveSupported(), which takes
+// seconds for large archives when done one installer after the other;
+// the tree is fully populated before the checks start so they only read it, and
+// the results are consumed in priority order, the first supported installer
+// stops the checks that did not start yet
+//
+// only the installers that return true from supportsConcurrentChecks() are
+// checked on the thread pool, the others are checked on the calling thread when
+// their result is needed since they may ask the user
+//
+class InstallerDetection
+{
+public:
+  // starts the checks of the given installers that support it, in this order
+  //
+  InstallerDetection(std::vector<MOBase::IPluginInstaller*> const& installers,
+                     std::shared_ptr<const MOBase::IFileTree> tree);
+
+  // waits for the checks that are running
+  //
+  ~InstallerDetection();
+
+  // returns whether the given installer supports the tree
+  //
+  // this waits for the concurrent check of the installer and rethrows the
+  // exception it threw, if any; installers that are not checked concurrently,
+  // and every installer once a check succeeded, are checked on the calling
+  // thread with the given tree, which installers may have replaced since
+  //
+  bool isArchiveSupported(MOBase::IPluginInstaller* installer,
+                          std::shared_ptr<const MOBase::IFileTree> tree);
+
+  // skips the checks that did not start, waits for the others and logs the time
+  // spent in each of them; the tree can be modified once this returns
+  //
+  void finish();
+
+private:
+  struct Check
+  {
+    MOBase::IPluginInstaller* installer;
+    QFuture<void> future;
+
+    bool ran       = false;
+    bool supported = false;
+    std::exception_ptr error;
+    std::chrono::nanoseconds time{0};
+  };
+
+  std::shared_ptr<const MOBase::IFileTree> m_Tree;
+  std::vector<std::unique_ptr<Check>> m_Checks;
+  std::atomic<bool> m_Stop;
+  bool m_Finished;
+
+  void run(Check& check) const;
+};
+
+#endif  // INSTALLERDETECTION_H
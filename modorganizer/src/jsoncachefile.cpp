@@ -0,0 +1,87 @@
+#include "jsoncachefile.h"
+
+#include <log.h>
+#include <safewritefile.h>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+
+using namespace MOBase;
+
+JsonCacheFile::JsonCacheFile(QString what, std::function<QJsonObject()> entries)
+    : m_What(std::move(what)), m_Entries(std::move(entries)),
+      m_Writer(std::bind(&JsonCacheFile::doWrite, this), 2000)
+{}
+
+QJsonObject JsonCacheFile::load(const QString& path, const QString& stamp)
+{
+  {
+    std::scoped_lock lock(m_Mutex);
+    m_Path  = path;
+    m_Stamp = stamp;
+  }
+
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    // no cache yet
+    return {};
+  }
+
+  QJsonParseError e;
+  const auto doc = QJsonDocument::fromJson(file.readAll(), &e);
+  if (doc.isNull()) {
+    log::warn("failed to parse {} cache '{}': {}", m_What, path, e.errorString());
+    return {};
+  }
+
+  const auto root = doc.object();
+  if (root["stamp"].toString() != stamp) {
+    log::debug("{} cache was written for '{}', discarding", m_What,
+               root["stamp"].toString());
+    return {};
+  }
+
+  return root["entries"].toObject();
+}
+
+void JsonCacheFile::save()
+{
+  // the writer uses a timer, which must be started from its thread
+  QMetaObject::invokeMethod(&m_Writer, [this] {
+    m_Writer.write();
+  });
+}
+
+void JsonCacheFile::flush()
+{
+  m_Writer.writeImmediately(true);
+}
+
+void JsonCacheFile::doWrite()
+{
+  QString path, stamp;
+
+  {
+    std::scoped_lock lock(m_Mutex);
+    path  = m_Path;
+    stamp = m_Stamp;
+  }
+
+  if (path.isEmpty()) {
+    return;
+  }
+
+  QJsonObject root{{"stamp", stamp}, {"entries", m_Entries()}};
+
+  try {
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    SafeWriteFile file(path);
+    file->write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    file.commitIfDifferent(m_LastHash);
+  } catch (const std::exception& e) {
+    log::error("failed to write {} cache '{}': {}", m_What, path, e.what());
+  }
+}
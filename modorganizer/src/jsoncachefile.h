@@ -0,0 +1,58 @@
+#ifndef JSONCACHEFILE_H
+#define JSONCACHEFILE_H
+
+#include <delayedfilewriter.h>
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+
+#include <functional>
+#include <mutex>
+
+// a cache stored as a single JSON file in the cache directory of the instance,
+// used by the caches that keep one entry per mod or per file (see
+// ModContentsCache and PluginHeaderCache)
+//
+// the file contains a stamp telling what the entries were written for and an
+// object with the entries; the owner keeps the entries in memory and gives them
+// back as JSON when the file is written, which happens after a delay and only if
+// the content changed
+//
+class JsonCacheFile
+{
+public:
+  // `what` is used in log messages, `entries` is called on the main thread when
+  // the file is written
+  //
+  JsonCacheFile(QString what, std::function<QJsonObject()> entries);
+
+  // returns the entries stored in the given file, or an empty object if the
+  // file does not exist, cannot be parsed or was written with another stamp;
+  // the file is written to the same path afterwards
+  //
+  QJsonObject load(const QString& path, const QString& stamp);
+
+  // schedules a write of the file, this can be called from any thread
+  //
+  void save();
+
+  // writes pending changes immediately
+  //
+  void flush();
+
+private:
+  const QString m_What;
+  const std::function<QJsonObject()> m_Entries;
+
+  QString m_Path;
+  QString m_Stamp;
+  mutable std::mutex m_Mutex;
+
+  QByteArray m_LastHash;
+  MOBase::DelayedFileWriter m_Writer;
+
+  void doWrite();
+};
+
+#endif  // JSONCACHEFILE_H
@@ -1715,10 +1715,18 @@ void MainWindow::startExeAction()
 
 void MainWindow::activateSelectedProfile()
 {
+  // pick up mods that were added or removed on disk before switching, the
+  // current profile is refreshed too so the old and the new profile refer to the
+  // same list of mods when the structure is switched
+  m_OrganizerCore.currentProfile()->writeModlistNow(true);
+  m_OrganizerCore.updateModInfoFromDisc();
+  m_OrganizerCore.currentProfile()->refreshModStatus();
+
   m_OrganizerCore.setCurrentProfile(ui->profileBox->currentText());
 
   m_SavesTab->refreshSaveList();
-  m_OrganizerCore.refresh();
+  m_OrganizerCore.modList()->notifyChange(-1);
+  updateSortButton();
   ui->modList->updateModCount();
   ui->espList->updatePluginCount();
   ui->statusBar->updateNormalMessage(m_OrganizerCore);
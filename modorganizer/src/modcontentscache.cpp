@@ -0,0 +1,173 @@
+#include "modcontentscache.h"
+#include "shared/filesorigin.h"
+
+#include <log.h>
+
+#include <QDateTime>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QJsonArray>
+
+using namespace MOBase;
+using namespace MOShared;
+
+// converts a FILETIME stored as an integer to ms since epoch
+//
+static qint64 fileTimeToMSecs(uint64_t t)
+{
+  // FILETIME counts 100ns intervals since 1601-01-01
+  constexpr uint64_t EpochDifference = 116444736000000000;
+
+  if (t < EpochDifference) {
+    return 0;
+  }
+
+  return static_cast<qint64>((t - EpochDifference) / 10000);
+}
+
+ModContentsCache::ModContentsCache()
+    : m_File("mod contents", std::bind(&ModContentsCache::entries, this))
+{}
+
+ModContentsCache::Key ModContentsCache::makeKey(const QString& path,
+                                                const FilesOrigin* origin)
+{
+  Key key;
+
+  // the walk only reports the times of subdirectories, entries added or renamed
+  // at the top of the mod change the time of the mod directory itself
+  key.modified = QFileInfo(path).lastModified().toMSecsSinceEpoch();
+
+  if (origin != nullptr && !origin->isDisabled()) {
+    key.files    = origin->getFileCount();
+    key.modified = std::max(key.modified,
+                            fileTimeToMSecs(origin->getDirectoriesModified()));
+
+    return key;
+  }
+
+  // the contents only depend on the names of the files, so the times of the
+  // files themselves are not needed
+  QDirIterator iter(path, QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden |
+                              QDir::System,
+                    QDirIterator::Subdirectories);
+
+  while (iter.hasNext()) {
+    iter.next();
+
+    const auto fi = iter.fileInfo();
+    if (fi.isDir()) {
+      key.modified = std::max(key.modified, fi.lastModified().toMSecsSinceEpoch());
+    } else {
+      ++key.files;
+    }
+  }
+
+  return key;
+}
+
+void ModContentsCache::load(const QString& path, const QString& game)
+{
+  const auto mods = m_File.load(path, game);
+
+  std::scoped_lock lock(m_Mutex);
+  m_Entries.clear();
+
+  for (auto itor = mods.begin(); itor != mods.end(); ++itor) {
+    const auto mod = itor.value().toObject();
+
+    Entry entry;
+    entry.key.files    = mod["files"].toInteger();
+    entry.key.modified = mod["modified"].toInteger();
+
+    for (const auto& content : mod["contents"].toArray()) {
+      entry.contents.insert(content.toInt());
+    }
+
+    m_Entries.emplace(itor.key(), std::move(entry));
+  }
+
+  log::debug("loaded cached contents for {} mods", m_Entries.size());
+}
+
+std::optional<std::set<int>> ModContentsCache::find(const QString& mod,
+                                                      const Key& key) const
+{
+  std::scoped_lock lock(m_Mutex);
+
+  auto itor = m_Entries.find(mod);
+  if (itor == m_Entries.end()) {
+    return {};
+  }
+
+  const auto& cached = itor->second.key;
+  if (cached.files != key.files || cached.modified != key.modified) {
+    return {};
+  }
+
+  return itor->second.contents;
+}
+
+void ModContentsCache::store(const QString& mod, const Key& key,
+                             const std::set<int>& contents)
+{
+  {
+    std::scoped_lock lock(m_Mutex);
+    m_Entries[mod] = {key, contents};
+  }
+
+  m_File.save();
+}
+
+void ModContentsCache::invalidate(const QString& mod)
+{
+  {
+    std::scoped_lock lock(m_Mutex);
+    if (m_Entries.erase(mod) == 0) {
+      return;
+    }
+  }
+
+  m_File.save();
+}
+
+void ModContentsCache::retain(const std::set<QString>& mods)
+{
+  {
+    std::scoped_lock lock(m_Mutex);
+    const auto removed = std::erase_if(m_Entries, [&](auto&& entry) {
+      return !mods.contains(entry.first);
+    });
+
+    if (removed == 0) {
+      return;
+    }
+  }
+
+  m_File.save();
+}
+
+void ModContentsCache::flush()
+{
+  m_File.flush();
+}
+
+QJsonObject ModContentsCache::entries() const
+{
+  std::scoped_lock lock(m_Mutex);
+
+  QJsonObject mods;
+
+  for (const auto& [name, entry] : m_Entries) {
+    QJsonArray contents;
+    for (int content : entry.contents) {
+      contents.append(content);
+    }
+
+    mods.insert(name, QJsonObject{{"files", entry.key.files},
+                                  {"modified", entry.key.modified},
+                                  {"contents", contents}});
+  }
+
+  return mods;
+}
@@ -0,0 +1,86 @@
+#ifndef MODCONTENTSCACHE_H
+#define MODCONTENTSCACHE_H
+
+#include "jsoncachefile.h"
+#include "shared/fileregisterfwd.h"
+
+#include <QString>
+
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+
+// persistent cache of the contents of regular mods (see ModInfo::getContents())
+//
+// finding the contents of a mod requires building its file tree and running the
+// content checks of the game plugin, which adds up quickly with thousands of
+// mods; the contents are stored along with a key that tells whether the files
+// of the mod changed since, built from what the directory refresher found when
+// it walked the mod
+//
+class ModContentsCache
+{
+public:
+  // identifies the files of a mod on disk
+  //
+  struct Key
+  {
+    // number of files in the mod, at any depth
+    qint64 files = 0;
+
+    // most recent modification time of the directories of the mod, in ms since
+    // epoch; adding, removing or renaming an entry changes the time of its
+    // directory
+    qint64 modified = 0;
+  };
+
+  ModContentsCache();
+
+  // builds the key for the mod at the given path from its origin in the
+  // directory structure; the files of the mod are listed again when it has no
+  // origin, such as when it is disabled
+  //
+  static Key makeKey(const QString& path, const MOShared::FilesOrigin* origin);
+
+  // loads the cache from the given file, entries are discarded if they were
+  // written for another game or another version of the game plugin
+  //
+  void load(const QString& path, const QString& game);
+
+  // returns the cached contents of the given mod if the key matches
+  //
+  std::optional<std::set<int>> find(const QString& mod, const Key& key) const;
+
+  // stores the contents of the given mod and schedules a write of the cache
+  //
+  void store(const QString& mod, const Key& key, const std::set<int>& contents);
+
+  // forgets the contents of the given mod, used when MO knows the mod changed
+  //
+  void invalidate(const QString& mod);
+
+  // forgets the contents of the mods that are not in the given set, used after
+  // the mod list is read from disk so deleted and renamed mods are dropped
+  //
+  void retain(const std::set<QString>& mods);
+
+  // writes pending changes immediately
+  //
+  void flush();
+
+private:
+  struct Entry
+  {
+    Key key;
+    std::set<int> contents;
+  };
+
+  std::map<QString, Entry> m_Entries;
+  mutable std::mutex m_Mutex;
+  JsonCacheFile m_File;
+
+  QJsonObject entries() const;
+};
+
+#endif  // MODCONTENTSCACHE_H
@@ -273,6 +273,13 @@ void ModInfo::updateFromDisc(const QString& modsDirectory, OrganizerCore& core,
 
   std::sort(s_Collection.begin(), s_Collection.end(), ModInfo::ByName);
 
+  // drop the cached contents of the mods that were deleted or renamed
+  std::set<QString> modNames;
+  for (const auto& mod : s_Collection) {
+    modNames.insert(mod->internalName());
+  }
+  core.modContentsCache().retain(modNames);
+
   parallelMap(std::begin(s_Collection), std::end(s_Collection), &ModInfo::prefetch,
               refreshThreadCount);
 
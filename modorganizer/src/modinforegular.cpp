@@ -7,6 +7,8 @@
 #include "plugincontainer.h"
 #include "report.h"
 #include "settings.h"
+#include "shared/directoryentry.h"
+#include "shared/filesorigin.h"
 #include <iplugingame.h>
 
 #include <QApplication>
@@ -706,12 +708,36 @@ std::set<int> ModInfoRegular::doGetContents() const
   auto contentFeature =
       m_Core.pluginContainer().gameFeatures().gameFeature<ModDataContent>();
 
-  if (contentFeature) {
-    auto result = contentFeature->getContentsFor(fileTree());
-    return std::set<int>(std::begin(result), std::end(result));
+  if (!contentFeature) {
+    return {};
+  }
+
+  // the refresher already walked the mod if it is enabled
+  const auto* structure     = m_Core.directoryStructure();
+  const auto originName     = ToWString(internalName());
+  const FilesOrigin* origin = structure->originExists(originName)
+                                  ? &structure->getOriginByName(originName)
+                                  : nullptr;
+
+  auto& cache    = m_Core.modContentsCache();
+  const auto key = ModContentsCache::makeKey(absolutePath(), origin);
+
+  if (auto cached = cache.find(internalName(), key)) {
+    return *cached;
   }
 
-  return {};
+  auto result = contentFeature->getContentsFor(fileTree());
+  std::set<int> contents(std::begin(result), std::end(result));
+
+  cache.store(internalName(), key, contents);
+
+  return contents;
+}
+
+void ModInfoRegular::diskContentModified()
+{
+  ModInfoWithConflictInfo::diskContentModified();
+  m_Core.modContentsCache().invalidate(internalName());
 }
 
 int ModInfoRegular::getHighlight() const
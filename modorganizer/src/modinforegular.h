@@ -428,6 +428,14 @@ public:  // Plugin operations:
   virtual std::map<QString, QVariant>
   clearPluginSettings(const QString& pluginName) override;
 
+public slots:
+
+  /**
+   * @brief Notify this mod that the content of the disk may have changed, this also
+   *     drops the cached contents of the mod.
+   */
+  virtual void diskContentModified() override;
+
 private:
   void setEndorsedState(MOBase::EndorsedState endorsedState);
   void setTrackedState(MOBase::TrackedState trackedState);
@@ -55,6 +55,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <QWidgetAction>
 
 #include <algorithm>
+#include <set>
 #include <sstream>
 #include <stdexcept>
 
@@ -662,56 +663,27 @@ void ModList::changeModPriority(std::vector<int> sourceIndices, int newPriority)
 
   emit layoutAboutToBeChanged();
 
-  // sort the moving mods by ascending priorities
-  std::sort(sourceIndices.begin(), sourceIndices.end(),
-            [=](const int& LHS, const int& RHS) {
-              return m_Profile->getModPriority(LHS) > m_Profile->getModPriority(RHS);
-            });
-
-  // move mods that are decreasing in priority
-  for (const auto& index : sourceIndices) {
-    int oldPriority = m_Profile->getModPriority(index);
-    if (oldPriority > newPriority) {
-      if (m_Profile->setModPriority(index, newPriority)) {
-        m_ModMoved(ModInfo::getByIndex(index)->name(), oldPriority, newPriority);
-      }
-    }
-  }
-
-  // sort the moving mods by descending priorities
-  std::sort(sourceIndices.begin(), sourceIndices.end(),
-            [=](const int& LHS, const int& RHS) {
-              return m_Profile->getModPriority(LHS) < m_Profile->getModPriority(RHS);
-            });
-
-  // if at least one mod is increasing in priority, the target index is
-  // that of the row BELOW the dropped location, otherwise it's the one above
-  for (const auto& index : sourceIndices) {
-    int oldPriority = m_Profile->getModPriority(index);
-    if (oldPriority < newPriority) {
-      --newPriority;
-      break;
-    }
-  }
+  // all the mods are moved in a single pass, this is much faster than moving
+  // them one by one when a lot of mods are dragged at once
+  const std::vector<unsigned int> indices(sourceIndices.begin(), sourceIndices.end());
+  const std::set<unsigned int> moving(indices.begin(), indices.end());
 
-  // move mods that are increasing in priority
-  for (const auto& index : sourceIndices) {
-    int oldPriority = m_Profile->getModPriority(index);
-    if (oldPriority < newPriority) {
-      if (m_Profile->setModPriority(index, newPriority)) {
-        m_ModMoved(ModInfo::getByIndex(index)->name(), oldPriority, newPriority);
-      }
+  for (const auto& [index, oldPriority] : m_Profile->moveMods(indices, newPriority)) {
+    // mods that were only shifted are not reported as moved
+    if (moving.contains(index)) {
+      m_ModMoved(ModInfo::getByIndex(index)->name(), oldPriority,
+                 m_Profile->getModPriority(index));
     }
   }
 
   emit layoutChanged();
 
-  QModelIndexList indices;
+  QModelIndexList modelIndices;
   for (auto& idx : sourceIndices) {
-    indices.append(index(idx, 0, QModelIndex()));
+    modelIndices.append(index(idx, 0, QModelIndex()));
   }
 
-  emit modPrioritiesChanged(indices);
+  emit modPrioritiesChanged(modelIndices);
 }
 
 void ModList::changeModPriority(int sourceIndex, int newPriority)
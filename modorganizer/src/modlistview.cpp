@@ -1082,7 +1082,7 @@ void ModListView::setOverwriteMarkers(const QModelIndexList& indexes)
   }
   dataChanged(model()->index(0, 0),
               model()->index(model()->rowCount(), model()->columnCount()));
-  verticalScrollBar()->repaint();
+  m_scrollbar->invalidateMarkers();
 }
 
 void ModListView::refreshMarkersAndPlugins()
@@ -1130,7 +1130,7 @@ void ModListView::setHighlightedMods(const std::vector<unsigned int>& pluginIndi
   }
   dataChanged(model()->index(0, 0),
               model()->index(model()->rowCount(), model()->columnCount()));
-  verticalScrollBar()->repaint();
+  m_scrollbar->invalidateMarkers();
 }
 
 QColor ModListView::markerColor(const QModelIndex& index) const
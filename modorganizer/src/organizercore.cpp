@@ -104,11 +104,13 @@ OrganizerCore::OrganizerCore(Settings& settings)
 {
   env::setHandleCloserThreadCount(settings.refreshThreadCount());
   m_DownloadManager.setOutputDirectory(m_Settings.paths().downloads(), false);
+  m_DownloadManager.setCacheDirectory(m_Settings.paths().cache());
 
   NexusInterface::instance().setCacheDirectory(m_Settings.paths().cache());
 
   m_InstallationManager.setModsDirectory(m_Settings.paths().mods());
   m_InstallationManager.setDownloadDirectory(m_Settings.paths().downloads());
+  m_InstallationManager.setCacheDirectory(m_Settings.paths().cache());
 
   connect(&m_DownloadManager, SIGNAL(downloadSpeed(QString, int)), this,
           SLOT(downloadSpeed(QString, int)));
@@ -159,6 +161,8 @@ OrganizerCore::~OrganizerCore()
   }
 
   saveCurrentProfile();
+  m_ContentsCache.flush();
+  m_PluginHeaderCache.flush();
 
   // profile has to be cleaned up before the modinfo-buffer is cleared
   m_CurrentProfile.reset();
@@ -280,6 +284,14 @@ void OrganizerCore::setManagedGame(MOBase::IPluginGame* game)
   m_GameName   = game->gameName();
   m_GamePlugin = game;
   qApp->setProperty("managed_game", QVariant::fromValue(m_GamePlugin));
+
+  // content ids are defined by the game plugin, so the cache is only valid for
+  // the same version of the plugin
+  m_ContentsCache.load(
+      QDir(m_Settings.paths().cache()).absoluteFilePath("modcontents.json"),
+      game->gameName() + " " + game->version().canonicalString());
+  m_PluginHeaderCache.load(
+      QDir(m_Settings.paths().cache()).absoluteFilePath("pluginheaders.json"));
   emit managedGameChanged(m_GamePlugin);
 }
 
@@ -593,7 +605,12 @@ void OrganizerCore::setCurrentProfile(const QString& profileName)
           [this](auto&& indexes) {
             modStatusChanged(indexes);
           });
-  refreshDirectoryStructure();
+
+  // most mods are usually shared between profiles, so try to only apply the
+  // differences to the existing structure instead of rebuilding it
+  if (oldProfile == nullptr || !switchDirectoryStructure(*oldProfile)) {
+    refreshDirectoryStructure();
+  }
 
   m_CurrentProfile->debugDump();
 
@@ -1537,6 +1554,93 @@ void OrganizerCore::refreshDirectoryStructure()
   QTimer::singleShot(0, m_DirectoryRefresher.get(), &DirectoryRefresher::refresh);
 }
 
+bool OrganizerCore::switchDirectoryStructure(const Profile& oldProfile)
+{
+  // the structure can only be reused if it is complete and was built from the
+  // same list of mods
+  if (m_DirectoryUpdate || !m_DirectoryStructure->isPopulated() ||
+      oldProfile.numMods() != m_CurrentProfile->numMods()) {
+    return false;
+  }
+
+  // archives in the structure depend on the archive list and the load order of
+  // the profile, those still need a full refresh
+  if (m_Settings.archiveParsing()) {
+    return false;
+  }
+
+  log::debug("switching structure from profile '{}'", oldProfile.name());
+  TimeThis tt("OrganizerCore::switchDirectoryStructure()");
+
+  std::vector<DirectoryRefresher::EntryInfo> toEnable;
+  std::size_t disabled = 0;
+
+  for (unsigned int i = 0; i < m_CurrentProfile->numMods(); ++i) {
+    const bool wasEnabled = oldProfile.modEnabled(i);
+    const bool isEnabled  = m_CurrentProfile->modEnabled(i);
+
+    if (wasEnabled == isEnabled) {
+      continue;
+    }
+
+    ModInfo::Ptr modInfo = ModInfo::getByIndex(i);
+
+    if (isEnabled) {
+      toEnable.push_back({modInfo->internalName(), modInfo->absolutePath(),
+                          modInfo->stealFiles(), modInfo->archives(),
+                          m_CurrentProfile->getModPriority(i)});
+    } else {
+      const auto originName = ToWString(modInfo->internalName());
+      if (m_DirectoryStructure->originExists(originName)) {
+        m_DirectoryStructure->getOriginByName(originName).enable(false);
+      }
+      ++disabled;
+    }
+  }
+
+  log::debug("{} mods to enable, {} mods to disable", toEnable.size(), disabled);
+
+  if (!toEnable.empty()) {
+    m_DirectoryRefresher->addMultipleModsFilesToStructure(m_DirectoryStructure,
+                                                          toEnable);
+    DirectoryRefresher::cleanStructure(m_DirectoryStructure);
+  }
+
+  // re-rank all the origins, priorities in the directory structure are one
+  // higher because data is 0
+  for (unsigned int i = 0; i < m_CurrentProfile->numMods(); ++i) {
+    ModInfo::Ptr modInfo  = ModInfo::getByIndex(i);
+    const auto originName = ToWString(modInfo->internalName());
+    if (m_DirectoryStructure->originExists(originName)) {
+      m_DirectoryStructure->getOriginByName(originName).setPriority(
+          m_CurrentProfile->getModPriority(i) + 1);
+    }
+  }
+  m_DirectoryStructure->getFileRegister()->sortOrigins();
+
+  m_VirtualFileTree.invalidate();
+
+  for (unsigned int i = 0; i < m_CurrentProfile->numMods(); ++i) {
+    ModInfo::getByIndex(i)->clearCaches();
+  }
+
+  // plugins that are still provided by the same file keep their parsed
+  // information, only the state of the new profile is read
+  refreshESPList(false);
+  refreshBSAList();
+
+  // this is called from setCurrentProfile(), listeners must be told that the
+  // profile changed before they see the new structure, like for a refresh
+  QMetaObject::invokeMethod(
+      this,
+      [this] {
+        emit directoryStructureReady();
+      },
+      Qt::QueuedConnection);
+
+  return true;
+}
+
 void OrganizerCore::onDirectoryRefreshed()
 {
   log::debug("directory refreshed, finishing up");
@@ -8,7 +8,9 @@
 #include "guessedvalue.h"
 #include "installationmanager.h"
 #include "memoizedlock.h"
+#include "modcontentscache.h"
 #include "moddatacontent.h"
+#include "pluginheadercache.h"
 #include "modinfo.h"
 #include "modlist.h"
 #include "moshortcut.h"
@@ -293,6 +295,16 @@ public:
    */
   const ModDataContentHolder& modDataContents() const { return m_Contents; }
 
+  /**
+   * @return the persistent cache of the contents of regular mods.
+   */
+  ModContentsCache& modContentsCache() { return m_ContentsCache; }
+
+  /**
+   * @return the persistent cache of plugin headers.
+   */
+  PluginHeaderCache& pluginHeaderCache() { return m_PluginHeaderCache; }
+
   bool isArchivesInit() const { return m_ArchivesInit; }
 
   bool saveCurrentLists();
@@ -496,6 +508,12 @@ private:
   //
   void clearCaches(std::vector<unsigned int> const& indices) const;
 
+  // applies the differences in enabled mods and priorities between the given
+  // profile and the current one to the existing directory structure, returns
+  // false if the structure cannot be reused and must be fully refreshed
+  //
+  bool switchDirectoryStructure(const Profile& oldProfile);
+
   bool createDirectory(const QString& path);
 
   QString oldMO1HookDll() const;
@@ -530,6 +548,8 @@ private:
   QString m_GameName;
   MOBase::IPluginGame* m_GamePlugin;
   ModDataContentHolder m_Contents;
+  ModContentsCache m_ContentsCache;
+  PluginHeaderCache m_PluginHeaderCache;
 
   std::unique_ptr<Profile> m_CurrentProfile;
 
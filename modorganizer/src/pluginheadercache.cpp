@@ -0,0 +1,157 @@
+#include "pluginheadercache.h"
+
+#include <espfile.h>
+#include <log.h>
+#include <utility.h>
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QJsonArray>
+
+using namespace MOBase;
+
+// bumped when the layout of the cache or the way headers are parsed changes
+static constexpr int CacheVersion = 3;
+
+PluginHeaderCache::PluginHeaderCache()
+    : m_Dirty(false),
+      m_File("plugin header", std::bind(&PluginHeaderCache::entries, this))
+{}
+
+void PluginHeaderCache::load(const QString& path)
+{
+  const auto plugins = m_File.load(path, QString::number(CacheVersion));
+
+  std::scoped_lock lock(m_Mutex);
+  m_Entries.clear();
+  m_Dirty = false;
+
+  for (auto itor = plugins.begin(); itor != plugins.end(); ++itor) {
+    const auto plugin = itor.value().toObject();
+
+    Entry entry;
+    entry.size     = plugin["size"].toInteger();
+    entry.modified = plugin["modified"].toInteger();
+
+    auto& header            = entry.header;
+    header.isMaster         = plugin["master"].toBool();
+    header.isLight          = plugin["light"].toBool();
+    header.isLightAlternate = plugin["lightAlternate"].toBool();
+    header.isMedium         = plugin["medium"].toBool();
+    header.isDummy          = plugin["dummy"].toBool();
+    header.formVersion      = plugin["formVersion"].toInt();
+    header.author           = plugin["author"].toString();
+    header.description      = plugin["description"].toString();
+
+    for (const auto& master : plugin["masters"].toArray()) {
+      header.masters.append(master.toString());
+    }
+
+    m_Entries.emplace(itor.key(), std::move(entry));
+  }
+
+  log::debug("loaded cached headers for {} plugins", m_Entries.size());
+}
+
+PluginHeaderCache::Header PluginHeaderCache::get(const QString& path)
+{
+  const QFileInfo fi(path);
+  const qint64 size     = fi.size();
+  const qint64 modified = fi.lastModified().toMSecsSinceEpoch();
+
+  {
+    std::scoped_lock lock(m_Mutex);
+
+    auto itor = m_Entries.find(path);
+    if (itor != m_Entries.end() && itor->second.size == size &&
+        itor->second.modified == modified) {
+      return itor->second.header;
+    }
+  }
+
+  // parsing is done outside the lock so headers can be read in parallel
+  Header header = parse(path);
+
+  {
+    std::scoped_lock lock(m_Mutex);
+    m_Entries[path] = {size, modified, header};
+    m_Dirty         = true;
+  }
+
+  return header;
+}
+
+PluginHeaderCache::Header PluginHeaderCache::parse(const QString& path)
+{
+  ESP::File file(ToWString(path));
+
+  Header header;
+  header.isMaster         = file.isMaster();
+  header.isLight          = file.isLight(false);
+  header.isLightAlternate = file.isLight(true);
+  header.isMedium         = file.isMedium();
+  header.isDummy          = file.isDummy();
+  header.formVersion      = file.formVersion();
+  header.author           = QString::fromLatin1(file.author().c_str());
+  header.description      = QString::fromLatin1(file.description().c_str());
+
+  for (auto&& m : file.masters()) {
+    header.masters.append(QString::fromStdString(m));
+  }
+
+  return header;
+}
+
+void PluginHeaderCache::save(const std::set<QString>& paths)
+{
+  {
+    std::scoped_lock lock(m_Mutex);
+
+    // plugins that were removed, moved to another mod or belong to mods that are
+    // not active in this profile
+    if (std::erase_if(m_Entries, [&](auto&& entry) {
+          return !paths.contains(entry.first);
+        }) > 0) {
+      m_Dirty = true;
+    }
+
+    if (!m_Dirty) {
+      return;
+    }
+
+    m_Dirty = false;
+  }
+
+  m_File.save();
+}
+
+void PluginHeaderCache::flush()
+{
+  m_File.flush();
+}
+
+QJsonObject PluginHeaderCache::entries() const
+{
+  std::scoped_lock lock(m_Mutex);
+
+  QJsonObject plugins;
+
+  for (const auto& [name, entry] : m_Entries) {
+    const auto& header = entry.header;
+
+    plugins.insert(name, QJsonObject{{"size", entry.size},
+                                     {"modified", entry.modified},
+                                     {"master", header.isMaster},
+                                     {"light", header.isLight},
+                                     {"lightAlternate", header.isLightAlternate},
+                                     {"medium", header.isMedium},
+                                     {"dummy", header.isDummy},
+                                     {"formVersion", header.formVersion},
+                                     {"author", header.author},
+                                     {"description", header.description},
+                                     {"masters",
+                                      QJsonArray::fromStringList(header.masters)}});
+  }
+
+  return plugins;
+}
@@ -0,0 +1,81 @@
+#ifndef PLUGINHEADERCACHE_H
+#define PLUGINHEADERCACHE_H
+
+#include "jsoncachefile.h"
+
+#include <QString>
+#include <QStringList>
+
+#include <map>
+#include <mutex>
+#include <set>
+
+// persistent cache of the headers of plugin files (see PluginList::refresh())
+//
+// reading the header requires opening every plugin, which adds up quickly with
+// thousands of plugins on a cold disk cache; the parsed headers are stored in a
+// single file for the instance and are reused as long as the size and the
+// modification time of the plugin did not change
+//
+class PluginHeaderCache
+{
+public:
+  // information read from the header record of a plugin
+  //
+  struct Header
+  {
+    bool isMaster         = false;
+    bool isLight          = false;
+    bool isLightAlternate = false;
+    bool isMedium         = false;
+    bool isDummy          = false;
+    int formVersion       = 0;
+    QString author;
+    QString description;
+
+    // in the order they appear in the plugin
+    QStringList masters;
+  };
+
+  PluginHeaderCache();
+
+  // loads the cache from the given file
+  //
+  void load(const QString& path);
+
+  // returns the header of the plugin at the given path, from the cache if the
+  // file did not change, or by parsing the file otherwise; throws if the
+  // plugin cannot be parsed
+  //
+  // this is thread-safe
+  //
+  Header get(const QString& path);
+
+  // drops the headers of the plugins that are not in the given set, which are
+  // the full paths of the plugins seen by the last refresh, and schedules a
+  // write of the cache if it changed since the last call
+  //
+  void save(const std::set<QString>& paths);
+
+  // writes pending changes immediately
+  //
+  void flush();
+
+private:
+  struct Entry
+  {
+    qint64 size     = 0;
+    qint64 modified = 0;
+    Header header;
+  };
+
+  std::map<QString, Entry> m_Entries;
+  bool m_Dirty;
+  mutable std::mutex m_Mutex;
+  JsonCacheFile m_File;
+
+  static Header parse(const QString& path);
+  QJsonObject entries() const;
+};
+
+#endif  // PLUGINHEADERCACHE_H
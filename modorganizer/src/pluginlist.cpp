@@ -20,15 +20,16 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "pluginlist.h"
 #include "modinfo.h"
 #include "modlist.h"
+#include "pluginheadercache.h"
 #include "scopeguard.h"
 #include "settings.h"
 #include "shared/directoryentry.h"
 #include "shared/fileentry.h"
 #include "shared/filesorigin.h"
+#include "thread_utils.h"
 #include "viewmarkingscrollbar.h"
 
 #include "shared/windows_error.h"
-#include <espfile.h>
 #include <gameplugins.h>
 #include <iplugingame.h>
 #include <report.h>
@@ -52,6 +53,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <algorithm>
 #include <ctime>
+#include <optional>
 #include <stdexcept>
 
 #include "organizercore.h"
@@ -72,10 +74,24 @@ static QString TruncateString(const QString& text)
 }
 
 PluginList::PluginList(OrganizerCore& organizer)
-    : QAbstractItemModel(&organizer), m_Organizer(organizer), m_FontMetrics(QFont())
+    : QAbstractItemModel(&organizer), m_Organizer(organizer), m_FontMetrics(QFont()),
+      m_OverrideIndex(Settings::instance().refreshThreadCount())
 {
   connect(this, SIGNAL(writePluginsList()), this, SLOT(generatePluginIndexes()));
   m_LastCheck.start();
+
+  m_OverrideIndexTimer.setSingleShot(true);
+  m_OverrideIndexTimer.setInterval(500);
+  connect(&m_OverrideIndexTimer, &QTimer::timeout, this,
+          &PluginList::updateOverrideIndex);
+
+  // emitted from the indexing thread
+  connect(&m_OverrideIndex, &PluginOverrideIndex::updated, this, [this] {
+    if (!m_ESPs.empty()) {
+      emit dataChanged(index(0, 0), index(static_cast<int>(m_ESPs.size()) - 1,
+                                          columnCount() - 1));
+    }
+  });
 }
 
 PluginList::~PluginList()
@@ -188,7 +204,10 @@ void PluginList::refresh(const QString& profileName,
   m_CurrentProfile = profileName;
 
   std::unordered_map<QString, FileEntryPtr> availablePlugins;
-  QStringList archiveCandidates;
+
+  // archives are matched with plugins by prefix, keeping them sorted by their
+  // case-folded name turns the lookup for a plugin into a binary search
+  std::vector<std::pair<QString, QString>> archiveCandidates;
 
   for (FileEntryPtr current : baseDirectory.getFiles()) {
     if (current.get() == nullptr) {
@@ -202,13 +221,40 @@ void PluginList::refresh(const QString& profileName,
       availablePlugins.insert(std::make_pair(filename, current));
     } else if (filename.endsWith(".bsa", Qt::CaseInsensitive) ||
                filename.endsWith("ba2", Qt::CaseInsensitive)) {
-      archiveCandidates.append(filename);
+      archiveCandidates.emplace_back(filename.toCaseFolded(), filename);
     }
   }
 
+  std::sort(archiveCandidates.begin(), archiveCandidates.end());
+
+  // everything that needs the directory structure or the mod list is gathered
+  // here, the plugin headers are then read in parallel below
+  struct PendingPlugin
+  {
+    QString name;
+    QString fullPath;
+    QString originName;
+    bool forceLoaded;
+    bool forceEnabled;
+    bool forceDisabled;
+    bool hasIni;
+    std::set<QString> archives;
+    std::optional<ESPInfo> info;
+  };
+
+  std::vector<PendingPlugin> pending;
+
   for (const auto& [filename, current] : availablePlugins) {
-    if (m_ESPsByName.contains(filename)) {
-      continue;
+    auto existing = m_ESPsByName.find(filename);
+    if (existing != m_ESPsByName.end()) {
+      ESPInfo& info = m_ESPs[existing->second];
+      if (info.fullPath == ToQString(current->getFullPath())) {
+        continue;
+      }
+
+      // the plugin is now provided by another origin, drop the old entry so
+      // the new file is parsed
+      info.name = "";
     }
 
     bool forceLoaded = Settings::instance().game().forceEnableCoreFiles() &&
@@ -229,10 +275,13 @@ void PluginList::refresh(const QString& profileName,
       QString iniPath = baseName + ".ini";
       bool hasIni     = baseDirectory.findFile(ToWString(iniPath)).get() != nullptr;
       std::set<QString> loadedArchives;
-      for (const auto& archiveName : archiveCandidates) {
-        if (archiveName.startsWith(baseName, Qt::CaseInsensitive)) {
-          loadedArchives.insert(archiveName);
-        }
+      const QString archivePrefix = baseName.toCaseFolded();
+      for (auto itor = std::lower_bound(archiveCandidates.begin(),
+                                        archiveCandidates.end(),
+                                        std::make_pair(archivePrefix, QString()));
+           itor != archiveCandidates.end() && itor->first.startsWith(archivePrefix);
+           ++itor) {
+        loadedArchives.insert(itor->second);
       }
 
       QString originName    = ToQString(origin.getName());
@@ -242,11 +291,9 @@ void PluginList::refresh(const QString& profileName,
         originName           = modInfo->name();
       }
 
-      m_ESPs.emplace_back(filename, forceLoaded, forceEnabled, forceDisabled,
-                          originName, ToQString(current->getFullPath()), hasIni,
-                          loadedArchives, lightPluginsAreSupported,
-                          mediumPluginsAreSupported);
-      m_ESPs.rbegin()->priority = -1;
+      pending.push_back({filename, ToQString(current->getFullPath()), originName,
+                         forceLoaded, forceEnabled, forceDisabled, hasIni,
+                         std::move(loadedArchives), std::nullopt});
     } catch (const std::exception& e) {
       reportError(tr("failed to update esp info for file %1 (source id: %2), error: %3")
                       .arg(filename)
@@ -255,6 +302,52 @@ void PluginList::refresh(const QString& profileName,
     }
   }
 
+  // availablePlugins is unordered, sort so the new entries are always appended
+  // in the same order regardless of which thread parsed them
+  std::sort(pending.begin(), pending.end(),
+            [](const PendingPlugin& lhs, const PendingPlugin& rhs) {
+              return QString::compare(lhs.name, rhs.name, Qt::CaseInsensitive) < 0;
+            });
+
+  // ESPInfo reads the plugin header from disk, which is the slow part of a
+  // refresh with a large number of plugins
+  const std::size_t threadCount =
+      std::min(Settings::instance().refreshThreadCount(), pending.size());
+
+  auto& headerCache = m_Organizer.pluginHeaderCache();
+
+  const auto parse = [lightPluginsAreSupported, mediumPluginsAreSupported,
+                      &headerCache](PendingPlugin& plugin) {
+    plugin.info.emplace(plugin.name, plugin.forceLoaded, plugin.forceEnabled,
+                        plugin.forceDisabled, plugin.originName, plugin.fullPath,
+                        plugin.hasIni, plugin.archives, lightPluginsAreSupported,
+                        mediumPluginsAreSupported, headerCache);
+  };
+
+  if (threadCount > 1) {
+    parallelMap(pending.begin(), pending.end(), parse, threadCount);
+  } else {
+    std::for_each(pending.begin(), pending.end(), parse);
+  }
+
+  m_ESPs.reserve(m_ESPs.size() + pending.size());
+  for (auto& plugin : pending) {
+    auto& info    = m_ESPs.emplace_back(std::move(*plugin.info));
+    info.priority = -1;
+    info.nameId   = nameId(info.name);
+
+    for (const auto& master : info.masters) {
+      info.masterIds.push_back(nameId(master));
+    }
+  }
+
+  std::set<QString> pluginPaths;
+  for (const auto& [filename, current] : availablePlugins) {
+    pluginPaths.insert(ToQString(current->getFullPath()));
+  }
+
+  headerCache.save(pluginPaths);
+
   for (const auto& espName : m_ESPsByName) {
     if (!availablePlugins.contains(espName.first)) {
       m_ESPs[espName.second].name = "";
@@ -267,6 +360,8 @@ void PluginList::refresh(const QString& profileName,
                               }),
                m_ESPs.end());
 
+  updateMasterGraph();
+
   fixPriorities();
 
   // functions in GamePlugins will use the IPluginList interface of this, so
@@ -292,6 +387,8 @@ void PluginList::refresh(const QString& profileName,
   emit dataChanged(this->index(0, 0),
                    this->index(static_cast<int>(m_ESPs.size()), columnCount()));
 
+  m_OverrideIndexTimer.start();
+
   m_Refreshed();
 }
 
@@ -358,10 +455,10 @@ void PluginList::fixPluginRelationships()
   for (int i = 0; i < m_ESPs.size(); i++) {
     ESPInfo& plugin = m_ESPs[i];
     int newPriority = plugin.priority;
-    for (auto master : plugin.masters) {
-      auto iter = m_ESPsByName.find(master);
-      if (iter != m_ESPsByName.end()) {
-        newPriority = std::max(newPriority, m_ESPs[iter->second].priority);
+    for (int masterId : plugin.masterIds) {
+      const int masterRow = m_RowsByNameId[masterId];
+      if (masterRow != -1) {
+        newPriority = std::max(newPriority, m_ESPs[masterRow].priority);
       }
     }
     if (newPriority != plugin.priority) {
@@ -404,6 +501,7 @@ void PluginList::enableESP(const QString& name, bool enable)
 
     emit writePluginsList();
     if (enabled != m_ESPs[iter->second].enabled) {
+      testMasters({iter->second});
       pluginStatesChanged({name}, state(name));
     }
   } else {
@@ -425,6 +523,7 @@ int PluginList::findPluginByPriority(int priority)
 void PluginList::setEnabled(const QModelIndexList& indices, bool enabled)
 {
   QStringList dirty;
+  std::vector<int> dirtyRows;
   for (auto& idx : indices) {
     if (m_ESPs[idx.row()].forceLoaded || m_ESPs[idx.row()].forceEnabled ||
         m_ESPs[idx.row()].forceDisabled)
@@ -432,9 +531,11 @@ void PluginList::setEnabled(const QModelIndexList& indices, bool enabled)
     if (m_ESPs[idx.row()].enabled != enabled) {
       m_ESPs[idx.row()].enabled = enabled;
       dirty.append(m_ESPs[idx.row()].name);
+      dirtyRows.push_back(idx.row());
     }
   }
   if (!dirty.isEmpty()) {
+    testMasters(dirtyRows);
     emit writePluginsList();
     pluginStatesChanged(dirty, enabled ? IPluginList::PluginState::STATE_ACTIVE
                                        : IPluginList::PluginState::STATE_INACTIVE);
@@ -453,6 +554,7 @@ void PluginList::setEnabledAll(bool enabled)
     }
   }
   if (!dirty.isEmpty()) {
+    testMasters();
     emit writePluginsList();
     pluginStatesChanged(dirty, enabled ? IPluginList::PluginState::STATE_ACTIVE
                                        : IPluginList::PluginState::STATE_INACTIVE);
@@ -873,6 +975,7 @@ void PluginList::setState(const QString& name, PluginStates state)
     m_ESPs[iter->second].enabled =
         (state == IPluginList::STATE_ACTIVE && !m_ESPs[iter->second].forceDisabled) ||
         m_ESPs[iter->second].forceLoaded || m_ESPs[iter->second].forceEnabled;
+    testMasters({iter->second});
   } else {
     log::warn("Plugin not found: {}", name);
   }
@@ -1018,6 +1121,18 @@ bool PluginList::isLightFlagged(const QString& name) const
   }
 }
 
+int PluginList::overrideCount(const QString& name) const
+{
+  const auto counts = m_OverrideIndex.counts(name);
+  return counts ? counts->overrides : -1;
+}
+
+int PluginList::overriddenCount(const QString& name) const
+{
+  const auto counts = m_OverrideIndex.counts(name);
+  return counts ? counts->overridden : -1;
+}
+
 bool PluginList::hasNoRecords(const QString& name) const
 {
   auto iter = m_ESPsByName.find(name);
@@ -1124,6 +1239,26 @@ void PluginList::generatePluginIndexes()
     }
   }
   emit esplist_changed();
+
+  m_OverrideIndexTimer.start();
+}
+
+void PluginList::updateOverrideIndex()
+{
+  if (!Settings::instance().pluginRecordIndexing()) {
+    m_OverrideIndex.clear();
+    return;
+  }
+
+  std::vector<PluginOverrideIndex::Plugin> plugins;
+
+  for (int i : m_ESPsByPriority) {
+    if (m_ESPs[i].enabled) {
+      plugins.push_back({m_ESPs[i].name, m_ESPs[i].fullPath});
+    }
+  }
+
+  m_OverrideIndex.update(std::move(plugins));
 }
 
 int PluginList::rowCount(const QModelIndex& parent) const
@@ -1142,21 +1277,65 @@ int PluginList::columnCount(const QModelIndex&) const
 
 void PluginList::testMasters()
 {
-  std::set<QString, FileNameComparator> enabledMasters;
-  for (const auto& iter : m_ESPs) {
-    if (iter.enabled) {
-      enabledMasters.insert(iter.name);
+  for (auto& esp : m_ESPs) {
+    testMasters(esp);
+  }
+}
+
+void PluginList::testMasters(const std::vector<int>& rows)
+{
+  for (int row : rows) {
+    auto& esp = m_ESPs[row];
+    testMasters(esp);
+
+    for (int dependent : m_DependentsByNameId[esp.nameId]) {
+      testMasters(m_ESPs[dependent]);
     }
   }
+}
 
-  for (auto& iter : m_ESPs) {
-    iter.masterUnset.clear();
-    if (iter.enabled) {
-      for (const auto& master : iter.masters) {
-        if (enabledMasters.find(master) == enabledMasters.end()) {
-          iter.masterUnset.insert(master);
-        }
-      }
+void PluginList::testMasters(ESPInfo& esp) const
+{
+  esp.masterUnset.clear();
+
+  if (!esp.enabled) {
+    return;
+  }
+
+  for (std::size_t i = 0; i < esp.masterIds.size(); ++i) {
+    const int masterRow = m_RowsByNameId[esp.masterIds[i]];
+    if (masterRow == -1 || !m_ESPs[masterRow].enabled) {
+      esp.masterUnset.insert(esp.masters[static_cast<int>(i)]);
+    }
+  }
+}
+
+int PluginList::nameId(const QString& name)
+{
+  const auto [itor, inserted] =
+      m_NameIds.emplace(name.toLower(), static_cast<int>(m_NameIds.size()));
+
+  if (inserted) {
+    m_RowsByNameId.push_back(-1);
+    m_DependentsByNameId.emplace_back();
+  }
+
+  return itor->second;
+}
+
+void PluginList::updateMasterGraph()
+{
+  std::fill(m_RowsByNameId.begin(), m_RowsByNameId.end(), -1);
+  for (auto& dependents : m_DependentsByNameId) {
+    dependents.clear();
+  }
+
+  for (int row = 0; row < static_cast<int>(m_ESPs.size()); ++row) {
+    const auto& esp = m_ESPs[row];
+    m_RowsByNameId[esp.nameId] = row;
+
+    for (int masterId : esp.masterIds) {
+      m_DependentsByNameId[masterId].push_back(row);
     }
   }
 }
@@ -1308,14 +1487,16 @@ QVariant PluginList::tooltipData(const QModelIndex& modelIndex) const
         "</b>";
   }
 
-  std::set<QString> enabledMasters;
-  std::set_difference(esp.masters.begin(), esp.masters.end(), esp.masterUnset.begin(),
-                      esp.masterUnset.end(),
-                      std::inserter(enabledMasters, enabledMasters.end()));
+  QStringList enabledMasters;
+  for (const auto& master : esp.masters) {
+    if (!esp.masterUnset.contains(master)) {
+      enabledMasters.append(master);
+    }
+  }
 
   if (!enabledMasters.empty()) {
     toolTip += "<br><b>" + tr("Enabled Masters") +
-               "</b>: " + TruncateString(SetJoin(enabledMasters, ", "));
+               "</b>: " + TruncateString(enabledMasters.join(", "));
   }
 
   if (!esp.archives.empty()) {
@@ -1369,6 +1550,18 @@ QVariant PluginList::tooltipData(const QModelIndex& modelIndex) const
                                "typically used to load a paired archive file.");
   }
 
+  if (const auto counts = m_OverrideIndex.counts(esp.name)) {
+    if (counts->overrides > 0) {
+      toolTip += "<br><b>" + tr("Overrides") + "</b>: " +
+                 tr("%n record(s) from masters", "", counts->overrides);
+    }
+
+    if (counts->overridden > 0) {
+      toolTip += "<br><b>" + tr("Overridden") + "</b>: " +
+                 tr("%n record(s) by plugins loaded later", "", counts->overridden);
+    }
+  }
+
   if (esp.forceDisabled) {
     auto feature = m_Organizer.gameFeatures().gameFeature<GamePlugins>();
     if (feature && esp.hasLightExtension && feature->lightPluginsAreSupported()) {
@@ -1505,6 +1698,16 @@ QVariant PluginList::iconData(const QModelIndex& modelIndex) const
     result.append(":/MO/gui/unchecked-checkbox");
   }
 
+  if (const auto counts = m_OverrideIndex.counts(esp.name)) {
+    if (counts->overrides > 0 && counts->overridden > 0) {
+      result.append(":/MO/gui/emblem_conflict_mixed");
+    } else if (counts->overrides > 0) {
+      result.append(":/MO/gui/emblem_conflict_overwrite");
+    } else if (counts->overridden > 0) {
+      result.append(":/MO/gui/emblem_conflict_overwritten");
+    }
+  }
+
   if (info && !info->loot.dirty.empty()) {
     result.append(":/MO/gui/edit_clear");
   }
@@ -1581,7 +1784,7 @@ bool PluginList::setData(const QModelIndex& modIndex, const QVariant& value, int
   if (oldState != newState) {
     try {
       pluginStatesChanged({modName}, newState);
-      testMasters();
+      testMasters({modIndex.row()});
       emit dataChanged(this->index(0, 0),
                        this->index(static_cast<int>(m_ESPs.size()), columnCount()));
     } catch (const std::exception& e) {
@@ -1665,10 +1868,10 @@ void PluginList::setPluginPriority(int row, int& newPriority, bool isForced)
   int oldPriority = m_ESPs.at(row).priority;
   if (newPriorityTemp < oldPriority) {  // moving up
     // don't allow plugins to be moved above their masters
-    for (auto master : m_ESPs[row].masters) {
-      auto iter = m_ESPsByName.find(master);
-      if (iter != m_ESPsByName.end()) {
-        int masterPriority = m_ESPs[iter->second].priority;
+    for (int masterId : m_ESPs[row].masterIds) {
+      const int masterRow = m_RowsByNameId[masterId];
+      if (masterRow != -1) {
+        int masterPriority = m_ESPs[masterRow].priority;
         if (masterPriority >= newPriorityTemp) {
           newPriorityTemp = masterPriority + 1;
         }
@@ -1676,13 +1879,10 @@ void PluginList::setPluginPriority(int row, int& newPriority, bool isForced)
     }
   } else if (newPriorityTemp > oldPriority) {  // moving down
     // don't allow masters to be moved below their children
-    for (int i = oldPriority + 1; i <= newPriorityTemp; i++) {
-      PluginList::ESPInfo* otherInfo = &m_ESPs.at(m_ESPsByPriority[i]);
-      for (auto master : otherInfo->masters) {
-        if (master.compare(m_ESPs[row].name, Qt::CaseInsensitive) == 0) {
-          newPriorityTemp = otherInfo->priority - 1;
-          break;
-        }
+    for (int dependent : m_DependentsByNameId[m_ESPs[row].nameId]) {
+      const int priority = m_ESPs[dependent].priority;
+      if (priority > oldPriority && priority <= newPriorityTemp) {
+        newPriorityTemp = priority - 1;
       }
     }
   }
@@ -1817,28 +2017,27 @@ PluginList::ESPInfo::ESPInfo(const QString& name, bool forceLoaded, bool forceEn
                              bool forceDisabled, const QString& originName,
                              const QString& fullPath, bool hasIni,
                              std::set<QString> archives, bool lightSupported,
-                             bool mediumSupported)
+                             bool mediumSupported, PluginHeaderCache& headerCache)
     : name(name), fullPath(fullPath), enabled(forceLoaded), forceLoaded(forceLoaded),
       forceEnabled(forceEnabled), forceDisabled(forceDisabled), priority(0),
       loadOrder(-1), originName(originName), hasIni(hasIni),
-      archives(archives.begin(), archives.end()), modSelected(false)
+      archives(archives.begin(), archives.end()), modSelected(false), nameId(-1)
 {
   try {
-    ESP::File file(ToWString(fullPath));
+    const auto header  = headerCache.get(fullPath);
     auto extension     = name.right(3).toLower();
     hasMasterExtension = (extension == "esm");
     hasLightExtension  = (extension == "esl");
-    isMasterFlagged    = file.isMaster();
-    isLightFlagged     = lightSupported && file.isLight(mediumSupported);
-    isMediumFlagged    = mediumSupported && file.isMedium();
-    hasNoRecords       = file.isDummy();
-
-    author      = QString::fromLatin1(file.author().c_str());
-    description = QString::fromLatin1(file.description().c_str());
-
-    for (auto&& m : file.masters()) {
-      masters.insert(QString::fromStdString(m));
-    }
+    isMasterFlagged    = header.isMaster;
+    isLightFlagged =
+        lightSupported && (mediumSupported ? header.isLightAlternate : header.isLight);
+    isMediumFlagged = mediumSupported && header.isMedium;
+    hasNoRecords    = header.isDummy;
+    formVersion     = header.formVersion;
+
+    author      = header.author;
+    description = header.description;
+    masters     = header.masters;
   } catch (const std::exception& e) {
     log::error("failed to parse plugin file {}: {}", fullPath, e.what());
     hasMasterExtension = false;
@@ -1847,6 +2046,7 @@ PluginList::ESPInfo::ESPInfo(const QString& name, bool forceLoaded, bool forceEn
     isMediumFlagged    = false;
     isLightFlagged     = false;
     hasNoRecords       = false;
+    formVersion        = 0;
   }
 }
 
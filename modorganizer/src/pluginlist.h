@@ -21,6 +21,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #define PLUGINLIST_H
 
 #include "loot.h"
+#include "pluginoverrideindex.h"
 #include "profile.h"
 #include <ifiletree.h>
 #include <ipluginlist.h>
@@ -45,9 +46,11 @@ class IPluginGame;
 #endif
 
 #include <map>
+#include <unordered_map>
 #include <vector>
 
 class OrganizerCore;
+class PluginHeaderCache;
 
 template <class C>
 class ChangeBracket
@@ -243,6 +246,8 @@ public:
   bool isMediumFlagged(const QString& name) const;
   bool isLightFlagged(const QString& name) const;
   bool hasNoRecords(const QString& name) const;
+  int overrideCount(const QString& name) const;
+  int overriddenCount(const QString& name) const;
 
   boost::signals2::connection onRefreshed(const std::function<void()>& callback);
   boost::signals2::connection
@@ -299,6 +304,12 @@ public slots:
    **/
   void generatePluginIndexes();
 
+  /**
+   * @brief Starts indexing the records of the active plugins, or drops the index if
+   * record indexing is disabled
+   **/
+  void updateOverrideIndex();
+
 signals:
 
   /**
@@ -317,7 +328,7 @@ private:
     ESPInfo(const QString& name, bool forceLoaded, bool forceEnabled,
             bool forceDisabled, const QString& originName, const QString& fullPath,
             bool hasIni, std::set<QString> archives, bool lightSupported,
-            bool mediumSupported);
+            bool mediumSupported, PluginHeaderCache& headerCache);
 
     QString name;
     QString fullPath;
@@ -336,14 +347,19 @@ private:
     bool isMediumFlagged;
     bool isLightFlagged;
     bool hasNoRecords;
+    int formVersion;
     bool modSelected;
     QString author;
     QString description;
     bool hasIni;
     std::set<QString, MOBase::FileNameComparator> archives;
-    std::set<QString, MOBase::FileNameComparator> masters;
+    QStringList masters;
     mutable std::set<QString, MOBase::FileNameComparator> masterUnset;
 
+    // ids of the plugin and its masters in the master graph, see nameId()
+    int nameId;
+    std::vector<int> masterIds;
+
     bool operator<(const ESPInfo& str) const { return (loadOrder < str.loadOrder); }
   };
 
@@ -365,6 +381,22 @@ private:
 
   void testMasters();
 
+  // updates the missing masters of the plugins at the given rows and of the
+  // plugins that depend on them, used when only a few plugins changed state
+  //
+  void testMasters(const std::vector<int>& rows);
+  void testMasters(ESPInfo& esp) const;
+
+  // returns the id of the given plugin name, ids are case-insensitive and stay
+  // valid for the lifetime of the list
+  //
+  int nameId(const QString& name);
+
+  // rebuilds the rows of the master graph, must be called when rows are added
+  // or removed
+  //
+  void updateMasterGraph();
+
   void fixPrimaryPlugins();
   void fixPriorities();
   void fixPluginRelationships();
@@ -392,6 +424,13 @@ private:
 
   std::map<QString, int, MOBase::FileNameComparator> m_LockedOrder;
 
+  // master graph: plugin names are given an id on first use, the row of the
+  // plugin with a given id, if any, and the rows of the plugins that have it
+  // as a master
+  std::unordered_map<QString, int> m_NameIds;
+  std::vector<int> m_RowsByNameId;
+  std::vector<std::vector<int>> m_DependentsByNameId;
+
   std::map<QString, AdditionalInfo, MOBase::FileNameComparator>
       m_AdditionalInfo;  // maps esp names to boss information
 
@@ -408,6 +447,11 @@ private:
 
   const MOBase::IPluginGame* m_GamePlugin;
 
+  PluginOverrideIndex m_OverrideIndex;
+
+  // delays indexing while the load order is being changed
+  QTimer m_OverrideIndexTimer;
+
   QVariant displayData(const QModelIndex& modelIndex) const;
   QVariant checkstateData(const QModelIndex& modelIndex) const;
   QVariant foregroundData(const QModelIndex& modelIndex) const;
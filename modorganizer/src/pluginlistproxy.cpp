@@ -128,3 +128,13 @@ bool PluginListProxy::hasNoRecords(const QString& name) const
 {
   return m_Proxied->hasNoRecords(name);
 }
+
+int PluginListProxy::overrideCount(const QString& name) const
+{
+  return m_Proxied->overrideCount(name);
+}
+
+int PluginListProxy::overriddenCount(const QString& name) const
+{
+  return m_Proxied->overriddenCount(name);
+}
@@ -35,6 +35,8 @@ public:
   bool isMediumFlagged(const QString& name) const override;
   bool isLightFlagged(const QString& name) const override;
   bool hasNoRecords(const QString& name) const override;
+  int overrideCount(const QString& name) const override;
+  int overriddenCount(const QString& name) const override;
 
 private:
   friend class OrganizerProxy;
@@ -0,0 +1,237 @@
+#include "pluginoverrideindex.h"
+#include "thread_utils.h"
+
+#include <espexceptions.h>
+#include <espreader.h>
+#include <log.h>
+#include <utility.h>
+
+#include <QDateTime>
+#include <QFileInfo>
+
+#include <algorithm>
+#include <set>
+#include <unordered_map>
+
+using namespace MOBase;
+
+PluginOverrideIndex::PluginOverrideIndex(std::size_t threadCount)
+    : m_ThreadCount(std::max<std::size_t>(threadCount, 1)), m_Generation(0),
+      m_Stop(false)
+{
+  m_Thread = MOShared::startSafeThread([this] {
+    run();
+  });
+}
+
+PluginOverrideIndex::~PluginOverrideIndex()
+{
+  {
+    std::scoped_lock lock(m_Mutex);
+    m_Stop = true;
+  }
+
+  m_Wake.notify_one();
+  m_Thread.join();
+}
+
+void PluginOverrideIndex::update(std::vector<Plugin> plugins)
+{
+  {
+    std::scoped_lock lock(m_Mutex);
+    m_Pending = std::move(plugins);
+    ++m_Generation;
+  }
+
+  m_Wake.notify_one();
+}
+
+void PluginOverrideIndex::clear()
+{
+  std::scoped_lock lock(m_Mutex);
+  m_Pending.reset();
+  m_Counts.clear();
+  ++m_Generation;
+}
+
+std::optional<PluginOverrideIndex::Counts>
+PluginOverrideIndex::counts(const QString& name) const
+{
+  std::scoped_lock lock(m_Mutex);
+
+  auto itor = m_Counts.find(name);
+  if (itor == m_Counts.end()) {
+    return {};
+  }
+
+  return itor->second;
+}
+
+void PluginOverrideIndex::run()
+{
+  for (;;) {
+    std::vector<Plugin> plugins;
+    int generation;
+
+    {
+      std::unique_lock lock(m_Mutex);
+      m_Wake.wait(lock, [&] {
+        return m_Stop || m_Pending.has_value();
+      });
+
+      if (m_Stop) {
+        return;
+      }
+
+      plugins    = std::move(*m_Pending);
+      generation = m_Generation;
+      m_Pending.reset();
+    }
+
+    index(plugins, generation);
+  }
+}
+
+void PluginOverrideIndex::scan(const Plugin& plugin, Scan& s)
+{
+  s.owners.clear();
+  s.formIds.clear();
+
+  try {
+    ESP::PluginReader reader(ToWString(plugin.path));
+    std::vector<uint8_t> buffer;
+
+    for (const auto& sub : reader.header().subRecords(buffer)) {
+      if (sub.type() == "MAST" && !sub.data().empty()) {
+        const auto* str = reinterpret_cast<const char*>(sub.data().data());
+        s.owners.append(
+            QString::fromLatin1(str, qstrnlen(str, sub.data().size())).toLower());
+      }
+    }
+
+    reader.forEachRecord([&](const ESP::RecordView& record) {
+      if (record.type() != "TES4") {
+        s.formIds.push_back(record.formId());
+      }
+    });
+  } catch (const std::exception& e) {
+    log::warn("failed to index records of '{}': {}", plugin.path, e.what());
+    s.owners.clear();
+    s.formIds.clear();
+  }
+
+  s.owners.append(plugin.name.toLower());
+}
+
+void PluginOverrideIndex::index(const std::vector<Plugin>& plugins, int generation)
+{
+  TimeThis tt("PluginOverrideIndex::index()");
+
+  // scan the plugins that changed since the last update
+  std::vector<std::pair<const Plugin*, Scan*>> changed;
+
+  for (const auto& plugin : plugins) {
+    const QFileInfo fi(plugin.path);
+    const qint64 size     = fi.size();
+    const qint64 modified = fi.lastModified().toMSecsSinceEpoch();
+
+    auto& s = m_Scans[plugin.path];
+    if (s.size != size || s.modified != modified) {
+      s.size     = size;
+      s.modified = modified;
+      changed.emplace_back(&plugin, &s);
+    }
+  }
+
+  // forget the plugins that are not active anymore, they are scanned again if
+  // they come back; erasing from the map keeps the other scans in place
+  std::set<QString> paths;
+  for (const auto& plugin : plugins) {
+    paths.insert(plugin.path);
+  }
+
+  std::erase_if(m_Scans, [&](auto&& entry) {
+    return !paths.contains(entry.first);
+  });
+
+  const auto doScan = [this](const std::pair<const Plugin*, Scan*>& p) {
+    // don't hold up shutdown with a large load order
+    {
+      std::scoped_lock lock(m_Mutex);
+      if (m_Stop) {
+        return;
+      }
+    }
+
+    scan(*p.first, *p.second);
+  };
+
+  const std::size_t threadCount = std::min(m_ThreadCount, changed.size());
+  if (threadCount > 1) {
+    MOShared::parallelMap(changed.begin(), changed.end(), doScan, threadCount);
+  } else {
+    std::for_each(changed.begin(), changed.end(), doScan);
+  }
+
+  // a record is identified by the plugin that defines it and its object id,
+  // plugins are given a small id to fit both in 64 bits
+  std::unordered_map<QString, uint64_t> ownerIds;
+  std::vector<std::pair<uint64_t, uint32_t>> records;
+  std::vector<Counts> counts(plugins.size());
+
+  for (std::size_t slot = 0; slot < plugins.size(); ++slot) {
+    const auto& s = m_Scans[plugins[slot].path];
+
+    std::vector<uint64_t> owners;
+    owners.reserve(s.owners.size());
+    for (const auto& owner : s.owners) {
+      owners.push_back(ownerIds.emplace(owner, ownerIds.size()).first->second);
+    }
+
+    const std::size_t self = owners.size() - 1;
+
+    for (uint32_t formId : s.formIds) {
+      // the top byte is an index in the masters, anything past the masters is
+      // a new record of the plugin itself
+      const std::size_t ownerIndex = std::min<std::size_t>(formId >> 24, self);
+
+      if (ownerIndex != self) {
+        ++counts[slot].overrides;
+      }
+
+      records.emplace_back((owners[ownerIndex] << 24) | (formId & 0xFFFFFF),
+                           static_cast<uint32_t>(slot));
+    }
+  }
+
+  // records are grouped by key in load order, every one except the last is
+  // overridden
+  std::sort(records.begin(), records.end());
+
+  for (std::size_t i = 0; i + 1 < records.size(); ++i) {
+    if (records[i].first == records[i + 1].first &&
+        records[i].second != records[i + 1].second) {
+      ++counts[records[i].second].overridden;
+    }
+  }
+
+  {
+    std::scoped_lock lock(m_Mutex);
+
+    // a newer update is pending, or the index was cleared, no point in
+    // publishing these
+    if (generation != m_Generation || m_Stop) {
+      return;
+    }
+
+    m_Counts.clear();
+    for (std::size_t slot = 0; slot < plugins.size(); ++slot) {
+      m_Counts[plugins[slot].name] = counts[slot];
+    }
+  }
+
+  log::debug("indexed {} records in {} plugins ({} scanned)", records.size(),
+             plugins.size(), changed.size());
+
+  emit updated();
+}
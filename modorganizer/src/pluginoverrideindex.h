@@ -0,0 +1,102 @@
+#ifndef PLUGINOVERRIDEINDEX_H
+#define PLUGINOVERRIDEINDEX_H
+
+#include <ifiletree.h>
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+// index of the records overridden by the active plugins (see PluginList)
+//
+// every plugin is scanned with esptk in a background thread, its form ids are
+// resolved through its masters and the records are then matched across the load
+// order; scans of the active plugins are kept between updates and only plugins
+// whose size or modification time changed are scanned again
+//
+class PluginOverrideIndex : public QObject
+{
+  Q_OBJECT
+
+public:
+  // an active plugin
+  //
+  struct Plugin
+  {
+    QString name;
+    QString path;
+  };
+
+  struct Counts
+  {
+    // number of records from masters that are overridden by this plugin
+    int overrides = 0;
+
+    // number of records of this plugin, new or overrides, that are overridden by
+    // a plugin loaded later
+    int overridden = 0;
+  };
+
+  PluginOverrideIndex(std::size_t threadCount);
+  ~PluginOverrideIndex();
+
+  // indexes the given plugins, in load order, in the background; replaces a
+  // pending update
+  //
+  void update(std::vector<Plugin> plugins);
+
+  // drops the index, any pending update is cancelled
+  //
+  void clear();
+
+  // returns the counts for the given plugin, or nothing if the plugin is not
+  // active or was not indexed yet
+  //
+  std::optional<Counts> counts(const QString& name) const;
+
+signals:
+  // emitted from the worker thread when an update has completed
+  //
+  void updated();
+
+private:
+  // records of a plugin, as stored in the file
+  //
+  struct Scan
+  {
+    qint64 size     = -1;
+    qint64 modified = -1;
+
+    // lowercase names of the masters, in order, followed by the plugin itself
+    QStringList owners;
+
+    std::vector<uint32_t> formIds;
+  };
+
+  std::size_t m_ThreadCount;
+
+  // only used by the worker thread
+  std::map<QString, Scan> m_Scans;
+
+  mutable std::mutex m_Mutex;
+  std::condition_variable m_Wake;
+  std::optional<std::vector<Plugin>> m_Pending;
+  int m_Generation;
+  std::map<QString, Counts, MOBase::FileNameComparator> m_Counts;
+  bool m_Stop;
+
+  std::thread m_Thread;
+
+  void run();
+  void index(const std::vector<Plugin>& plugins, int generation);
+  static void scan(const Plugin& plugin, Scan& s);
+};
+
+#endif  // PLUGINOVERRIDEINDEX_H
@@ -728,6 +728,68 @@ bool Profile::setModPriority(unsigned int index, int& newPriority)
   return true;
 }
 
+std::vector<std::pair<unsigned int, int>>
+Profile::moveMods(const std::vector<unsigned int>& indices, int newPriority)
+{
+  std::set<unsigned int> moving;
+  for (auto index : indices) {
+    if (index >= m_ModStatus.size()) {
+      log::error("invalid mod index: {}", index);
+      continue;
+    }
+
+    // can't change priority of overwrite/backups
+    if (!ModInfo::getByIndex(index)->hasAutomaticPriority()) {
+      moving.insert(index);
+    }
+  }
+
+  if (moving.empty()) {
+    return {};
+  }
+
+  const int numRegularMods = static_cast<int>(m_NumRegularMods);
+  newPriority              = std::clamp(newPriority, 0, numRegularMods);
+
+  // split the regular mods, which are the first ones by priority, into the
+  // ones before the target, the ones moving and the ones after the target
+  std::vector<unsigned int> before, moved, after;
+  for (const auto& [priority, index] : m_ModIndexByPriority) {
+    if (priority >= numRegularMods) {
+      break;
+    }
+
+    if (moving.contains(index)) {
+      moved.push_back(index);
+    } else if (priority < newPriority) {
+      before.push_back(index);
+    } else {
+      after.push_back(index);
+    }
+  }
+
+  std::vector<std::pair<unsigned int, int>> changed;
+  int priority = 0;
+
+  for (const auto* list : {&before, &moved, &after}) {
+    for (auto index : *list) {
+      auto& status = m_ModStatus[index];
+      if (status.m_Priority != priority) {
+        changed.emplace_back(index, status.m_Priority);
+        status.m_Priority = priority;
+      }
+      ++priority;
+    }
+  }
+
+  if (!changed.empty()) {
+    updateIndices();
+    m_ModListWriter.write();
+  }
+
+  return changed;
+}
+
 Profile* Profile::createPtrFrom(const QString& name, const Profile& reference,
                                 MOBase::IPluginGame const* gamePlugin)
 {
@@ -304,6 +304,20 @@ public:
   //
   bool setModPriority(unsigned int index, int& newPriority);
 
+  // move all the given mods right before the mod currently at the given
+  // priority, keeping their relative order, other mods are shifted to fill
+  // the gaps
+  //
+  // this gives the same result as moving the mods one by one, but the
+  // priorities are only renumbered once and the mod list is only written once,
+  // which matters when moving hundreds of mods
+  //
+  // the function returns the mods whose priority changed, with their old
+  // priority, including mods that were shifted
+  //
+  std::vector<std::pair<unsigned int, int>>
+  moveMods(const std::vector<unsigned int>& indices, int newPriority);
+
   /**
    * @brief determine if a mod is enabled
    *
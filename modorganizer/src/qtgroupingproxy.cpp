@@ -23,6 +23,9 @@
 #include <QIcon>
 #include <QInputDialog>
 
+#include <algorithm>
+#include <limits>
+
 using namespace MOBase;
 
 /*!
@@ -138,6 +141,16 @@ QList<RowData> QtGroupingProxy::belongsTo(const QModelIndex& idx)
   return rowDataList;
 }
 
+// the values of the grouped role that decide in which groups a row is placed
+static QVariantList groupKeys(const QList<RowData>& groupData)
+{
+  QVariantList keys;
+  for (const RowData& data : groupData) {
+    keys << data.value(0).value(Qt::DisplayRole);
+  }
+  return keys;
+}
+
 /* m_groupMap layout
  *  key : index of the group in m_groupMaps
  *  value : a QList of the original rows in sourceModel() for the children of this group
@@ -153,6 +166,7 @@ void QtGroupingProxy::buildTree()
   beginResetModel();
 
   m_groupMap.clear();
+  m_rowKeys.clear();
   // don't clear the data maps since most of it will probably be needed again.
   m_parentCreateList.clear();
 
@@ -198,14 +212,32 @@ void QtGroupingProxy::buildTree()
     }
   }
 
+  rebuildRowIndex();
+
   endResetModel();
 }
 
+void QtGroupingProxy::rebuildRowIndex()
+{
+  m_rowGroups.clear();
+
+  // m_groupMap is ordered by key, so the first group of a row is the one with the
+  // lowest key, which is what mapFromSource() uses for rows in multiple groups
+  for (auto iter = m_groupMap.constBegin(); iter != m_groupMap.constEnd(); ++iter) {
+    for (int sourceRow : iter.value()) {
+      m_rowGroups[sourceRow].append(iter.key());
+    }
+  }
+}
+
 QList<int> QtGroupingProxy::addSourceRow(const QModelIndex& idx)
 {
   QList<int> updatedGroups;
   QList<RowData> groupData = belongsTo(idx);
 
+  m_rowKeys.insert(std::clamp<qsizetype>(idx.row(), 0, m_rowKeys.size()),
+                   groupKeys(groupData));
+
   // an empty list here means it's supposed to go in root.
   if (groupData.isEmpty()) {
     updatedGroups << -1;
@@ -616,13 +648,9 @@ QModelIndex QtGroupingProxy::mapFromSource(const QModelIndex& idx) const
   } else {
     // idx is an item in the top level of the source model (child of the rootnode)
     int groupRow = -1;
-    QMapIterator<quint32, QList<int>> iterator(m_groupMap);
-    while (iterator.hasNext()) {
-      iterator.next();
-      if (iterator.value().contains(sourceRow)) {
-        groupRow = iterator.key();
-        break;
-      }
+    auto itor    = m_rowGroups.constFind(sourceRow);
+    if (itor != m_rowGroups.constEnd() && !itor->isEmpty()) {
+      groupRow = itor->first();
     }
 
     if (groupRow != -1)  // it's in a group, let's find the correct row.
@@ -811,6 +839,7 @@ void QtGroupingProxy::modelRowsInserted(const QModelIndex& parent, int start, in
     for (int modelRow = start; modelRow <= end; modelRow++) {
       addSourceRow(sourceModel()->index(modelRow, m_groupedColumn, m_rootNode));
     }
+    rebuildRowIndex();
   } else {
     // an item was added to an original index, remap and pass it on
     QModelIndex proxyParent = mapFromSource(parent);
@@ -889,6 +918,10 @@ void QtGroupingProxy::modelRowsRemoved(const QModelIndex& parent, int start, int
       }
     }
 
+    m_rowKeys.erase(m_rowKeys.begin() + std::min<qsizetype>(start, m_rowKeys.size()),
+                    m_rowKeys.begin() + std::min<qsizetype>(end + 1, m_rowKeys.size()));
+    rebuildRowIndex();
+
     return;
   }
 
@@ -904,8 +937,22 @@ void QtGroupingProxy::resetModel()
 void QtGroupingProxy::modelDataChanged(const QModelIndex& topLeft,
                                        const QModelIndex& bottomRight)
 {
-  // TODO: need to look in the groupedColumn and see if it changed and changed grouping
-  // accordingly
+  const bool topLevel = (topLeft.parent() == m_rootNode);
+
+  // only a change in the grouped column can move rows to other groups, in which
+  // case the tree has to be rebuilt; otherwise only the changed rows and the
+  // groups containing them are updated
+  if (topLevel && topLeft.column() <= m_groupedColumn &&
+      bottomRight.column() >= m_groupedColumn) {
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+      const QModelIndex idx = sourceModel()->index(row, m_groupedColumn, m_rootNode);
+      if (row >= m_rowKeys.size() || groupKeys(belongsTo(idx)) != m_rowKeys[row]) {
+        buildTree();
+        return;
+      }
+    }
+  }
+
   QModelIndex proxyTopLeft = mapFromSource(topLeft);
   if (!proxyTopLeft.isValid())
     return;
@@ -916,6 +963,25 @@ void QtGroupingProxy::modelDataChanged(const QModelIndex& topLeft,
     QModelIndex proxyBottomRight = mapFromSource(bottomRight);
     emit dataChanged(proxyTopLeft, proxyBottomRight);
   }
+
+  if (!topLevel) {
+    return;
+  }
+
+  // the data of a group is aggregated from its children
+  QSet<quint32> changedGroups;
+  for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+    for (quint32 group : m_rowGroups.value(row)) {
+      if (group != std::numeric_limits<quint32>::max()) {
+        changedGroups.insert(group);
+      }
+    }
+  }
+
+  const int lastColumn = columnCount(QModelIndex()) - 1;
+  for (quint32 group : changedGroups) {
+    emit dataChanged(index(group, 0), index(group, lastColumn));
+  }
 }
 
 bool QtGroupingProxy::isAGroupSelected(const QModelIndexList& list) const
@@ -20,6 +20,7 @@
 #define GROUPINGPROXY_H
 
 #include <QAbstractProxyModel>
+#include <QHash>
 #include <QIcon>
 #include <QModelIndex>
 #include <QMultiHash>
@@ -107,6 +108,10 @@ protected:
    */
   QList<int> addSourceRow(const QModelIndex& idx);
 
+  /** Rebuilds m_rowGroups from m_groupMap, this does not query the source model.
+   */
+  void rebuildRowIndex();
+
   bool isGroup(const QModelIndex& index) const;
   bool isAGroupSelected(const QModelIndexList& list) const;
 
@@ -121,6 +126,15 @@ protected:
    */
   QList<RowData> m_groupMaps;
 
+  /** The values of the grouped role for each top level source row, as returned by
+   * belongsTo(). Used to detect whether a data change requires regrouping.
+   */
+  QList<QVariantList> m_rowKeys;
+  /** Maps a top level source row to the keys of m_groupMap that contain it, the
+   * reverse of m_groupMap.
+   */
+  QHash<int, QList<quint32>> m_rowGroups;
+
   /** "instuctions" how to create an item in the tree.
    * This is used by parent( QModelIndex )
    */
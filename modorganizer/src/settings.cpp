@@ -364,6 +364,16 @@ void Settings::setArchiveParsing(bool b)
   set(m_Settings, "Settings", "archive_parsing_experimental", b);
 }
 
+bool Settings::pluginRecordIndexing() const
+{
+  return get<bool>(m_Settings, "Settings", "plugin_record_indexing", false);
+}
+
+void Settings::setPluginRecordIndexing(bool b)
+{
+  set(m_Settings, "Settings", "plugin_record_indexing", b);
+}
+
 std::vector<std::map<QString, QVariant>> Settings::executables() const
 {
   ScopedReadArray sra(m_Settings, "customExecutables");
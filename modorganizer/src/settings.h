@@ -811,6 +811,12 @@ public:
   bool archiveParsing() const;
   void setArchiveParsing(bool b);
 
+  // whether the records of active plugins should be indexed to show overrides
+  // in the plugin list
+  //
+  bool pluginRecordIndexing() const;
+  void setPluginRecordIndexing(bool b);
+
   // whether the user wants to check for updates
   //
   bool checkForUpdates() const;
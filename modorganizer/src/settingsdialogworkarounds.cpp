@@ -13,6 +13,7 @@ WorkaroundsSettingsTab::WorkaroundsSettingsTab(Settings& s, SettingsDialog& d)
   ui->forceEnableBox->setChecked(settings().game().forceEnableCoreFiles());
   ui->lockGUIBox->setChecked(settings().interface().lockGUI());
   ui->enableArchiveParsingBox->setChecked(settings().archiveParsing());
+  ui->enablePluginRecordIndexingBox->setChecked(settings().pluginRecordIndexing());
 
   // steam
   QString username, password;
@@ -60,6 +61,7 @@ void WorkaroundsSettingsTab::update()
   settings().game().setForceEnableCoreFiles(ui->forceEnableBox->isChecked());
   settings().interface().setLockGUI(ui->lockGUIBox->isChecked());
   settings().setArchiveParsing(ui->enableArchiveParsingBox->isChecked());
+  settings().setPluginRecordIndexing(ui->enablePluginRecordIndexingBox->isChecked());
 
   // steam
   if (ui->appIDEdit->text() != settings().game().plugin()->steamAPPId()) {
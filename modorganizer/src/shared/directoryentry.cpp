@@ -632,8 +632,8 @@ void DirectoryEntry::addFiles(env::DirectoryWalker& walker, FilesOrigin& origin,
 
   walker.forEachEntry(
       path, &cx,
-      [](void* pcx, std::wstring_view path) {
-        onDirectoryStart((Context*)pcx, path);
+      [](void* pcx, std::wstring_view path, FILETIME ft) {
+        onDirectoryStart((Context*)pcx, path, ft);
       },
 
       [](void* pcx, std::wstring_view path) {
@@ -645,9 +645,11 @@ void DirectoryEntry::addFiles(env::DirectoryWalker& walker, FilesOrigin& origin,
       });
 }
 
-void DirectoryEntry::onDirectoryStart(Context* cx, std::wstring_view path)
+void DirectoryEntry::onDirectoryStart(Context* cx, std::wstring_view path, FILETIME ft)
 {
   elapsed(cx->stats.dirTimes, [&] {
+    cx->origin.directoryModified(ft);
+
     auto* sd =
         cx->current.top()->getSubDirectory(path, true, cx->stats, cx->origin.getID());
 
@@ -263,7 +263,7 @@ private:
   void removeFilesFromList(const std::set<FileIndex>& indices);
 
   struct Context;
-  static void onDirectoryStart(Context* cx, std::wstring_view path);
+  static void onDirectoryStart(Context* cx, std::wstring_view path, FILETIME ft);
   static void onDirectoryEnd(Context* cx, std::wstring_view path);
   static void onFile(Context* cx, std::wstring_view path, FILETIME ft);
 
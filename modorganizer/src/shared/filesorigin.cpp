@@ -16,15 +16,17 @@ std::wstring tail(const std::wstring& source, const size_t count)
 }
 
 FilesOrigin::FilesOrigin()
-    : m_ID(0), m_Disabled(false), m_Name(), m_Path(), m_Priority(0)
+    : m_ID(0), m_Disabled(false), m_DirectoriesModified(0), m_Name(), m_Path(),
+      m_Priority(0)
 {}
 
 FilesOrigin::FilesOrigin(OriginID ID, const std::wstring& name,
                          const std::wstring& path, int priority,
                          boost::shared_ptr<MOShared::FileRegister> fileRegister,
                          boost::shared_ptr<MOShared::OriginConnection> originConnection)
-    : m_ID(ID), m_Disabled(false), m_Name(name), m_Path(path), m_Priority(priority),
-      m_FileRegister(fileRegister), m_OriginConnection(originConnection)
+    : m_ID(ID), m_Disabled(false), m_DirectoriesModified(0), m_Name(name),
+      m_Path(path), m_Priority(priority), m_FileRegister(fileRegister),
+      m_OriginConnection(originConnection)
 {}
 
 void FilesOrigin::setPriority(int priority)
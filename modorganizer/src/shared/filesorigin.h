@@ -34,6 +34,29 @@ public:
   const std::wstring& getPath() const { return m_Path; }
 
   std::vector<FileEntryPtr> getFiles() const;
+
+  std::size_t getFileCount() const
+  {
+    std::scoped_lock lock(m_Mutex);
+    return m_Files.size();
+  }
+
+  // most recent modification time of the subdirectories of this origin, as seen
+  // when its files were added to the structure; this is 0 if the origin has no
+  // subdirectories
+  uint64_t getDirectoriesModified() const
+  {
+    std::scoped_lock lock(m_Mutex);
+    return m_DirectoriesModified;
+  }
+
+  void directoryModified(FILETIME ft)
+  {
+    const uint64_t t = (uint64_t(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+
+    std::scoped_lock lock(m_Mutex);
+    m_DirectoriesModified = std::max(m_DirectoriesModified, t);
+  }
   FileEntryPtr findFile(FileIndex index) const;
 
   void enable(bool enabled, DirectoryStats& stats);
@@ -55,6 +78,7 @@ private:
   OriginID m_ID;
   bool m_Disabled;
   std::set<FileIndex> m_Files;
+  uint64_t m_DirectoriesModified;
   std::wstring m_Name;
   std::wstring m_Path;
   int m_Priority;
@@ -7,10 +7,21 @@
 using namespace MOShared;
 
 ViewMarkingScrollBar::ViewMarkingScrollBar(QTreeView* view, int role)
-    : QScrollBar(view), m_view(view), m_role(role)
+    : QScrollBar(view), m_view(view), m_role(role), m_rowCount(0), m_dirty(true)
 {
   // not implemented for horizontal sliders
   Q_ASSERT(this->orientation() == Qt::Vertical);
+
+  // the visible rows change when items are expanded or collapsed
+  connect(m_view, &QTreeView::expanded, this, &ViewMarkingScrollBar::invalidateMarkers);
+  connect(m_view, &QTreeView::collapsed, this,
+          &ViewMarkingScrollBar::invalidateMarkers);
+}
+
+void ViewMarkingScrollBar::invalidateMarkers()
+{
+  m_dirty = true;
+  update();
 }
 
 QColor ViewMarkingScrollBar::color(const QModelIndex& index) const
@@ -22,6 +33,50 @@ QColor ViewMarkingScrollBar::color(const QModelIndex& index) const
   return QColor();
 }
 
+void ViewMarkingScrollBar::updateModel()
+{
+  if (m_model == m_view->model()) {
+    return;
+  }
+
+  if (m_model) {
+    disconnect(m_model, nullptr, this, nullptr);
+  }
+
+  m_model = m_view->model();
+  m_dirty = true;
+
+  if (m_model) {
+    const auto invalidate = [this] {
+      invalidateMarkers();
+    };
+
+    connect(m_model, &QAbstractItemModel::dataChanged, this, invalidate);
+    connect(m_model, &QAbstractItemModel::layoutChanged, this, invalidate);
+    connect(m_model, &QAbstractItemModel::rowsInserted, this, invalidate);
+    connect(m_model, &QAbstractItemModel::rowsRemoved, this, invalidate);
+    connect(m_model, &QAbstractItemModel::rowsMoved, this, invalidate);
+    connect(m_model, &QAbstractItemModel::modelReset, this, invalidate);
+  }
+}
+
+void ViewMarkingScrollBar::updateMarkers()
+{
+  const auto indices = visibleIndex(m_view, 0);
+
+  m_markers.clear();
+  m_rowCount = static_cast<int>(indices.size());
+
+  for (int i = 0; i < indices.size(); ++i) {
+    QColor color = this->color(indices[i]);
+    if (color.isValid()) {
+      m_markers.emplace_back(i, color);
+    }
+  }
+
+  m_dirty = false;
+}
+
 void ViewMarkingScrollBar::paintEvent(QPaintEvent* event)
 {
   if (m_view->model() == nullptr) {
@@ -29,6 +84,17 @@ void ViewMarkingScrollBar::paintEvent(QPaintEvent* event)
   }
   QScrollBar::paintEvent(event);
 
+  // the markers are only computed again when something changed, scrolling only
+  // needs to draw them
+  updateModel();
+  if (m_dirty) {
+    updateMarkers();
+  }
+
+  if (m_markers.empty()) {
+    return;
+  }
+
   QStyleOptionSlider styleOption;
   initStyleOption(&styleOption);
 
@@ -39,18 +105,13 @@ void ViewMarkingScrollBar::paintEvent(QPaintEvent* event)
   QRect innerRect  = style()->subControlRect(QStyle::CC_ScrollBar, &styleOption,
                                              QStyle::SC_ScrollBarGroove, this);
 
-  auto indices = visibleIndex(m_view, 0);
-
   painter.translate(innerRect.topLeft() + QPoint(0, 3));
   qreal scale =
-      static_cast<qreal>(innerRect.height() - 3) / static_cast<qreal>(indices.size());
+      static_cast<qreal>(innerRect.height() - 3) / static_cast<qreal>(m_rowCount);
 
-  for (int i = 0; i < indices.size(); ++i) {
-    QColor color = this->color(indices[i]);
-    if (color.isValid()) {
-      painter.setPen(color);
-      painter.setBrush(color);
-      painter.drawRect(QRect(2, i * scale - 2, handleRect.width() - 5, 3));
-    }
+  for (const auto& [row, color] : m_markers) {
+    painter.setPen(color);
+    painter.setBrush(color);
+    painter.drawRect(QRect(2, row * scale - 2, handleRect.width() - 5, 3));
   }
 }
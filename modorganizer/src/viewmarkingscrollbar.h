@@ -1,14 +1,24 @@
 #ifndef VIEWMARKINGSCROLLBAR_H
 #define VIEWMARKINGSCROLLBAR_H
 
+#include <QPointer>
 #include <QScrollBar>
 #include <QTreeView>
 
+#include <utility>
+#include <vector>
+
 class ViewMarkingScrollBar : public QScrollBar
 {
 public:
   ViewMarkingScrollBar(QTreeView* view, int role);
 
+  // discard the cached markers, this is done automatically when the model or the
+  // expanded items change, but must be called when color() depends on some other
+  // state that changed
+  //
+  void invalidateMarkers();
+
 protected:
   void paintEvent(QPaintEvent* event) override;
 
@@ -17,8 +27,25 @@ protected:
   virtual QColor color(const QModelIndex& index) const;
 
 private:
+  // connect to the signals of the current model of the view, if it changed
+  //
+  void updateModel();
+
+  // retrieve the color of every visible row of the view and keep the ones with
+  // a marker
+  //
+  void updateMarkers();
+
   QTreeView* m_view;
   int m_role;
+
+  // model the markers were computed for
+  QPointer<QAbstractItemModel> m_model;
+
+  // visible row and color of each marker, and number of visible rows
+  std::vector<std::pair<int, QColor>> m_markers;
+  int m_rowCount;
+  bool m_dirty;
 };
 
 #endif  // VIEWMARKINGSCROLLBAR_H
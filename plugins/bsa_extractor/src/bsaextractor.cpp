@@ -57,13 +57,14 @@ QString BsaExtractor::description() const
 
 VersionInfo BsaExtractor::version() const
 {
-  return VersionInfo(1, 5, 0, VersionInfo::RELEASE_FINAL);
+  return VersionInfo(1, 6, 0, VersionInfo::RELEASE_FINAL);
 }
 
 QList<PluginSetting> BsaExtractor::settings() const
 {
   return {
-    PluginSetting("only_alternate_source", "only trigger bsa extraction for alternate game sources", true)
+    PluginSetting("only_alternate_source", "only trigger bsa extraction for alternate game sources", true),
+    PluginSetting("verify_archives", "check archives for damaged files before extracting them", false)
   };
 }
 
@@ -116,6 +117,27 @@ void BsaExtractor::modInstalledHandler(IModInterface *mod)
       progress.setValue(0);
       progress.show();
 
+      if (m_Organizer->pluginSetting(name(), "verify_archives").toBool()) {
+        std::vector<std::pair<std::string, BSA::EErrorCode>> problems;
+        BSA::EErrorCode verifyResult =
+            archive.verify(boost::bind(&BsaExtractor::extractProgress, this, boost::ref(progress), _1, _2),
+                           &problems);
+        if (verifyResult == BSA::ERROR_CANCELED) {
+          archive.close();
+          continue;
+        }
+        if (!problems.empty() &&
+            (QMessageBox::question(nullptr, tr("Damaged archive"),
+                                   tr("%1 contains %n damaged file(s), like %2.\n"
+                                      "Do you want to extract it anyway?", "", static_cast<int>(problems.size()))
+                                     .arg(archiveInfo.fileName())
+                                     .arg(QString::fromLocal8Bit(problems.front().first.c_str()))) != QMessageBox::Yes)) {
+          archive.close();
+          continue;
+        }
+        progress.setValue(0);
+      }
+
       archive.extractAll(mod->absolutePath().toLocal8Bit().constData(),
                          boost::bind(&BsaExtractor::extractProgress, this, boost::ref(progress), _1, _2),
                          false);
@@ -26,6 +26,7 @@
 #include <imodlist.h>
 #include <ipluginlist.h>
 #include <imodinterface.h>
+#include <bsaarchive.h>
 
 #include <QtPlugin>
 #include <QFile>
@@ -38,11 +39,14 @@
 #include <QProgressDialog>
 #include <QLabel>
 #include <QPushButton>
+#include <QThread>
 
 #include <regex>
 #include <functional>
 #include <vector>
 #include <algorithm>
+#include <mutex>
+#include <optional>
 
 #pragma warning( push, 2 )
 #include <boost/assign.hpp>
@@ -103,7 +107,7 @@ QString DiagnoseBasic::description() const
 
 VersionInfo DiagnoseBasic::version() const
 {
-  return VersionInfo(1, 1, 3, VersionInfo::RELEASE_FINAL);
+  return VersionInfo(1, 2, 0, VersionInfo::RELEASE_FINAL);
 }
 
 bool DiagnoseBasic::isActive() const
@@ -121,6 +125,7 @@ QList<PluginSetting> DiagnoseBasic::settings() const
       << PluginSetting("check_missingmasters", tr("Warn when there are esps with missing masters"), true)
       << PluginSetting("check_alternategames", tr("Warn when an installed mod came from an alternative game source"), false)
       << PluginSetting("check_fileattributes", tr("Warn when files have unwanted attributes"), false)
+      << PluginSetting("check_archives", tr("Warn when archives (bsa/ba2) are damaged. Every archive is decompressed once, which can take a while"), false)
       << PluginSetting("ow_ignore_empty", tr("Ignore empty directories when checking overwrite directory"), false)
       << PluginSetting("ow_ignore_log", tr("Ignore .log files and empty directories when checking overwrite directory"), false)
      ;
@@ -282,6 +287,80 @@ bool DiagnoseBasic::alternateGame() const
   return false;
 }
 
+QStringList DiagnoseBasic::verifyArchive(const QString &path) const
+{
+  BSA::Archive archive;
+  std::vector<std::pair<std::string, BSA::EErrorCode>> problems;
+  try {
+    BSA::EErrorCode result = archive.read(path.toLocal8Bit().constData(), false);
+    if ((result != BSA::ERROR_NONE) && (result != BSA::ERROR_INVALIDHASHES)) {
+      return QStringList(tr("failed to read the archive (error %1)").arg(result));
+    }
+    archive.verify([] (int, std::string) { return true; }, &problems);
+  } catch (const std::exception &e) {
+    return QStringList(tr("failed to read the archive: %1").arg(e.what()));
+  }
+
+  QStringList result;
+  for (const auto &problem : problems) {
+    const QString file = QString::fromLocal8Bit(problem.first.c_str());
+    if (problem.second == BSA::ERROR_INVALIDHASHES) {
+      result.append(tr("%1: the name doesn't match its hash").arg(file));
+    } else {
+      result.append(tr("%1: the data is damaged").arg(file));
+    }
+  }
+  return result;
+}
+
+bool DiagnoseBasic::damagedArchives() const
+{
+  QStringList archives = m_MOInfo->findFiles("",
+      [] (const QString &fileName) -> bool { return fileName.endsWith(".bsa", FileNameComparator::CaseSensitivity)
+                                                  || fileName.endsWith(".ba2", FileNameComparator::CaseSensitivity); });
+
+  // verifying takes minutes for a large game, the problems dialog calls this on the
+  // main thread where only the results of earlier checks are used
+  const bool verify = QThread::currentThread() != QCoreApplication::instance()->thread();
+
+  // checks running at the same time would verify the same archives, the later one
+  // waits and reuses the results of the first
+  std::unique_lock<std::mutex> verifyLock(m_VerifyMutex, std::defer_lock);
+  if (verify) {
+    verifyLock.lock();
+  }
+
+  std::map<QString, QStringList> damaged;
+  for (const QString &archive : archives) {
+    // verifying decompresses the whole archive, so only archives that changed since
+    // they were last checked are checked again
+    QFileInfo info(archive);
+    std::optional<QStringList> problems;
+    {
+      std::scoped_lock lock(m_ArchiveMutex);
+      auto iter = m_ArchiveChecks.find(archive);
+      if ((iter != m_ArchiveChecks.end()) && (iter->second.size == info.size())
+          && (iter->second.modified == info.lastModified())) {
+        problems = iter->second.problems;
+      }
+    }
+    if (!problems && verify) {
+      ArchiveCheck check { info.size(), info.lastModified(), verifyArchive(archive) };
+      problems = check.problems;
+
+      std::scoped_lock lock(m_ArchiveMutex);
+      m_ArchiveChecks.insert_or_assign(archive, std::move(check));
+    }
+    if (problems && !problems->isEmpty()) {
+      damaged[archive] = *problems;
+    }
+  }
+
+  std::scoped_lock lock(m_ArchiveMutex);
+  m_DamagedArchives = damaged;
+  return !m_DamagedArchives.empty();
+}
+
 bool DiagnoseBasic::invalidFontConfig() const
 {
   if ((m_MOInfo->managedGame()->gameName() != "Skyrim") && (m_MOInfo->managedGame()->gameShortName() != "SkyrimSE"))  {
@@ -594,6 +673,9 @@ std::vector<unsigned int> DiagnoseBasic::activeProblems() const
   if (m_MOInfo->pluginSetting(name(), "check_alternategames").toBool() && alternateGame()) {
     result.push_back(PROBLEM_ALTERNATE);
   }
+  if (m_MOInfo->pluginSetting(name(), "check_archives").toBool() && damagedArchives()) {
+    result.push_back(PROBLEM_DAMAGEDARCHIVES);
+  }
   if (QFile::exists(m_MOInfo->profilePath() + "/profile_tweaks.ini")) {
     result.push_back(PROBLEM_PROFILETWEAKS);
   }
@@ -618,6 +700,8 @@ QString DiagnoseBasic::shortDescription(unsigned int key) const
       return tr("Missing Masters");
     case PROBLEM_ALTERNATE:
       return tr("At least one unverified mod is using an alternative game source");
+    case PROBLEM_DAMAGEDARCHIVES:
+      return tr("Damaged archives");
     default:
       throw MyException(tr("invalid problem key %1").arg(key));
   }
@@ -676,6 +760,30 @@ QString DiagnoseBasic::fullDescription(unsigned int key) const
                 "Advice: Once you have verified the mod is working correctly, you can use the context menu<br>"
                 "and select \"Mark as converted/working\" to remove the flag and warning.");
     } break;
+    case PROBLEM_DAMAGEDARCHIVES: {
+      // long lists are cut short, the first problems are enough to tell what's wrong
+      static const int MAX_PROBLEMS = 10;
+      std::map<QString, QStringList> damaged;
+      {
+        std::scoped_lock lock(m_ArchiveMutex);
+        damaged = m_DamagedArchives;
+      }
+      QString archiveInfo;
+      for (const auto &archive : damaged) {
+        archiveInfo += "<li>" + QFileInfo(archive.first).fileName().toHtmlEscaped() + "<ul>";
+        for (const QString &problem : archive.second.mid(0, MAX_PROBLEMS)) {
+          archiveInfo += "<li>" + problem.toHtmlEscaped() + "</li>";
+        }
+        if (archive.second.size() > MAX_PROBLEMS) {
+          archiveInfo += "<li>" + tr("%n more", "", archive.second.size() - MAX_PROBLEMS) + "</li>";
+        }
+        archiveInfo += "</ul></li>";
+      }
+      return tr("Some archives (bsa/ba2) are damaged, the game may crash or show missing<br>"
+                "textures, meshes or sounds when it uses the affected files.<br><br>"
+                "Advice: Reinstall the mods the archives belong to or verify the game files.")
+             + "<ul>" + archiveInfo + "</ul>";
+    } break;
     default:
       throw MyException(tr("invalid problem key %1").arg(key));
   }
@@ -26,8 +26,11 @@ along with this plugin.  If not, see <http://www.gnu.org/licenses/>.
 #include <imoinfo.h>
 #include <imodlist.h>
 #include <QString>
+#include <QStringList>
+#include <QDateTime>
 #include <QSet>
 #include <QRegularExpression>
+#include <mutex>
 
 
 class DiagnoseBasic : public QObject, public MOBase::IPlugin, public MOBase::IPluginDiagnose
@@ -69,6 +72,8 @@ private:
   bool assetOrder() const;
   bool missingMasters() const;
   bool alternateGame() const;
+  bool damagedArchives() const;
+  QStringList verifyArchive(const QString &path) const;
   bool fileAttributes(const QString &executable) const;
 
 private:
@@ -80,6 +85,7 @@ private:
   static const unsigned int PROBLEM_PROFILETWEAKS = 7;
   static const unsigned int PROBLEM_MISSINGMASTERS = 8;
   static const unsigned int PROBLEM_ALTERNATE = 9;
+  static const unsigned int PROBLEM_DAMAGEDARCHIVES = 10;
 
   static const unsigned int NUM_CONTEXT_ROWS = 5;
 
@@ -87,6 +93,13 @@ private:
 
 private:
 
+  // result of verifying an archive, kept until the archive changes
+  struct ArchiveCheck {
+    qint64 size;
+    QDateTime modified;
+    QStringList problems;
+  };
+
   struct ListElement {
     QString espName;
     QString modName;
@@ -138,6 +151,11 @@ private:
   mutable QString m_NewestModlistBackup;
   mutable std::set<QString> m_MissingMasters;
   mutable std::map<QString, std::set<QString>> m_PluginChildren;
+  // activeProblems() is called from background threads and from the main thread
+  mutable std::mutex m_ArchiveMutex;
+  mutable std::mutex m_VerifyMutex;
+  mutable std::map<QString, ArchiveCheck> m_ArchiveChecks;
+  mutable std::map<QString, QStringList> m_DamagedArchives;
 
 };
 
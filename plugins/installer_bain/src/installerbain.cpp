@@ -163,30 +163,29 @@ bool InstallerBAIN::isArchiveSupported(std::shared_ptr<const IFileTree> tree) co
     return false;
   }
 
-  std::size_t numInvalidDirs = 0;
-  auto subpackages           = findSubpackages(tree, &numInvalidDirs);
-
-  if (subpackages.size() < 2) {
-    // a complex bain package contains at least 2 directories to choose from
-    return false;
-  } else if (numInvalidDirs == 0) {
-    return true;
-  } else {
-    return QMessageBox::question(parentWidget(), tr("May be BAIN installer"),
-                                 tr("This installer looks like it may contain a BAIN "
-                                    "installer but I'm not sure. "
-                                    "Install as BAIN installer?"),
-                                 QMessageBox::Yes | QMessageBox::No) ==
-           QMessageBox::Yes;
-  }
-
-  return true;
+  // a complex bain package contains at least 2 directories to choose from, the
+  // user is asked in install() if there are other directories
+  return findSubpackages(tree).size() >= 2;
 }
 
 IPluginInstaller::EInstallResult
 InstallerBAIN::install(GuessedValue<QString>& modName, std::shared_ptr<IFileTree>& tree,
                        QString&, int&)
 {
+  std::size_t numInvalidDirs = 0;
+  auto subpackages           = findSubpackages(tree, &numInvalidDirs);
+
+  // not asked in isArchiveSupported() since it runs concurrently with the checks of
+  // other installers, the next installer is used if the user says no
+  if (numInvalidDirs > 0 &&
+      QMessageBox::question(parentWidget(), tr("May be BAIN installer"),
+                            tr("This installer looks like it may contain a BAIN "
+                               "installer but I'm not sure. "
+                               "Install as BAIN installer?"),
+                            QMessageBox::Yes | QMessageBox::No) != QMessageBox::Yes) {
+    return IPluginInstaller::RESULT_NOTATTEMPTED;
+  }
+
   auto entry = tree->find("package.txt", FileTreeEntry::FILE);
 
   QString packageTXT;
@@ -194,8 +193,6 @@ InstallerBAIN::install(GuessedValue<QString>& modName, std::shared_ptr<IFileTree
     packageTXT = manager()->extractFile(entry);
   }
 
-  auto subpackages = findSubpackages(tree);
-
   BainComplexInstallerDialog dialog(subpackages, modName, m_PreviousOptions, packageTXT,
                                     parentWidget());
 
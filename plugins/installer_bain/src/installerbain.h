@@ -50,6 +50,7 @@ public:
                                  MOBase::IModInterface* newMod) override;
 
   virtual bool isArchiveSupported(std::shared_ptr<const MOBase::IFileTree> tree) const;
+  virtual bool supportsConcurrentChecks() const override { return true; }
   virtual EInstallResult install(MOBase::GuessedValue<QString>& modName,
                                  std::shared_ptr<MOBase::IFileTree>& tree,
                                  QString& version, int& modID);
@@ -66,6 +66,8 @@ public:
   virtual bool
   isArchiveSupported(std::shared_ptr<const MOBase::IFileTree> tree) const override;
 
+  virtual bool supportsConcurrentChecks() const override { return true; }
+
   virtual EInstallResult install(MOBase::GuessedValue<QString>& modName,
                                  std::shared_ptr<MOBase::IFileTree>& tree,
                                  QString& version, int& modID) override;
@@ -47,6 +47,8 @@ public:
 
   bool isArchiveSupported(std::shared_ptr<const MOBase::IFileTree> tree) const override;
 
+  bool supportsConcurrentChecks() const override { return true; }
+
   void setParentWidget(QWidget* parent) override;
 
   // IPluginInstallerCustom
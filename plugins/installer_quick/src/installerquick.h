@@ -29,6 +29,7 @@ public:
   virtual bool isManualInstaller() const override;
   virtual bool
   isArchiveSupported(std::shared_ptr<const MOBase::IFileTree> tree) const override;
+  virtual bool supportsConcurrentChecks() const override { return true; }
 
   // Simple installer functions:
   virtual EInstallResult install(MOBase::GuessedValue<QString>& modName,
@@ -219,19 +219,16 @@ class WizardInstaller(mobase.IPluginInstallerSimple):
         if not base:
             return False
 
-        # check FOMOD for priority
-        fomod = base.exists("fomod/ModuleConfig.xml")
-        if (
-            fomod
-            and self._hasFomodInstaller()
-            and self._organizer.pluginSetting(self.name(), "prefer_fomod")
-        ):
-            return False
+        # the FOMOD priority is checked in install() since it reads the settings
+        # and this can run outside of the main thread
 
         # TODO: Check OMOD?
 
         return True
 
+    def supportsConcurrentChecks(self) -> bool:
+        return True
+
     def install(
         self,
         name: mobase.GuessedString,
@@ -272,6 +269,15 @@ class WizardInstaller(mobase.IPluginInstallerSimple):
         if wizard is None:
             return mobase.InstallResult.NOT_ATTEMPTED
 
+        # check FOMOD for priority, the next installer is used
+        fomod = base.exists("fomod/ModuleConfig.xml")
+        if (
+            fomod
+            and self._hasFomodInstaller()
+            and self._organizer.pluginSetting(self.name(), "prefer_fomod")
+        ):
+            return mobase.InstallResult.NOT_ATTEMPTED
+
         to_extract = self._getEntriesToExtract(tree)
 
         # extract the script
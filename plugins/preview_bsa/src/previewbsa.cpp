@@ -21,11 +21,19 @@ along with Bsa Preview plugin.  If not, see <http://www.gnu.org/licenses/>.
 #include "previewbsa.h"
 #include "simplefiletreemodel.h"
 #include <QApplication>
+#include <QDir>
 #include <QFileInfo>
+#include <QHBoxLayout>
+#include <QImage>
 #include <QImageReader>
+#include <QItemSelectionModel>
 #include <QLabel>
 #include <QLineEdit>
+#include <QPixmap>
+#include <QProgressDialog>
+#include <QPushButton>
 #include <QScreen>
+#include <QSplitter>
 #include <QStandardItemModel>
 #include <QTextEdit>
 #include <QTreeView>
@@ -37,6 +45,10 @@ along with Bsa Preview plugin.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <log.h>
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 using namespace MOBase;
 
 PreviewBsa::PreviewBsa() : m_MOInfo(nullptr) {}
@@ -76,7 +88,7 @@ QString PreviewBsa::description() const
 
 MOBase::VersionInfo PreviewBsa::version() const
 {
-    return VersionInfo(1, 1, 0, VersionInfo::RELEASE_FINAL);
+    return VersionInfo(1, 3, 0, VersionInfo::RELEASE_FINAL);
 }
 
 QList<MOBase::PluginSetting> PreviewBsa::settings() const
@@ -108,13 +120,17 @@ QWidget* PreviewBsa::genFilePreview(const QString& fileName, const QSize& maxSiz
     }
 }
 
-void PreviewBsa::readFiles(const BSA::Folder::Ptr archiveFolder)
+void PreviewBsa::readFiles(const BSA::Folder::Ptr archiveFolder, FileMap& files)
 {
     const auto fileCount = archiveFolder->getNumFiles();
     for (unsigned int i = 0; i < fileCount; ++i) {
         const BSA::File::Ptr file = archiveFolder->getFile(i);
+        const QString path        = QString::fromStdString(file->getFilePath());
+
+        m_Files << path;
 
-        m_Files << QString::fromStdString(file->getFilePath());
+        // same as the paths in SimpleFileTreeModel
+        files[QDir::cleanPath(path)] = file;
     }
 
     // recurse into subdirectories
@@ -122,48 +138,171 @@ void PreviewBsa::readFiles(const BSA::Folder::Ptr archiveFolder)
     for (unsigned int i = 0; i < dirCount; ++i) {
         const BSA::Folder::Ptr folder = archiveFolder->getSubFolder(i);
 
-        readFiles(folder);
+        readFiles(folder, files);
+    }
+}
+
+QWidget* PreviewBsa::genContentPreview(const BSA::Archive& archive,
+                                       const BSA::File::Ptr& file,
+                                       const QSize& maxSize) const
+{
+    static const QStringList textExtensions = {"txt",  "ini",  "json", "xml", "psc",
+                                               "cfg",  "toml", "log",  "lst", "csv",
+                                               "yaml", "yml",  "htm",  "html"};
+
+    // the file is read straight from the archive, nothing is extracted to disk
+    std::vector<unsigned char> data;
+    const BSA::EErrorCode res = archive.readFile(file, data);
+    if (res != BSA::ERROR_NONE) {
+        log::error("failed to read '{}' from archive, error {}", file->getFilePath(),
+                   res);
+        return new QLabel(tr("Unable to read this file from the archive."));
+    }
+
+    const QByteArray bytes =
+        QByteArray::fromRawData(reinterpret_cast<const char*>(data.data()),
+                                static_cast<qsizetype>(data.size()));
+    const QString suffix =
+        QFileInfo(QString::fromStdString(file->getName())).suffix().toLower();
+
+    if (QImageReader::supportedImageFormats().contains(suffix.toLatin1())) {
+        const QImage image = QImage::fromData(bytes, suffix.toLatin1().constData());
+        if (!image.isNull()) {
+            QPixmap pixmap = QPixmap::fromImage(image);
+            if (pixmap.width() > maxSize.width() ||
+                pixmap.height() > maxSize.height()) {
+                pixmap = pixmap.scaled(maxSize, Qt::KeepAspectRatio,
+                                       Qt::SmoothTransformation);
+            }
+
+            QLabel* label = new QLabel();
+            label->setPixmap(pixmap);
+            label->setAlignment(Qt::AlignCenter);
+            return label;
+        }
+    } else if (textExtensions.contains(suffix)) {
+        QTextEdit* edit = new QTextEdit();
+        edit->setReadOnly(true);
+        edit->setPlainText(QString::fromUtf8(bytes));
+        return edit;
+    }
+
+    return new QLabel(tr("No preview available for this file."));
+}
+
+void PreviewBsa::verifyArchive(const BSA::Archive& archive, QLabel* resultLabel) const
+{
+    QProgressDialog progress(tr("Checking archive..."), tr("Cancel"), 0, 100,
+                             resultLabel->window());
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(0);
+
+    std::vector<std::pair<std::string, BSA::EErrorCode>> problems;
+    const BSA::EErrorCode res = archive.verify(
+        [&progress](int value, std::string fileName) {
+            progress.setLabelText(QString::fromStdString(fileName));
+            progress.setValue(value);
+            qApp->processEvents();
+            return !progress.wasCanceled();
+        },
+        &problems);
+
+    if (res == BSA::ERROR_CANCELED) {
+        resultLabel->setText(tr("Check canceled."));
+        return;
+    }
+
+    if (problems.empty()) {
+        resultLabel->setText(tr("No problems found."));
+        return;
+    }
+
+    // files are checked in parallel, sort them so the list reads like the tree
+    std::sort(problems.begin(), problems.end());
+
+    // a damaged archive can have thousands of broken files, the first ones are enough
+    static const size_t maxProblems = 20;
+
+    QStringList lines;
+    lines << tr("%n problem(s) found:", "", static_cast<int>(problems.size()));
+    for (size_t i = 0; i < problems.size() && i < maxProblems; ++i) {
+        const QString path = QString::fromStdString(problems[i].first);
+        if (problems[i].second == BSA::ERROR_INVALIDHASHES) {
+            lines << tr("%1: the name doesn't match its hash").arg(path);
+        } else {
+            lines << tr("%1: the data is damaged").arg(path);
+        }
+    }
+    if (problems.size() > maxProblems) {
+        lines << tr("...");
     }
+
+    resultLabel->setText(lines.join("\n"));
 }
 
-QWidget* PreviewBsa::genBsaPreview(const QString& fileName, const QSize&)
+QWidget* PreviewBsa::genBsaPreview(const QString& fileName, const QSize& maxSize)
 {
     m_Files.clear();
     QWidget* wrapper    = new QWidget();
     QVBoxLayout* layout = new QVBoxLayout();
 
     QLabel* infoLabel = new QLabel();
-    BSA::Archive arch;  // bs_archive_auto is easier to use, but is less performant when
-                        // working with memory
-    BSA::EErrorCode res = arch.read(fileName.toLocal8Bit().constData(), true);
+
+    // kept open as long as the preview is shown so files can be read from it
+    auto arch = std::make_shared<BSA::Archive>();
+    BSA::EErrorCode res = arch->read(fileName.toLocal8Bit().constData(), true);
     if ((res != BSA::ERROR_NONE) && (res != BSA::ERROR_INVALIDHASHES)) {
         log::error("invalid bsa '{}', error {}", fileName, res);
         infoLabel->setText("Unable to parse archive. Unrecognized format.");
-        arch.close();
+        arch->close();
         return wrapper;
     }
-    const BSA::Folder::Ptr archiveDir = arch.getRoot();
-    readFiles(archiveDir);
+    const BSA::Folder::Ptr archiveDir = arch->getRoot();
+    auto files                        = std::make_shared<FileMap>();
+    readFiles(archiveDir, *files);
     QString infoString =
         tr("Archive Format: %1 , Compression: %2 , File count: %3 , Version: %4 , "
            "Archive type: %5 , Archive flags: %6");
     // tr("Archive Format: %1 , Compression: %2 , File count: %3 , Version: %4 , "
     //    "Archive type: %5 , Archive flags: %6 , Contents flags: %7");
-    infoString = infoString.arg(getFormat(arch.getType()))
-                     .arg((arch.getFlags() & 0x00000004) ? tr("yes") : tr("no"))
+    infoString = infoString.arg(getFormat(arch->getType()))
+                     .arg((arch->getFlags() & 0x00000004) ? tr("yes") : tr("no"))
                      .arg(m_Files.size())
-                     .arg(getVersion(arch.getType()))
-                     .arg(arch.getType())
-                     .arg("0x" + QString::number(arch.getFlags(), 16));
+                     .arg(getVersion(arch->getType()))
+                     .arg(arch->getType())
+                     .arg("0x" + QString::number(arch->getFlags(), 16));
     //.arg("0x" + QString::number(arch.get_file_flags(), 16));
     infoLabel->setText(infoString);
     layout->addWidget(infoLabel);
 
+    // checking decompresses every file, so it's only done on request
+    QHBoxLayout* verifyLayout = new QHBoxLayout();
+    QPushButton* verifyButton = new QPushButton(tr("Check integrity"));
+    QLabel* verifyLabel       = new QLabel();
+    verifyLabel->setWordWrap(true);
+    verifyLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    verifyLayout->addWidget(verifyButton);
+    verifyLayout->addWidget(verifyLabel, 1);
+    layout->addLayout(verifyLayout);
+
+    QObject::connect(verifyButton, &QPushButton::clicked, verifyLabel,
+                     [this, arch, verifyLabel]() {
+                         verifyArchive(*arch, verifyLabel);
+                     });
+
     QTreeView* view            = new QTreeView();
     SimpleFileTreeModel* model = new SimpleFileTreeModel(m_Files);
 
+    QWidget* content           = new QWidget();
+    QVBoxLayout* contentLayout = new QVBoxLayout(content);
+    contentLayout->setContentsMargins(0, 0, 0, 0);
+
+    QSplitter* splitter = new QSplitter();
+    splitter->addWidget(view);
+    splitter->addWidget(content);
+
     view->setModel(model);
-    layout->addWidget(view);
+    layout->addWidget(splitter);
 
     QLineEdit* lineEdit = new QLineEdit();
     layout->addWidget(lineEdit);
@@ -174,8 +313,28 @@ QWidget* PreviewBsa::genBsaPreview(const QString& fileName, const QSize&)
     view->setSortingEnabled(true);
     view->sortByColumn(0, Qt::SortOrder::AscendingOrder);
 
+    // the filter replaces the model of the view, so this has to be connected after
+    QObject::connect(
+        view->selectionModel(), &QItemSelectionModel::currentChanged, content,
+        [this, arch, files, contentLayout, maxSize](const QModelIndex& current) {
+            while (QLayoutItem* item = contentLayout->takeAt(0)) {
+                delete item->widget();
+                delete item;
+            }
+
+            QStringList path;
+            for (QModelIndex index = current; index.isValid(); index = index.parent()) {
+                path.prepend(index.data().toString());
+            }
+
+            auto iter = files->find(path.join("/"));
+            if (iter != files->end()) {
+                contentLayout->addWidget(
+                    genContentPreview(*arch, iter->second, maxSize));
+            }
+        });
+
     wrapper->setLayout(layout);
-    arch.close();
     return wrapper;
 }
 
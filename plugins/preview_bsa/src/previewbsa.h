@@ -23,9 +23,12 @@ along with bsa Preview plugin.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <ipluginpreview.h>
 #include <functional>
+#include <map>
 
 #include <bsatk.h>
 
+class QLabel;
+
 class PreviewBsa : public MOBase::IPluginPreview
 {
 
@@ -52,8 +55,14 @@ public:
   virtual QWidget *genFilePreview(const QString &fileName, const QSize &maxSize) const;
 
 private:
-  void readFiles(const BSA::Folder::Ptr folder);
+  // files of the archive by their path in the tree
+  typedef std::map<QString, BSA::File::Ptr> FileMap;
+
+  void readFiles(const BSA::Folder::Ptr folder, FileMap &files);
   QWidget *genBsaPreview(const QString &fileName, const QSize &maxSize);
+  QWidget *genContentPreview(const BSA::Archive &archive, const BSA::File::Ptr &file,
+                             const QSize &maxSize) const;
+  void verifyArchive(const BSA::Archive &archive, QLabel *resultLabel) const;
   QString getFormat(ArchiveType type) const;
   BSAULong getVersion(ArchiveType type) const;
 
@@ -322,6 +322,8 @@ namespace mo2::python {
             .def("isLightFlagged", &IPluginList::isLightFlagged, "name"_a)
             .def("hasLightExtension", &IPluginList::hasLightExtension, "name"_a)
             .def("hasNoRecords", &IPluginList::hasNoRecords, "name"_a)
+            .def("overrideCount", &IPluginList::overrideCount, "name"_a)
+            .def("overriddenCount", &IPluginList::overriddenCount, "name"_a)
 
             // Kept but deprecated for backward compatibility:
             .def(
@@ -94,6 +94,8 @@ namespace mo2::python {
                    std::unique_ptr<IPluginInstaller, py::nodelete>>(
             m, "IPluginInstaller", py::multiple_inheritance())
             .def("isArchiveSupported", &IPluginInstaller::isArchiveSupported, "tree"_a)
+            .def("supportsConcurrentChecks",
+                 &IPluginInstaller::supportsConcurrentChecks)
             .def("priority", &IPluginInstaller::priority)
             .def("onInstallationStart", &IPluginInstaller::onInstallationStart,
                  "archive"_a, "reinstallation"_a, "current_mod"_a)
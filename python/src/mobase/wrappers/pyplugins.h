@@ -263,6 +263,11 @@ namespace mo2::python {
             PYBIND11_OVERRIDE_PURE(bool, PluginInstallerBase, isArchiveSupported, tree);
         }
 
+        bool supportsConcurrentChecks() const override
+        {
+            PYBIND11_OVERRIDE(bool, PluginInstallerBase, supportsConcurrentChecks, );
+        }
+
         // we need to bring these in public scope
         using PluginInstallerBase::manager;
         using PluginInstallerBase::parentWidget;
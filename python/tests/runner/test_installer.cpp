@@ -29,6 +29,7 @@ TEST(IPluginInstaller, Simple)
     // basic tests
     EXPECT_EQ(plugin->priority(), 10);
     EXPECT_EQ(plugin->isManualInstaller(), false);
+    EXPECT_EQ(plugin->supportsConcurrentChecks(), false);
 
     GuessedValue<QString> name{"default name"};
     QString version = "1.0.0";
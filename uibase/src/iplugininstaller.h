@@ -107,12 +107,26 @@ public:
    * @brief Test if the archive represented by the tree parameter can be installed
    * through this installer.
    *
+   * This is called on the main thread, unless supportsConcurrentChecks() returns true.
+   *
    * @param tree a directory tree representing the archive.
    *
    * @return true if this installer can handle the archive.
    */
   virtual bool isArchiveSupported(std::shared_ptr<const IFileTree> tree) const = 0;
 
+  /**
+   * @brief Check if isArchiveSupported() can be called from a thread other than the
+   * main one, concurrently with the checks of other installers.
+   *
+   * Installers that only read the tree can return true so large archives are checked
+   * faster. The user must not be asked anything from such a check.
+   *
+   * @return true if the check can run concurrently, the default implementation
+   * returns false.
+   */
+  virtual bool supportsConcurrentChecks() const { return false; }
+
   /**
    * @brief Sets the widget that the tool should use as the parent whenever
    *        it creates a new modal dialog.
@@ -220,6 +220,24 @@ public:
    * exist.
    */
   virtual bool hasNoRecords(const QString& name) const = 0;
+
+  /**
+   * @brief retrieve the number of records from masters overridden by a plugin
+   * @param name filename of the plugin (without path but with file extension)
+   * @return the number of overridden records, or -1 if the plugin is not active or
+   * the records of the plugins have not been indexed (yet)
+   * @note record indexing is optional and happens in the background
+   */
+  virtual int overrideCount(const QString& name) const = 0;
+
+  /**
+   * @brief retrieve the number of records of a plugin overridden by plugins loaded
+   * later
+   * @param name filename of the plugin (without path but with file extension)
+   * @return the number of records, or -1 if the plugin is not active or the records
+   * of the plugins have not been indexed (yet)
+   */
+  virtual int overriddenCount(const QString& name) const = 0;
 };
 
 }  // namespace MOBase